@@ -0,0 +1,258 @@
+#include "bench.hpp"
+#include "memory/memory.hpp"
+#include "utils/utils.hpp"
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <sys/resource.h>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+auto benches() -> std::vector<bench_case> & {
+  static auto registered = std::vector<bench_case>();
+  return registered;
+}
+
+auto counted_alloc(std::size_t size, std::size_t alignment) -> void * {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  size = size == 0 ? 1 : size;
+  auto *memory = alignment <= alignof(std::max_align_t)
+                     ? std::malloc(size)
+                     : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+// ru_maxrss only grows over the process, so per case the high water mark of /proc/self/status
+// is reset before the case and read after it, once the heap freed by earlier cases is handed back.
+// Returns false where Linux does not allow that. The reset lowers ru_maxrss as well.
+auto reset_peak_rss() -> bool {
+  ::malloc_trim(0);
+  auto clear_refs = std::ofstream("/proc/self/clear_refs");
+  clear_refs << "5" << std::flush;
+  return static_cast<bool>(clear_refs);
+}
+
+auto peak_rss_kb() -> uint64_t {
+  auto status = std::ifstream("/proc/self/status");
+  for (auto line = std::string(); std::getline(status, line);) {
+    if (line.starts_with("VmHWM:")) {
+      return std::stoull(line.substr(6));
+    }
+  }
+  struct rusage usage {};
+  ::getrusage(RUSAGE_SELF, &usage);
+  return static_cast<uint64_t>(usage.ru_maxrss);
+}
+
+struct options {
+  uint64_t min_bits = 3;
+  uint64_t max_bits = 16;
+  std::chrono::milliseconds min_time{200};
+  std::string filter;
+  std::string output;
+  table_policy policy = table_policy::huge_pages;
+  bool list = false;
+};
+
+auto parse_number(std::string_view flag, std::string_view text) -> uint64_t {
+  auto value = uint64_t();
+  auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end != text.data() + text.size()) {
+    throw std::invalid_argument("Invalid value for " + std::string(flag));
+  }
+  return value;
+}
+
+auto parse_options(int argc, char **argv) -> options {
+  auto opts = options();
+  for (auto i = 1; i < argc; i++) {
+    auto flag = std::string_view(argv[i]);
+    if (flag == "--list") {
+      opts.list = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Missing value for " + std::string(flag));
+    }
+    auto value = std::string_view(argv[++i]);
+    if (flag == "--min-bits") {
+      opts.min_bits = parse_number(flag, value);
+    }
+    else if (flag == "--max-bits") {
+      opts.max_bits = parse_number(flag, value);
+    }
+    else if (flag == "--min-time-ms") {
+      opts.min_time = std::chrono::milliseconds(parse_number(flag, value));
+    }
+    else if (flag == "--filter") {
+      opts.filter = value;
+    }
+    else if (flag == "--output") {
+      opts.output = value;
+    }
+    else if (flag == "--table-policy") {
+      if (value == table_policy_name(table_policy::heap)) {
+        opts.policy = table_policy::heap;
+      }
+      else if (value != table_policy_name(table_policy::huge_pages)) {
+        throw std::invalid_argument("Invalid value for " + std::string(flag));
+      }
+    }
+    else {
+      throw std::invalid_argument("Unknown option " + std::string(flag));
+    }
+  }
+  return opts;
+}
+
+} // namespace
+
+auto operator new(std::size_t size) -> void * { return counted_alloc(size, 0); }
+auto operator new[](std::size_t size) -> void * { return counted_alloc(size, 0); }
+auto operator new(std::size_t size, std::align_val_t alignment) -> void * {
+  return counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+auto operator new[](std::size_t size, std::align_val_t alignment) -> void * {
+  return counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+auto operator delete(void *memory) noexcept -> void { std::free(memory); }
+auto operator delete[](void *memory) noexcept -> void { std::free(memory); }
+auto operator delete(void *memory, std::size_t) noexcept -> void { std::free(memory); }
+auto operator delete[](void *memory, std::size_t) noexcept -> void { std::free(memory); }
+auto operator delete(void *memory, std::align_val_t) noexcept -> void { std::free(memory); }
+auto operator delete[](void *memory, std::align_val_t) noexcept -> void { std::free(memory); }
+auto operator delete(void *memory, std::size_t, std::align_val_t) noexcept -> void {
+  std::free(memory);
+}
+auto operator delete[](void *memory, std::size_t, std::align_val_t) noexcept -> void {
+  std::free(memory);
+}
+
+auto allocations_count() noexcept -> uint64_t {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+bench_state::bench_state(uint64_t bits_num, std::chrono::nanoseconds min_time)
+    : bits_num_(bits_num), min_time_(min_time) {}
+
+auto bench_state::bits_num() const noexcept -> uint64_t { return bits_num_; }
+
+auto bench_state::result() const -> const std::optional<bench_result> & { return result_; }
+
+auto bench_state::counters() const -> const std::vector<std::pair<std::string, double>> & {
+  return counters_;
+}
+
+auto bench_state::set_counter(std::string name, double value) -> void {
+  for (auto &[existing, stored] : counters_) {
+    if (existing == name) {
+      stored = value;
+      return;
+    }
+  }
+  counters_.emplace_back(std::move(name), value);
+}
+
+auto register_bench(bench_case bc) -> bool {
+  benches().push_back(std::move(bc));
+  return true;
+}
+
+// Runs every registered benchmark over the requested range of bits and prints one JSON
+// document, e.g. revsynth_bench --max-bits 12 --filter gate/ --output gate.json. Tables of at
+// least LARGE_TABLE_ROWS rows follow --table-policy, see memory/memory.hpp.
+auto main(int argc, char **argv) -> int {
+  auto opts = options();
+  try {
+    opts = parse_options(argc, argv);
+  }
+  catch (const std::exception &e) {
+    std::cerr << e.what() << "\nusage: revsynth_bench [--min-bits N] [--max-bits N] "
+                             "[--min-time-ms N] [--filter TEXT] [--output PATH] "
+                             "[--table-policy heap|huge_pages] [--list]\n";
+    return 2;
+  }
+
+  if (opts.list) {
+    for (const auto &bc : benches()) {
+      std::cout << bc.name << " " << bc.min_bits << ".." << bc.max_bits << "\n";
+    }
+    return 0;
+  }
+
+  set_table_policy(opts.policy);
+  auto run_peak_rss_kb = peak_rss_kb();
+  auto rss_per_case = reset_peak_rss();
+  auto json = std::ostringstream();
+  json << "{\n  \"context\": {\"compiler\": " << json_string(__VERSION__)
+       << ", \"table_policy\": " << json_string(table_policy_name(opts.policy))
+       << ", \"large_table_rows\": " << LARGE_TABLE_ROWS
+#ifdef NDEBUG
+       << ", \"assertions\": false"
+#else
+       << ", \"assertions\": true"
+#endif
+       << ", \"peak_rss_per_case\": " << (rss_per_case ? "true" : "false")
+       << "},\n  \"benchmarks\": [";
+  auto first = true;
+  for (const auto &bc : benches()) {
+    if (bc.name.find(opts.filter) == std::string::npos) {
+      continue;
+    }
+    for (auto bits = std::max(bc.min_bits, opts.min_bits);
+         bits <= std::min(bc.max_bits, opts.max_bits); bits++) {
+      auto state = bench_state(bits, opts.min_time);
+      rss_per_case = rss_per_case && reset_peak_rss();
+      bc.body(state);
+      if (!state.result()) {
+        continue;
+      }
+      const auto &r = *state.result();
+      auto ns_per_row = r.ns_per_iteration / static_cast<double>(r.rows_per_iteration);
+      json << (first ? "\n" : ",\n") << "    {\"name\": " << json_string(bc.name)
+           << ", \"bits\": " << bits << ", \"iterations\": " << r.iterations
+           << ", \"ns_per_iteration\": " << r.ns_per_iteration << ", \"ns_per_row\": " << ns_per_row
+           << ", \"rows_per_second\": " << 1e9 / ns_per_row
+           << ", \"allocations_per_iteration\": " << r.allocations_per_iteration;
+      auto case_peak_rss_kb = peak_rss_kb();
+      run_peak_rss_kb = std::max(run_peak_rss_kb, case_peak_rss_kb);
+      if (rss_per_case) {
+        json << ", \"peak_rss_kb\": " << case_peak_rss_kb;
+      }
+      for (const auto &[name, value] : state.counters()) {
+        json << ", " << json_string(name) << ": " << value;
+      }
+      json << "}";
+      first = false;
+      std::cerr << bc.name << " n=" << bits << " " << ns_per_row << " ns/row\n";
+    }
+  }
+  json << "\n  ],\n  \"peak_rss_kb\": " << std::max(run_peak_rss_kb, peak_rss_kb()) << "\n}\n";
+
+  if (opts.output.empty()) {
+    std::cout << json.str();
+  }
+  else {
+    auto out = std::ofstream(opts.output);
+    out << json.str();
+    if (!out) {
+      std::cerr << "Cannot write " << opts.output << "\n";
+      return 1;
+    }
+  }
+  return 0;
+}
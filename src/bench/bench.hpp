@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Number of global operator new calls so far, counted by the revsynth_bench executable.
+auto allocations_count() noexcept -> uint64_t;
+
+template <typename T> inline auto do_not_optimize(const T &value) -> void {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct bench_result {
+  uint64_t iterations;
+  uint64_t rows_per_iteration;
+  double ns_per_iteration;
+  double allocations_per_iteration;
+};
+
+class bench_state {
+  using clock = std::chrono::steady_clock;
+
+  uint64_t bits_num_;
+  std::chrono::nanoseconds min_time_;
+  std::optional<bench_result> result_;
+  std::vector<std::pair<std::string, double>> counters_;
+
+public:
+  bench_state(uint64_t bits_num, std::chrono::nanoseconds min_time);
+
+  [[nodiscard]] auto bits_num() const noexcept -> uint64_t;
+  [[nodiscard]] auto result() const -> const std::optional<bench_result> &;
+  [[nodiscard]] auto counters() const -> const std::vector<std::pair<std::string, double>> &;
+  // Extra per-case value reported next to the timings, e.g. the gate count of a circuit.
+  auto set_counter(std::string name, double value) -> void;
+
+  // Times iteration, which processes rows table rows, growing the repeat count until the run
+  // lasts at least min_time. A single run already longer than that is reported as it is.
+  template <typename F> auto run(uint64_t rows, F &&iteration) -> void {
+    auto iterations = 1UL;
+    while (true) {
+      auto allocations = allocations_count();
+      auto start = clock::now();
+      for (auto i = 0UL; i < iterations; i++) {
+        iteration();
+      }
+      auto elapsed = clock::now() - start;
+      allocations = allocations_count() - allocations;
+
+      if (elapsed >= min_time_) {
+        auto ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        auto runs = static_cast<double>(iterations);
+        result_ = {iterations, rows, ns / runs, static_cast<double>(allocations) / runs};
+        return;
+      }
+      auto ratio = static_cast<double>(min_time_.count()) /
+                   static_cast<double>(std::max<int64_t>(1, elapsed.count()));
+      iterations = static_cast<uint64_t>(static_cast<double>(iterations) *
+                                         std::clamp(ratio * 1.2, 2.0, 100.0));
+    }
+  }
+};
+
+struct bench_case {
+  std::string name;
+  uint64_t min_bits;
+  uint64_t max_bits;
+  std::function<void(bench_state &)> body;
+};
+
+auto register_bench(bench_case bc) -> bool;
+
+#define REVSYNTH_BENCH_CONCAT_(a, b) a##b
+#define REVSYNTH_BENCH_CONCAT(a, b) REVSYNTH_BENCH_CONCAT_(a, b)
+#define REVSYNTH_BENCH_IMPL(body, name, min_bits, max_bits)                                       \
+  static auto body(bench_state &state)->void;                                                      \
+  [[maybe_unused]] static const auto REVSYNTH_BENCH_CONCAT(body, _registered) =                    \
+      register_bench({name, min_bits, max_bits, body});                                            \
+  static auto body(bench_state &state)->void
+
+// Registers a benchmark run once for every bits_num in [min_bits, max_bits].
+#define REVSYNTH_BENCH(name, min_bits, max_bits)                                                   \
+  REVSYNTH_BENCH_IMPL(REVSYNTH_BENCH_CONCAT(revsynth_bench_, __LINE__), name, min_bits, max_bits)
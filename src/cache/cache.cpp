@@ -0,0 +1,282 @@
+#include "cache.hpp"
+#include "utils/utils.hpp"
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const auto STORE_MAGIC = std::string_view("RSCACHE1");
+const auto RECORD_HEADER_SIZE = sizeof(uint32_t);
+const auto FINGERPRINT_SIZE = 2 * sizeof(uint64_t);
+
+auto mix(uint64_t value) -> uint64_t {
+  value ^= value >> 33;
+  value *= 0xFF51AFD7ED558CCDUL;
+  value ^= value >> 33;
+  value *= 0xC4CEB9FE1A85EC53UL;
+  value ^= value >> 33;
+  return value;
+}
+
+auto io_error(const std::string &what) -> std::runtime_error {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+auto load_u32(const uint8_t *position) -> uint32_t {
+  auto value = uint32_t();
+  std::memcpy(&value, position, sizeof(value));
+  return value;
+}
+
+auto load_u64(const uint8_t *position) -> uint64_t {
+  auto value = uint64_t();
+  std::memcpy(&value, position, sizeof(value));
+  return value;
+}
+
+auto store_u64(std::vector<uint8_t> &buffer, uint64_t value) -> void {
+  auto bytes = std::bit_cast<std::array<uint8_t, sizeof(value)>>(value);
+  buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+}
+
+auto encode_record(const fingerprint &key, const circuit &circ) -> std::vector<uint8_t> {
+  auto record = std::vector<uint8_t>(RECORD_HEADER_SIZE);
+  store_u64(record, key.high);
+  store_u64(record, key.low);
+  write_varint(record, circ.bits_num());
+  write_varint(record, circ.gates_num());
+  for (const auto &g : circ.gates()) {
+    write_gate(record, g);
+  }
+  if (record.size() - RECORD_HEADER_SIZE > std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument("Circuit too large for a circuit store record");
+  }
+  auto payload_size = static_cast<uint32_t>(record.size() - RECORD_HEADER_SIZE);
+  std::memcpy(record.data(), &payload_size, sizeof(payload_size));
+  return record;
+}
+
+auto decode_record(const uint8_t *position, const uint8_t *end) -> circuit {
+  position += FINGERPRINT_SIZE;
+  auto bits_num = read_varint(position, end);
+  auto gates_num = read_varint(position, end);
+  auto gates = std::deque<gate>();
+  for (auto i = 0UL; i < gates_num; i++) {
+    gates.push_back(read_gate(position, end, bits_num));
+  }
+  return {bits_num, std::move(gates)};
+}
+
+auto write_all(int fd, const std::vector<uint8_t> &buffer, uint64_t offset) -> void {
+  auto written = 0UL;
+  while (written < buffer.size()) {
+    auto result = ::pwrite(fd, buffer.data() + written, buffer.size() - written,
+                           static_cast<off_t>(offset + written));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw io_error("Cannot append to circuit store");
+    }
+    written += static_cast<uint64_t>(result);
+  }
+}
+
+} // namespace
+
+auto fingerprint_hash::operator()(const fingerprint &fp) const noexcept -> std::size_t {
+  return fp.low ^ std::rotl(fp.high, 17);
+}
+
+auto fingerprint_of(const truth_table &tt, std::string_view mode) -> fingerprint {
+  auto high = 0x9E3779B97F4A7C15UL ^ tt.size();
+  auto low = 0xD6E8FEB86659FD93UL ^ mix(tt.size());
+  auto absorb = [&high, &low](uint64_t word) {
+    high = std::rotl(high ^ mix(word), 27) * 0x9FB21C651E98DF25UL;
+    low = std::rotl(low ^ mix(word ^ 0xA0761D6478BD642FUL), 31) * 0xE7037ED1A0B428DBUL;
+  };
+  for (auto row : tt.data()) {
+    absorb(row);
+  }
+  for (auto c : mode) {
+    absorb(static_cast<uint8_t>(c));
+  }
+  absorb(mode.size());
+  return {mix(high ^ low), mix(low + high)};
+}
+
+circuit_store::circuit_store(const std::filesystem::path &path)
+    : fd_(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)), map_(nullptr), map_size_(0),
+      file_size_(0) {
+  if (fd_ < 0) {
+    throw io_error("Cannot open circuit store " + path.string());
+  }
+  struct stat info {};
+  if (::fstat(fd_, &info) != 0) {
+    ::close(fd_);
+    throw io_error("Cannot stat circuit store " + path.string());
+  }
+  file_size_ = static_cast<uint64_t>(info.st_size);
+
+  try {
+    if (file_size_ == 0) {
+      write_all(fd_, std::vector<uint8_t>(STORE_MAGIC.begin(), STORE_MAGIC.end()), 0);
+      file_size_ = STORE_MAGIC.size();
+    }
+    remap();
+    if (map_size_ < STORE_MAGIC.size() ||
+        std::memcmp(map_, STORE_MAGIC.data(), STORE_MAGIC.size()) != 0) {
+      throw std::invalid_argument("File is not a circuit store: " + path.string());
+    }
+
+    auto offset = STORE_MAGIC.size();
+    while (offset + RECORD_HEADER_SIZE <= map_size_) {
+      auto payload_size = load_u32(map_ + offset);
+      auto record_end = offset + RECORD_HEADER_SIZE + payload_size;
+      if (payload_size < FINGERPRINT_SIZE || record_end > map_size_) {
+        break;
+      }
+      auto payload = map_ + offset + RECORD_HEADER_SIZE;
+      index_[{load_u64(payload), load_u64(payload + sizeof(uint64_t))}] = offset;
+      offset = record_end;
+    }
+    if (offset != file_size_ && ::ftruncate(fd_, static_cast<off_t>(offset)) != 0) {
+      throw io_error("Cannot truncate torn record of circuit store");
+    }
+    file_size_ = offset;
+  }
+  catch (...) {
+    unmap();
+    ::close(fd_);
+    throw;
+  }
+}
+
+circuit_store::~circuit_store() {
+  unmap();
+  ::close(fd_);
+}
+
+auto circuit_store::unmap() noexcept -> void {
+  if (map_ != nullptr) {
+    ::munmap(const_cast<uint8_t *>(map_), map_size_);
+  }
+  map_ = nullptr;
+  map_size_ = 0;
+}
+
+auto circuit_store::remap() -> void {
+  unmap();
+  auto mapped = ::mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    throw io_error("Cannot map circuit store");
+  }
+  map_ = static_cast<const uint8_t *>(mapped);
+  map_size_ = file_size_;
+}
+
+auto circuit_store::size() const noexcept -> uint64_t { return index_.size(); }
+
+auto circuit_store::find(const fingerprint &key) -> std::optional<circuit> {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return std::nullopt;
+  }
+  auto offset = it->second;
+  if (offset >= map_size_) {
+    remap();
+  }
+  auto payload_size = load_u32(map_ + offset);
+  auto payload = map_ + offset + RECORD_HEADER_SIZE;
+  return decode_record(payload, payload + payload_size);
+}
+
+auto circuit_store::insert(const fingerprint &key, const circuit &circ) -> void {
+  if (index_.contains(key)) {
+    return;
+  }
+  auto record = encode_record(key, circ);
+  write_all(fd_, record, file_size_);
+  index_[key] = file_size_;
+  file_size_ += record.size();
+}
+
+cached_synthesiser::cached_synthesiser(const synthesiser &inner, uint64_t capacity)
+    : inner_(inner), capacity_(capacity) {}
+
+cached_synthesiser::cached_synthesiser(const synthesiser &inner, uint64_t capacity,
+                                       const std::filesystem::path &store_path)
+    : inner_(inner), capacity_(capacity), store_(std::make_unique<circuit_store>(store_path)) {}
+
+auto cached_synthesiser::name() const -> std::string { return inner_.name(); }
+
+auto cached_synthesiser::stats() const -> cache_stats {
+  auto lock = std::lock_guard(mutex_);
+  return stats_;
+}
+
+auto cached_synthesiser::lookup(const fingerprint &key) const -> std::optional<circuit> {
+  auto lock = std::lock_guard(mutex_);
+  if (auto it = entries_.find(key); it != entries_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second);
+    stats_.memory_hits++;
+    return it->second->second;
+  }
+  if (store_ != nullptr) {
+    if (auto circ = store_->find(key)) {
+      stats_.disk_hits++;
+      insert_memory(key, *circ);
+      return circ;
+    }
+  }
+  stats_.misses++;
+  return std::nullopt;
+}
+
+auto cached_synthesiser::remember(const fingerprint &key, const circuit &circ) const -> void {
+  auto lock = std::lock_guard(mutex_);
+  if (store_ != nullptr) {
+    store_->insert(key, circ);
+  }
+  insert_memory(key, circ);
+}
+
+auto cached_synthesiser::insert_memory(const fingerprint &key, const circuit &circ) const
+    -> void {
+  if (capacity_ == 0 || entries_.contains(key)) {
+    return;
+  }
+  lru_.emplace_front(key, circ);
+  entries_[key] = lru_.begin();
+  if (lru_.size() > capacity_) {
+    entries_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+}
+
+auto cached_synthesiser::synthesize(truth_table target_tt) const -> circuit {
+  return synthesize(std::move(target_tt), synth_context());
+}
+
+auto cached_synthesiser::synthesize(truth_table target_tt, const synth_context &ctx) const
+    -> circuit {
+  auto key = fingerprint_of(target_tt, inner_.name());
+  if (auto circ = lookup(key)) {
+    return *circ;
+  }
+  auto circ = inner_.synthesize(std::move(target_tt), ctx);
+  // past the deadline engines may have finished in a cheaper mode, not an answer for the key
+  if (!ctx.expired()) {
+    remember(key, circ);
+  }
+  return circ;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "synthesisers/synthesiser.hpp"
+#include "truth_table/truth_table.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+struct fingerprint {
+  uint64_t high;
+  uint64_t low;
+
+  auto operator==(const fingerprint &rhs) const -> bool = default;
+};
+
+struct fingerprint_hash {
+  auto operator()(const fingerprint &fp) const noexcept -> std::size_t;
+};
+
+// 128-bit hash of the table rows together with the synthesiser name.
+auto fingerprint_of(const truth_table &tt, std::string_view mode) -> fingerprint;
+
+// Append-only file of synthesised circuits. Existing records are indexed through a read-only
+// memory map when the store is opened, new records are appended and indexed as they are written.
+// A torn record at the end of the file is cut off on open.
+class circuit_store {
+  int fd_;
+  const uint8_t *map_;
+  uint64_t map_size_;
+  uint64_t file_size_;
+  std::unordered_map<fingerprint, uint64_t, fingerprint_hash> index_;
+
+  auto remap() -> void;
+  auto unmap() noexcept -> void;
+
+public:
+  explicit circuit_store(const std::filesystem::path &path);
+  circuit_store(const circuit_store &) = delete;
+  auto operator=(const circuit_store &) -> circuit_store & = delete;
+  ~circuit_store();
+
+  [[nodiscard]] auto size() const noexcept -> uint64_t;
+  [[nodiscard]] auto find(const fingerprint &key) -> std::optional<circuit>;
+  // Throws std::invalid_argument for circuits whose record would not fit a 32 bit length.
+  auto insert(const fingerprint &key, const circuit &circ) -> void;
+};
+
+struct cache_stats {
+  uint64_t memory_hits = 0;
+  uint64_t disk_hits = 0;
+  uint64_t misses = 0;
+};
+
+// Serves repeated targets of any synthesiser from an in-memory LRU of capacity circuits,
+// backed by an optional circuit_store that survives restarts. Circuits finished after the
+// deadline of the synthesis context are returned but not kept.
+class cached_synthesiser : public synthesiser {
+  using entry = std::pair<fingerprint, circuit>;
+
+  const synthesiser &inner_;
+  uint64_t capacity_;
+  std::unique_ptr<circuit_store> store_;
+
+  mutable std::mutex mutex_;
+  mutable std::list<entry> lru_;
+  mutable std::unordered_map<fingerprint, std::list<entry>::iterator, fingerprint_hash> entries_;
+  mutable cache_stats stats_;
+
+  auto lookup(const fingerprint &key) const -> std::optional<circuit>;
+  auto remember(const fingerprint &key, const circuit &circ) const -> void;
+  auto insert_memory(const fingerprint &key, const circuit &circ) const -> void;
+
+public:
+  cached_synthesiser(const synthesiser &inner, uint64_t capacity);
+  cached_synthesiser(const synthesiser &inner, uint64_t capacity,
+                     const std::filesystem::path &store_path);
+
+  [[nodiscard]] auto name() const -> std::string;
+  [[nodiscard]] auto stats() const -> cache_stats;
+
+  using synthesiser::synthesize;
+  auto synthesize(truth_table target_tt) const -> circuit;
+  auto synthesize(truth_table target_tt, const synth_context &ctx) const -> circuit;
+};
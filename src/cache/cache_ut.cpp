@@ -0,0 +1,118 @@
+#include "cache.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include "synthesisers/mmd03_beam/mmd03_beam.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace cache_ut {
+const auto EPOCHS = 100;
+const auto max_bits = 8;
+std::mt19937_64 mrnd;
+
+auto store_path() -> std::filesystem::path {
+  auto path = std::filesystem::temp_directory_path() / "revsynth_cache_ut.rscache";
+  std::filesystem::remove(path);
+  return path;
+}
+} // namespace cache_ut
+
+using namespace cache_ut;
+
+TEST_CASE("fingerprint", "[cache], [fingerprint]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto tt = truth_table(bits).shuffle(mrnd);
+  auto other = tt;
+  REQUIRE(fingerprint_of(tt, "mmd03") == fingerprint_of(other, "mmd03"));
+  REQUIRE(fingerprint_of(tt, "mmd03") != fingerprint_of(tt, "mmd03_beam"));
+  other.swap(0, 1);
+  REQUIRE(fingerprint_of(tt, "mmd03") != fingerprint_of(other, "mmd03"));
+  REQUIRE(fingerprint_of(truth_table(bits), "") != fingerprint_of(truth_table(bits + 1), ""));
+}
+
+TEST_CASE("cached_synthesiser in memory", "[cache], [lru]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(4, max_bits))));
+
+  auto inner = mmd03();
+  auto tested = cached_synthesiser(inner, 2);
+  auto tt_1 = truth_table(bits).shuffle(mrnd);
+  auto tt_2 = truth_table(bits).shuffle(mrnd);
+  auto tt_3 = truth_table(bits).shuffle(mrnd);
+
+  REQUIRE(tested.synthesize(tt_1) == inner.synthesize(tt_1));
+  REQUIRE(tested.synthesize(tt_1) == inner.synthesize(tt_1));
+  REQUIRE(tested.stats().memory_hits == 1);
+  REQUIRE(tested.stats().misses == 1);
+
+  tested.synthesize(tt_2);
+  tested.synthesize(tt_1); // tt_2 is now least recently used
+  tested.synthesize(tt_3);
+  auto before = tested.stats();
+  tested.synthesize(tt_1);
+  REQUIRE(tested.stats().memory_hits == before.memory_hits + 1);
+  tested.synthesize(tt_2);
+  REQUIRE(tested.stats().misses == before.misses + 1);
+}
+
+TEST_CASE("cached_synthesiser skips results past the deadline", "[cache], [context]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(4, max_bits))));
+
+  auto path = store_path();
+  auto inner = mmd03_beam();
+  auto tt = truth_table(bits).shuffle(mrnd);
+  {
+    auto tested = cached_synthesiser(inner, 2, path);
+    auto expired = synth_context{.deadline = synth_context::clock::now()};
+    REQUIRE(tested.synthesize(tt, expired).output_tt() == tt);
+    auto kept = tested.synthesize(tt);
+    REQUIRE(tested.stats().misses == 2);
+    REQUIRE(tested.synthesize(tt) == kept);
+    REQUIRE(tested.stats().memory_hits == 1);
+  }
+  REQUIRE(circuit_store(path).size() == 1);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("cached_synthesiser on disk", "[cache], [store]") {
+  auto path = store_path();
+  auto inner = mmd03();
+  auto targets = std::vector<truth_table>();
+  for (auto i = 0UL; i < EPOCHS; i++) {
+    targets.push_back(truth_table(4 + mrnd() % (max_bits - 3)).shuffle(mrnd));
+  }
+
+  {
+    auto tested = cached_synthesiser(inner, 0, path);
+    for (auto &tt : targets) {
+      REQUIRE(tested.synthesize(tt).output_tt() == tt);
+    }
+  }
+
+  SECTION("reopened store serves every target") {
+    auto tested = cached_synthesiser(inner, 0, path);
+    for (auto &tt : targets) {
+      REQUIRE(tested.synthesize(tt) == inner.synthesize(tt));
+    }
+    REQUIRE(tested.stats().misses == 0);
+  }
+
+  SECTION("torn record is cut off") {
+    auto full_size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, full_size - 1);
+    auto store = circuit_store(path);
+    REQUIRE(store.size() == targets.size() - 1);
+    REQUIRE_FALSE(store.find(fingerprint_of(targets.back(), inner.name())).has_value());
+    store.insert(fingerprint_of(targets.back(), inner.name()), inner.synthesize(targets.back()));
+    REQUIRE(store.find(fingerprint_of(targets.back(), inner.name())) ==
+            inner.synthesize(targets.back()));
+  }
+
+  SECTION("foreign file is rejected") {
+    std::ofstream(path) << "not a store";
+    REQUIRE_THROWS_AS(circuit_store(path), std::invalid_argument);
+  }
+  std::filesystem::remove(path);
+}
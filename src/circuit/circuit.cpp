@@ -1,13 +1,77 @@
 #include "circuit.hpp"
+#include "instrument/instrument.hpp"
+#include "small_perm/small_perm.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
 circuit::circuit(uint64_t bits_num)
     : output_tt_(truth_table(bits_num)), bits_num_(bits_num){};
 
-circuit::circuit(uint64_t bits_num, uint64_t gates_num, std::mt19937_64 mrnd)
-    : output_tt_(truth_table(bits_num)), bits_num_(bits_num) {
+namespace {
+
+template <typename Rng>
+auto random_gates(uint64_t bits_num, uint64_t gates_num, Rng &rng) -> std::deque<gate> {
+  auto gates = std::deque<gate>();
   for (auto i = 0UL; i < gates_num; i++) {
-    push_back(gate(bits_num_, mrnd));
+    gates.emplace_back(bits_num, rng);
+  }
+  return gates;
+}
+
+// States old_gate and new_gate take to different states. Both leave the states their controls do
+// not match alone, so only those matching either gate are tried.
+auto moved_states(uint64_t all_mask, const gate &old_gate, const gate &new_gate)
+    -> std::vector<uint64_t> {
+  auto states = std::vector<uint64_t>();
+  for (const auto *g : {&old_gate, &new_gate}) {
+    auto free_mask = all_mask & ~g->control_mask();
+    auto subset = 0UL;
+    do {
+      auto s = g->polarity_mask() | subset;
+      auto seen = g == &new_gate && (s & old_gate.control_mask()) == old_gate.polarity_mask();
+      if (!seen && old_gate.apply(s) != new_gate.apply(s)) {
+        states.push_back(s);
+      }
+      subset = (subset - free_mask) & free_mask;
+    } while (subset != 0);
   }
+  return states;
+}
+
+} // namespace
+
+circuit::circuit(uint64_t bits_num, uint64_t gates_num, std::mt19937_64 &mrnd)
+    : circuit(bits_num, random_gates(bits_num, gates_num, mrnd)) {}
+
+circuit::circuit(uint64_t bits_num, uint64_t gates_num, xoshiro256ss &rng)
+    : circuit(bits_num, random_gates(bits_num, gates_num, rng)) {}
+
+circuit::circuit(uint64_t bits_num, std::deque<gate> gates)
+    : gates_(std::move(gates)), output_tt_(truth_table(bits_num)), bits_num_(bits_num) {
+  recount();
+  auto toffoli_only = std::all_of(gates_.begin(), gates_.end(),
+                                  [](const gate &g) { return g.kind() == gate_kind::toffoli; });
+  if (bits_num_ <= small_perm::MAX_BITS && toffoli_only) {
+    auto perm = small_perm(bits_num_);
+    for (const auto &g : gates_) {
+      assert(g.size() == bits_num_);
+      perm.apply_back(g.control_mask(), g.target(), g.polarity_mask());
+    }
+    output_tt_ = perm.to_table();
+  }
+  else {
+    apply_gates_back(gates_, output_tt_);
+  }
+  REVSYNTH_COUNT(circuit_gates_pushed, gates_.size());
+}
+
+circuit::circuit(uint64_t bits_num, std::deque<gate> gates, truth_table output_tt)
+    : gates_(std::move(gates)), output_tt_(std::move(output_tt)), bits_num_(bits_num) {
+  assert(output_tt_.size() == bits_num_);
+  recount();
+  REVSYNTH_COUNT(circuit_gates_pushed, gates_.size());
 }
 
 auto circuit::bits_num() const -> uint64_t { return bits_num_; }
@@ -16,11 +80,15 @@ auto circuit::gates_num() const -> uint64_t { return gates_.size(); }
 
 auto circuit::gates() const -> const std::deque<gate> & { return gates_; }
 
-auto circuit::controls_num() const -> uint64_t {
-  auto acc_lambda = [](auto sum, auto gate) {
-    return sum + gate.controls_num();
-  };
-  return std::accumulate(gates_.begin(), gates_.end(), 0UL, acc_lambda);
+auto circuit::controls_num() const -> uint64_t { return cost_.totals().controls; }
+
+auto circuit::quantum_cost() const noexcept -> uint64_t { return cost_.totals().quantum_cost; }
+
+auto circuit::cost() const noexcept -> cost_vector { return cost_.totals(); }
+
+auto circuit::controls_histogram() const noexcept
+    -> const std::array<uint64_t, state::MAX_SIZE> & {
+  return cost_.histogram();
 }
 
 auto circuit::output_tt() const -> const truth_table & { return output_tt_; }
@@ -45,21 +113,35 @@ auto circuit::apply_front(truth_table &tt) const -> void {
 auto circuit::push_back(gate new_gate) -> circuit & {
   assert(new_gate.bits_num() == bits_num_);
   gates_.push_back(new_gate);
+  cost_.add(new_gate);
   new_gate.apply_back(output_tt_);
+  REVSYNTH_COUNT(circuit_gates_pushed, 1);
+  record({journal_entry::kind::push_back, 0, std::nullopt, {}});
   return *this;
 }
 
 auto circuit::push_front(gate new_gate) -> circuit & {
   assert(new_gate.bits_num() == bits_num_);
   gates_.push_front(new_gate);
+  cost_.add(new_gate);
   new_gate.apply_front(output_tt_);
+  REVSYNTH_COUNT(circuit_gates_pushed, 1);
+  record({journal_entry::kind::push_front, 0, std::nullopt, {}});
   return *this;
 }
 
 auto circuit::push_back(const circuit &new_circuit) -> circuit & {
-  for (auto gate : new_circuit.gates()) {
-    push_back(gate);
+  assert(new_circuit.bits_num_ == bits_num_);
+  if (&new_circuit == this) {
+    return push_back(circuit(new_circuit));
   }
+  for (const auto &g : new_circuit.gates_) {
+    gates_.push_back(g);
+    cost_.add(g);
+    record({journal_entry::kind::push_back, 0, std::nullopt, {}});
+  }
+  output_tt_ += new_circuit.output_tt_;
+  REVSYNTH_COUNT(circuit_gates_pushed, new_circuit.gates_.size());
   return *this;
 }
 
@@ -70,6 +152,197 @@ auto circuit::push_front(const circuit &new_circuit) -> circuit & {
   return *this;
 }
 
+auto circuit::replace_gates(std::deque<gate> equivalent_gates) -> circuit & {
+  std::swap(gates_, equivalent_gates);
+  recount();
+  record({journal_entry::kind::replace_gates, 0, std::nullopt, std::move(equivalent_gates)});
+  return *this;
+}
+
+auto circuit::remove_back() -> gate {
+  if (gates_.empty()) {
+    throw std::out_of_range("Cannot pop gate from empty circuit");
+  }
+  auto removed = gates_.back();
+  gates_.pop_back();
+  cost_.remove(removed);
+  if (removed.is_self_inverse()) {
+    removed.apply_back(output_tt_);
+  }
+  else {
+    removed.inverse().apply_back(output_tt_);
+  }
+  REVSYNTH_COUNT(circuit_gates_popped, 1);
+  return removed;
+}
+
+auto circuit::remove_front() -> gate {
+  if (gates_.empty()) {
+    throw std::out_of_range("Cannot pop gate from empty circuit");
+  }
+  auto removed = gates_.front();
+  gates_.pop_front();
+  cost_.remove(removed);
+  if (removed.is_self_inverse()) {
+    removed.apply_front(output_tt_);
+  }
+  else {
+    removed.inverse().apply_front(output_tt_);
+  }
+  REVSYNTH_COUNT(circuit_gates_popped, 1);
+  return removed;
+}
+
+auto circuit::swap_gate(uint64_t index, const gate &new_gate) -> gate {
+  if (index >= gates_.size()) {
+    throw std::out_of_range("Gate index out of range");
+  }
+  assert(new_gate.size() == bits_num_);
+  auto old_gate = gates_[index];
+  if (old_gate == new_gate) {
+    return old_gate;
+  }
+
+  // With the circuit split as S * old * P only the states after P that old and new take apart
+  // move. The new function is output * P^-1 * old^-1 * new * P, rows found by walking those
+  // states back through P, or S * new * old^-1 * S^-1 * output, values found by walking them
+  // forward through S and replaced in one pass over the table. The cheaper way is taken.
+  auto states = moved_states(output_tt_.length() - 1, old_gate, new_gate);
+  auto after = gates_.size() - index - 1;
+  if (states.size() * index <= states.size() * after + output_tt_.length()) {
+    auto row_of = std::unordered_map<uint64_t, uint64_t>(states.size());
+    for (auto s : states) {
+      auto row = s;
+      for (auto i = index; i > 0; i--) {
+        row = gates_[i - 1].apply_inverse(row);
+      }
+      row_of.emplace(s, row);
+    }
+    auto moved = std::vector<std::pair<uint64_t, uint64_t>>();
+    for (auto s : states) {
+      auto from = row_of.at(old_gate.apply_inverse(new_gate.apply(s)));
+      moved.emplace_back(row_of.at(s), output_tt_[from]);
+    }
+    for (auto [row, value] : moved) {
+      output_tt_[row] = value;
+    }
+    REVSYNTH_COUNT(gate_rows_touched, states.size() * index);
+  }
+  else {
+    auto value_of = std::unordered_map<uint64_t, uint64_t>(states.size());
+    for (auto s : states) {
+      auto value = old_gate.apply(s);
+      for (auto i = index + 1; i < gates_.size(); i++) {
+        value = gates_[i].apply(value);
+      }
+      value_of.emplace(old_gate.apply(s), value);
+    }
+    auto new_value_of = std::unordered_map<uint64_t, uint64_t>(states.size());
+    for (auto s : states) {
+      new_value_of.emplace(value_of.at(old_gate.apply(s)), value_of.at(new_gate.apply(s)));
+    }
+    for (auto &value : output_tt_) {
+      if (auto it = new_value_of.find(value); it != new_value_of.end()) {
+        value = it->second;
+      }
+    }
+    REVSYNTH_COUNT(gate_rows_touched, states.size() * after);
+  }
+  gates_[index] = new_gate;
+  cost_.remove(old_gate);
+  cost_.add(new_gate);
+  return old_gate;
+}
+
+auto circuit::pop_back() -> gate {
+  auto removed = remove_back();
+  record({journal_entry::kind::pop_back, 0, removed, {}});
+  return removed;
+}
+
+auto circuit::pop_front() -> gate {
+  auto removed = remove_front();
+  record({journal_entry::kind::pop_front, 0, removed, {}});
+  return removed;
+}
+
+auto circuit::replace(uint64_t index, gate new_gate) -> gate {
+  auto old_gate = swap_gate(index, new_gate);
+  record({journal_entry::kind::replace, index, old_gate, {}});
+  return old_gate;
+}
+
+auto circuit::recount() -> void {
+  cost_.clear();
+  for (const auto &g : gates_) {
+    cost_.add(g);
+  }
+}
+
+auto circuit::record(journal_entry entry) -> void {
+  if (!checkpoints_.empty()) {
+    journal_.push_back(std::move(entry));
+  }
+}
+
+auto circuit::undo(journal_entry &entry) -> void {
+  switch (entry.op) {
+  case journal_entry::kind::push_back:
+    remove_back();
+    break;
+  case journal_entry::kind::push_front:
+    remove_front();
+    break;
+  case journal_entry::kind::pop_back:
+    gates_.push_back(*entry.removed);
+    cost_.add(*entry.removed);
+    entry.removed->apply_back(output_tt_);
+    break;
+  case journal_entry::kind::pop_front:
+    gates_.push_front(*entry.removed);
+    cost_.add(*entry.removed);
+    entry.removed->apply_front(output_tt_);
+    break;
+  case journal_entry::kind::replace:
+    swap_gate(entry.index, *entry.removed);
+    break;
+  case journal_entry::kind::replace_gates:
+    gates_ = std::move(entry.removed_gates);
+    recount();
+    break;
+  }
+}
+
+auto circuit::checkpoint() -> void { checkpoints_.push_back(journal_.size()); }
+
+auto circuit::rollback() -> void {
+  if (checkpoints_.empty()) {
+    throw std::logic_error("No checkpoint to roll back to");
+  }
+  auto mark = checkpoints_.back();
+  checkpoints_.pop_back();
+  while (journal_.size() > mark) {
+    undo(journal_.back());
+    journal_.pop_back();
+  }
+}
+
+auto circuit::commit() -> void {
+  if (checkpoints_.empty()) {
+    throw std::logic_error("No checkpoint to commit");
+  }
+  checkpoints_.pop_back();
+  if (checkpoints_.empty()) {
+    journal_.clear();
+  }
+}
+
+auto circuit::checkpoints_num() const noexcept -> uint64_t { return checkpoints_.size(); }
+
+auto circuit::operator==(const circuit &rhs) const -> bool {
+  return bits_num_ == rhs.bits_num_ && gates_ == rhs.gates_ && output_tt_ == rhs.output_tt_;
+}
+
 auto circuit::operator[](uint64_t index) const -> gate { return gates_[index]; }
 
 template <typename T> auto circuit::operator+=(const T &rhs) -> circuit & {
@@ -97,13 +370,13 @@ auto circuit::graph() -> void {
     std::cout << i << ": ";
     for (auto j = 0UL; j < gates_num(); j++) {
       auto current_gate = (*this)[j];
-      auto controls = current_gate.controls();
-      auto target = current_gate.target();
-      auto is_control =
-          std::find(controls.begin(), controls.end(), i) != controls.end();
-      auto is_target = i == target;
+      auto line_mask = 1UL << i;
+      auto is_control = (current_gate.control_mask() & line_mask) != 0;
+      auto is_negative = (current_gate.polarity_mask() & line_mask) == 0;
+      auto is_target =
+          ((current_gate.target_mask() | current_gate.second_target_mask()) & line_mask) != 0;
       if (is_control) {
-        std::cout << "O";
+        std::cout << (is_negative ? "o" : "O");
       }
       else if (is_target) {
         std::cout << "X";
@@ -1,23 +1,66 @@
 #pragma once
+#include "cost/cost.hpp"
 #include "gate/gate.hpp"
 #include <cassert>
 #include <cstdint>
 #include <deque>
+#include <optional>
 #include <random>
+#include <vector>
 
 class circuit {
+  // Undo record of a single edit made while a checkpoint is open.
+  struct journal_entry {
+    enum class kind { push_back, push_front, pop_back, pop_front, replace, replace_gates };
+    kind op;
+    uint64_t index;
+    std::optional<gate> removed;
+    std::deque<gate> removed_gates;
+  };
+
   std::deque<gate> gates_;
+  cost_tracker cost_;
   truth_table output_tt_;
   uint64_t bits_num_;
+  std::vector<journal_entry> journal_;
+  std::vector<uint64_t> checkpoints_;
+
+  auto record(journal_entry entry) -> void;
+  auto undo(journal_entry &entry) -> void;
+  auto remove_back() -> gate;
+  auto remove_front() -> gate;
+  auto swap_gate(uint64_t index, const gate &new_gate) -> gate;
+  auto recount() -> void;
+
+  // Trusted shortcuts that take output_tt as the function of the gates without simulating them,
+  // so only engines that guarantee it and test their results may use them.
+  friend class peephole;
+  friend class window_resynthesis;
+  friend class delta_resynth;
+  // Takes output_tt as the function of gates, e.g. the table they were synthesised for.
+  circuit(uint64_t bits_num, std::deque<gate> gates, truth_table output_tt);
+  // Swaps in a gate sequence implementing the same function, keeping output_tt as it is.
+  auto replace_gates(std::deque<gate> equivalent_gates) -> circuit &;
 
 public:
   circuit(uint64_t bits_num);
-  circuit(uint64_t bits_num, uint64_t gates_num, std::mt19937_64);
+  // gates_num random gates, see gate(size, rng).
+  circuit(uint64_t bits_num, uint64_t gates_num, std::mt19937_64 &mrnd);
+  circuit(uint64_t bits_num, uint64_t gates_num, xoshiro256ss &rng);
+  // Builds output_tt in one go, on a packed small_perm for up to 4 lines. Later edits work on
+  // output_tt itself: a gate pass over its 16 rows costs about as much as converting to and from a
+  // small_perm, and output_tt() hands out the table by reference.
+  circuit(uint64_t bits_num, std::deque<gate> gates);
 
   auto bits_num() const -> uint64_t;
   auto gates() const -> const std::deque<gate> &;
   auto gates_num() const -> uint64_t;
   auto controls_num() const -> uint64_t;
+  // Kept up to date by every edit, so reading them is O(1).
+  [[nodiscard]] auto quantum_cost() const noexcept -> uint64_t;
+  [[nodiscard]] auto cost() const noexcept -> cost_vector;
+  [[nodiscard]] auto controls_histogram() const noexcept
+      -> const std::array<uint64_t, state::MAX_SIZE> &;
   auto output_tt() const -> const truth_table &;
 
   auto apply(uint64_t row) const -> uint64_t;
@@ -27,10 +70,26 @@ public:
 
   auto push_back(gate new_gate) -> circuit &;
   auto push_front(gate new_gate) -> circuit &;
+  // Composes output_tt with the table of new_circuit once instead of applying every gate.
   auto push_back(const circuit &new_circuit) -> circuit &;
   auto push_front(const circuit &new_circuit) -> circuit &;
+  // Removing or swapping a gate costs a single application of its inverse on output_tt, which
+  // is the gate itself for all but Peres gates. replace walks only the states the old and new
+  // gate take apart, those their controls match, through the cheaper side of the circuit and
+  // rewrites the rows, or values, they lead to.
+  auto pop_back() -> gate;
+  auto pop_front() -> gate;
+  auto replace(uint64_t index, gate new_gate) -> gate;
+
+  // Nested transactions: edits made after checkpoint are undone in reverse order by rollback,
+  // commit keeps them and closes the innermost checkpoint.
+  auto checkpoint() -> void;
+  auto rollback() -> void;
+  auto commit() -> void;
+  [[nodiscard]] auto checkpoints_num() const noexcept -> uint64_t;
 
-  auto operator==(const circuit &rhs) const -> bool = default;
+  // Compares the implemented circuits, open checkpoints are not part of the value.
+  auto operator==(const circuit &rhs) const -> bool;
   auto operator[](uint64_t index) const -> gate;
 
   template <typename T> auto operator+=(const T &rhs) -> circuit &;
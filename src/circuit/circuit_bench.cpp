@@ -0,0 +1,25 @@
+#include "bench/bench.hpp"
+#include "circuit.hpp"
+#include <random>
+#include <vector>
+
+namespace circuit_bench {
+std::mt19937_64 mrnd;
+const auto GATES_POOL = 64UL;
+} // namespace circuit_bench
+
+using namespace circuit_bench;
+
+REVSYNTH_BENCH("circuit/push_back", 3, 24) {
+  auto bits = state.bits_num();
+  auto gates = std::vector<gate>();
+  for (auto i = 0UL; i < GATES_POOL; i++) {
+    gates.emplace_back(bits, mrnd);
+  }
+  auto circ = circuit(bits);
+  auto next = 0UL;
+  state.run(circ.output_tt().length(), [&]() {
+    circ.push_back(gates[next++ % GATES_POOL]);
+    do_not_optimize(circ);
+  });
+}
@@ -1,4 +1,5 @@
 #include "circuit.hpp"
+#include "instrument/instrument.hpp"
 #include <catch2/catch_all.hpp>
 #include <catch2/catch_message.hpp>
 #include <catch2/catch_test_macros.hpp>
@@ -21,6 +22,11 @@ TEST_CASE("circuit constructors and getters", "[circuit], [ctors], [getters]") {
   REQUIRE(tested.gates() == std::deque<gate>());
   REQUIRE(tested.bits_num() == bits);
   REQUIRE(tested.output_tt() == truth_table(bits));
+
+  auto random = circuit(bits, mrnd() % 16, mrnd);
+  auto given = circuit(bits, random.gates());
+  REQUIRE(given == random);
+  REQUIRE(given.cost() == random.cost());
 }
 
 TEST_CASE("circuit extensions and applications", "[circuit], [push]") {
@@ -111,3 +117,146 @@ TEST_CASE("circuit operators", "[circuit], [operators]") {
     REQUIRE(tt_1_2 == tt_12);
   }
 }
+
+TEST_CASE("circuit pops and replacements", "[circuit], [undo]") {
+  const auto bits =
+      static_cast<uint64_t>(GENERATE(take(EPOCHS / 10, random(1, max_bits))));
+  const auto gates_num = 1 + mrnd() % 32;
+  auto tested = circuit(bits, gates_num, mrnd);
+
+  SECTION("pop_back and pop_front undo the pushes") {
+    auto expected = tested;
+    auto random_gate = gate(bits, mrnd);
+
+    tested.push_back(random_gate);
+    REQUIRE(tested.pop_back() == random_gate);
+    REQUIRE(tested == expected);
+
+    tested.push_front(random_gate);
+    REQUIRE(tested.pop_front() == random_gate);
+    REQUIRE(tested == expected);
+  }
+
+  SECTION("replace matches a rebuilt circuit") {
+    const auto index = mrnd() % gates_num;
+    auto new_gate = gate(bits, mrnd);
+    if (bits > 1 && mrnd() % 2 == 0) {
+      auto second_target = (new_gate.target() + 1 + mrnd() % (bits - 1)) % bits;
+      auto controls = new_gate.controls();
+      std::erase(controls, second_target);
+      new_gate = gate::peres(bits, controls, new_gate.target(), second_target);
+    }
+    new_gate = new_gate.with_polarity(mrnd() & new_gate.control_mask());
+    auto old_gate = tested[index];
+
+    REQUIRE(tested.replace(index, new_gate) == old_gate);
+    auto rebuilt = circuit(bits);
+    for (const auto &g : tested.gates()) {
+      rebuilt.push_back(g);
+    }
+    REQUIRE(tested[index] == new_gate);
+    REQUIRE(tested.output_tt() == rebuilt.output_tt());
+  }
+
+  SECTION("replace walks only the states the gates take apart") {
+    // controlled by every other line, the old and new gate each move two states
+    const auto index = mrnd() % gates_num;
+    const auto target = mrnd() % bits;
+    auto controls = state(bits, state::mask(bits) & ~(1UL << target)).ones();
+    auto wide = gate(bits, controls, target);
+    auto old_gate = wide.with_polarity(mrnd() & wide.control_mask());
+    auto new_gate = wide.with_polarity(mrnd() & wide.control_mask());
+    if (bits > 1 && mrnd() % 2 == 0) {
+      auto second_target = controls[mrnd() % controls.size()];
+      std::erase(controls, second_target);
+      new_gate = gate::fredkin(bits, controls, target, second_target);
+    }
+    tested.replace(index, old_gate);
+
+    instrument::reset();
+    tested.replace(index, new_gate);
+    auto r = instrument::snapshot();
+    REQUIRE(tested.output_tt() == circuit(bits, tested.gates()).output_tt());
+    if constexpr (instrument::enabled()) {
+      REQUIRE(r[instrument::counter::gate_rows_touched] <= 4 * (gates_num - 1));
+    }
+  }
+
+  SECTION("empty circuit and bad index") {
+    auto empty = circuit(bits);
+    REQUIRE_THROWS_AS(empty.pop_back(), std::out_of_range);
+    REQUIRE_THROWS_AS(empty.pop_front(), std::out_of_range);
+    REQUIRE_THROWS_AS(tested.replace(gates_num, gate(bits, mrnd)), std::out_of_range);
+  }
+}
+
+TEST_CASE("circuit checkpoints", "[circuit], [undo]") {
+  const auto bits =
+      static_cast<uint64_t>(GENERATE(take(EPOCHS / 10, random(1, max_bits))));
+  const auto gates_num = 1 + mrnd() % 32;
+  auto tested = circuit(bits, gates_num, mrnd);
+  auto expected = tested;
+
+  auto random_edit = [&]() {
+    switch (mrnd() % 6) {
+    case 0:
+      tested.push_back(gate(bits, mrnd));
+      break;
+    case 1:
+      tested.push_front(gate(bits, mrnd));
+      break;
+    case 2:
+      if (tested.gates_num() > 0) {
+        tested.pop_back();
+      }
+      break;
+    case 3:
+      if (tested.gates_num() > 0) {
+        tested.pop_front();
+      }
+      break;
+    case 4:
+      tested.push_back(circuit(bits, 1 + mrnd() % 4, mrnd));
+      break;
+    default:
+      if (tested.gates_num() > 0) {
+        tested.replace(mrnd() % tested.gates_num(), gate(bits, mrnd));
+      }
+    }
+  };
+
+  SECTION("rollback restores the circuit") {
+    tested.checkpoint();
+    for (auto i = 0UL; i < 16; i++) {
+      random_edit();
+    }
+    tested.rollback();
+    REQUIRE(tested == expected);
+    REQUIRE(tested.checkpoints_num() == 0);
+  }
+
+  SECTION("nested checkpoints") {
+    tested.checkpoint();
+    random_edit();
+    tested.checkpoint();
+    random_edit();
+    tested.commit();
+    auto inner_committed = tested;
+    tested.checkpoint();
+    random_edit();
+    tested.rollback();
+    REQUIRE(tested == inner_committed);
+    tested.rollback();
+    REQUIRE(tested == expected);
+  }
+
+  SECTION("commit keeps the edits") {
+    tested.checkpoint();
+    random_edit();
+    auto edited = tested;
+    tested.commit();
+    REQUIRE(tested == edited);
+    REQUIRE_THROWS_AS(tested.commit(), std::logic_error);
+    REQUIRE_THROWS_AS(tested.rollback(), std::logic_error);
+  }
+}
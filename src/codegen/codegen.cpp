@@ -0,0 +1,390 @@
+#include "codegen.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Steps per generated function: compilers optimise one function in more than linear time, and
+// a call per part costs next to nothing.
+const auto PART_STEPS = 128UL;
+
+using condition = std::pair<uint64_t, uint64_t>; // control mask, polarity mask
+
+// One gate, or a run of Toffoli gates on the same target reduced to the conditions met an odd
+// number of times: controls never include the target, so all of them read the same row.
+struct step {
+  gate_masks masks;
+  std::vector<condition> conditions;
+};
+
+auto steps(const circuit &circ) -> std::vector<step> {
+  auto result = std::vector<step>();
+  auto &gates = circ.gates();
+  for (auto i = 0UL; i < gates.size();) {
+    auto masks = gates[i].masks();
+    auto conditions = std::vector<condition>{{masks.control_mask, masks.polarity_mask}};
+    i++;
+    while (masks.kind == gate_kind::toffoli && i < gates.size() &&
+           gates[i].kind() == gate_kind::toffoli && gates[i].target_mask() == masks.target_mask) {
+      conditions.emplace_back(gates[i].control_mask(), gates[i].polarity_mask());
+      i++;
+    }
+    std::sort(conditions.begin(), conditions.end());
+    auto kept = std::vector<condition>();
+    for (auto j = 0UL; j < conditions.size(); j++) {
+      if (j + 1 < conditions.size() && conditions[j] == conditions[j + 1]) {
+        j++;
+      }
+      else {
+        kept.push_back(conditions[j]);
+      }
+    }
+    if (!kept.empty()) {
+      result.push_back({masks, std::move(kept)});
+    }
+  }
+  return result;
+}
+
+auto hex(uint64_t value) -> std::string {
+  char digits[16];
+  auto end = std::to_chars(digits, digits + sizeof(digits), value, 16).ptr;
+  return "0x" + std::string(digits, end) + "ULL";
+}
+
+auto line(uint64_t mask) -> std::string {
+  return std::to_string(std::countr_zero(mask));
+}
+
+auto row_condition(const condition &c, const std::string &row) -> std::string {
+  if (c.first == 0) {
+    return "true";
+  }
+  return "((" + row + " & " + hex(c.first) + ") == " + hex(c.second) + ")";
+}
+
+auto sliced_condition(const condition &c) -> std::string {
+  if (c.first == 0) {
+    return "~W{}";
+  }
+  auto terms = std::string();
+  for (auto mask = c.first; mask != 0; mask &= mask - 1) {
+    auto l = std::countr_zero(mask);
+    terms += terms.empty() ? "" : " & ";
+    terms += ((c.second >> l & 1UL) != 0 ? "lines[" : "~lines[") + std::to_string(l) + "]";
+  }
+  return terms;
+}
+
+// Statements of s on the row variable row, indented by indent.
+auto write_row_step(std::ostream &out, const step &s, const std::string &row,
+                    const std::string &indent) -> void {
+  auto t = line(s.masks.target_mask);
+  auto f = "static_cast<std::uint64_t>(" + row_condition(s.conditions[0], row) + ")";
+  switch (s.masks.kind) {
+  case gate_kind::toffoli: {
+    if (s.conditions.size() == 1 && s.conditions[0].first == 0) {
+      out << indent << row << " ^= " << hex(s.masks.target_mask) << ";\n";
+      return;
+    }
+    auto fired = std::string();
+    for (const auto &c : s.conditions) {
+      fired += (fired.empty() ? "" : " ^ ") + row_condition(c, row);
+    }
+    out << indent << row << " ^= static_cast<std::uint64_t>(" << fired << ") << " << t << ";\n";
+    return;
+  }
+  case gate_kind::fredkin: {
+    auto second = line(s.masks.second_target_mask);
+    out << indent << "{\n"
+        << indent << "  const std::uint64_t d = ((" << row << " >> " << t << ") ^ (" << row
+        << " >> " << second << ")) & " << f << ";\n"
+        << indent << "  " << row << " ^= (d << " << t << ") | (d << " << second << ");\n"
+        << indent << "}\n";
+    return;
+  }
+  case gate_kind::peres:
+  case gate_kind::inverse_peres: {
+    auto second = line(s.masks.second_target_mask);
+    auto flip_second =
+        indent + "  " + row + " ^= ((" + row + " >> " + t + ") & f) << " + second + ";\n";
+    auto flip_target = indent + "  " + row + " ^= f << " + t + ";\n";
+    out << indent << "{\n"
+        << indent << "  const std::uint64_t f = " << f << ";\n"
+        << (s.masks.kind == gate_kind::peres ? flip_second + flip_target
+                                             : flip_target + flip_second)
+        << indent << "}\n";
+    return;
+  }
+  }
+}
+
+auto write_sliced_step(std::ostream &out, const step &s) -> void {
+  auto t = "lines[" + line(s.masks.target_mask) + "]";
+  auto f = sliced_condition(s.conditions[0]);
+  switch (s.masks.kind) {
+  case gate_kind::toffoli: {
+    out << "  " << t << " ^= ";
+    for (auto i = 0UL; i < s.conditions.size(); i++) {
+      out << (i == 0 ? "" : " ^ ");
+      if (s.conditions.size() == 1) {
+        out << sliced_condition(s.conditions[i]);
+      }
+      else {
+        out << "(" << sliced_condition(s.conditions[i]) << ")";
+      }
+    }
+    out << ";\n";
+    return;
+  }
+  case gate_kind::fredkin: {
+    auto second = "lines[" + line(s.masks.second_target_mask) + "]";
+    out << "  {\n"
+        << "    const W d = (" << t << " ^ " << second << ") & (" << f << ");\n"
+        << "    " << t << " ^= d;\n"
+        << "    " << second << " ^= d;\n"
+        << "  }\n";
+    return;
+  }
+  case gate_kind::peres:
+  case gate_kind::inverse_peres: {
+    auto second = "lines[" + line(s.masks.second_target_mask) + "]";
+    auto flip_second = "    " + second + " ^= f & " + t + ";\n";
+    auto flip_target = "    " + t + " ^= f;\n";
+    out << "  {\n"
+        << "    const W f = " << f << ";\n"
+        << (s.masks.kind == gate_kind::peres ? flip_second + flip_target
+                                             : flip_target + flip_second)
+        << "  }\n";
+    return;
+  }
+  }
+}
+
+auto check_name(const std::string &name) -> void {
+  auto identifier = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])) ||
+      !std::all_of(name.begin(), name.end(), identifier)) {
+    throw std::invalid_argument("Not a C++ identifier: " + name);
+  }
+}
+
+auto quoted(const std::filesystem::path &path) -> std::string {
+  auto result = std::string("'");
+  for (auto c : path.string()) {
+    result += c == '\'' ? std::string("'\\''") : std::string(1, c);
+  }
+  return result + "'";
+}
+
+auto write_namespace(std::ostream &out, const circuit &circ, const std::string &name) -> void {
+  check_name(name);
+  auto circuit_steps = steps(circ);
+  auto parts_num = (circuit_steps.size() + PART_STEPS - 1) / PART_STEPS;
+  out << "namespace " << name << " {\n\n"
+      << "constexpr std::uint64_t bits_num = " << circ.bits_num() << ";\n\n"
+      << "namespace part {\n";
+  for (auto part = 0UL; part < parts_num; part++) {
+    auto first = circuit_steps.begin() + static_cast<int64_t>(part * PART_STEPS);
+    auto last = circuit_steps.begin() +
+                static_cast<int64_t>(std::min(circuit_steps.size(), (part + 1) * PART_STEPS));
+    out << "\n[[gnu::noinline]] constexpr auto apply_" << part
+        << "(std::uint64_t row) noexcept -> std::uint64_t {\n";
+    for (auto it = first; it != last; it++) {
+      write_row_step(out, *it, "row", "  ");
+    }
+    out << "  return row;\n"
+        << "}\n\n"
+        << "template <int N> [[gnu::noinline]] auto apply_rows_" << part
+        << "(std::uint64_t *rows) noexcept -> void {\n"
+        << "  std::uint64_t r[N];\n"
+        << "  for (int k = 0; k < N; k++) {\n"
+        << "    r[k] = rows[k];\n"
+        << "  }\n";
+    for (auto it = first; it != last; it++) {
+      out << "  for (int k = 0; k < N; k++) {\n";
+      write_row_step(out, *it, "r[k]", "    ");
+      out << "  }\n";
+    }
+    out << "  for (int k = 0; k < N; k++) {\n"
+        << "    rows[k] = r[k];\n"
+        << "  }\n"
+        << "}\n\n"
+        << "template <typename W> [[gnu::noinline]] auto apply_sliced_" << part
+        << "(W *lines) noexcept -> void {\n";
+    for (auto it = first; it != last; it++) {
+      write_sliced_step(out, *it);
+    }
+    out << "}\n";
+  }
+  out << "\n} // namespace part\n\n"
+      << "constexpr auto apply(std::uint64_t row) noexcept -> std::uint64_t {\n";
+  for (auto part = 0UL; part < parts_num; part++) {
+    out << "  row = part::apply_" << part << "(row);\n";
+  }
+  out << "  return row;\n"
+      << "}\n\n"
+      << "// N rows at once, whose gates the processor overlaps.\n"
+      << "template <int N> inline auto apply_rows([[maybe_unused]] std::uint64_t *rows) noexcept "
+         "-> void {\n";
+  for (auto part = 0UL; part < parts_num; part++) {
+    out << "  part::apply_rows_" << part << "<N>(rows);\n";
+  }
+  out << "}\n\n"
+      << "template <typename W> inline auto apply_sliced([[maybe_unused]] W *lines) noexcept -> "
+         "void {\n";
+  for (auto part = 0UL; part < parts_num; part++) {
+    out << "  part::apply_sliced_" << part << "(lines);\n";
+  }
+  out << "}\n\n"
+      << "} // namespace " << name << "\n";
+}
+
+} // namespace
+
+auto write_header(std::ostream &out, const circuit &circ, const std::string &name) -> void {
+  out << "// Generated from a circuit of " << circ.bits_num() << " lines and " << circ.gates_num()
+      << " gates.\n"
+      << "#pragma once\n"
+      << "#include <cstdint>\n\n";
+  write_namespace(out, circ, name);
+}
+
+// Only the interleaved rows and the vector form are instantiated, which halves the compile time:
+// single rows and the last words are padded, and a single row through apply_rows takes hardly
+// longer than through apply, both waiting on the same chain of gates.
+auto write_shared_source(std::ostream &out, const circuit &circ, const std::string &name) -> void {
+  out << "// Generated from a circuit of " << circ.bits_num() << " lines and " << circ.gates_num()
+      << " gates.\n"
+      << "#include <cstdint>\n"
+      << "#include <cstring>\n\n";
+  write_namespace(out, circ, name);
+  out << "\nconstexpr std::uint64_t ROWS = 8;\n\n"
+      << "extern \"C\" void revsynth_apply_rows(std::uint64_t *rows, std::uint64_t rows_num) {\n"
+      << "  std::uint64_t i = 0;\n"
+      << "  for (; i + ROWS <= rows_num; i += ROWS) {\n"
+      << "    " << name << "::apply_rows<ROWS>(rows + i);\n"
+      << "  }\n"
+      << "  if (i < rows_num) {\n"
+      << "    std::uint64_t last[ROWS] = {};\n"
+      << "    std::memcpy(last, rows + i, (rows_num - i) * sizeof(std::uint64_t));\n"
+      << "    " << name << "::apply_rows<ROWS>(last);\n"
+      << "    std::memcpy(rows + i, last, (rows_num - i) * sizeof(std::uint64_t));\n"
+      << "  }\n"
+      << "}\n\n"
+      << "extern \"C\" std::uint64_t revsynth_apply(std::uint64_t row) {\n"
+      << "  revsynth_apply_rows(&row, 1);\n"
+      << "  return row;\n"
+      << "}\n\n"
+      << "// 256 rows at a time, in one register where the target has 256 bit vectors.\n"
+      << "extern \"C\" void revsynth_apply_sliced(std::uint64_t *lines, std::uint64_t words) {\n"
+      << "  typedef std::uint64_t block __attribute__((vector_size(32)));\n"
+      << "  constexpr std::uint64_t block_words = sizeof(block) / sizeof(std::uint64_t);\n"
+      << "  for (std::uint64_t w = 0; w < words; w += block_words) {\n"
+      << "    const std::uint64_t n = words - w < block_words ? words - w : block_words;\n"
+      << "    block slice[" << name << "::bits_num] = {};\n"
+      << "    for (std::uint64_t l = 0; l < " << name << "::bits_num; l++) {\n"
+      << "      std::memcpy(&slice[l], lines + l * words + w, n * sizeof(std::uint64_t));\n"
+      << "    }\n"
+      << "    " << name << "::apply_sliced(slice);\n"
+      << "    for (std::uint64_t l = 0; l < " << name << "::bits_num; l++) {\n"
+      << "      std::memcpy(lines + l * words + w, &slice[l], n * sizeof(std::uint64_t));\n"
+      << "    }\n"
+      << "  }\n"
+      << "}\n";
+}
+
+compiled_circuit::compiled_circuit(const circuit &circ, const compile_options &options)
+    : handle_(nullptr), bits_num_(circ.bits_num()) {
+  auto compiler = options.compiler;
+  if (compiler.empty()) {
+    const auto *cxx = std::getenv("CXX");
+    compiler = cxx != nullptr && *cxx != '\0' ? cxx : "c++";
+  }
+  auto parent = options.work_dir.empty() ? std::filesystem::temp_directory_path() : options.work_dir;
+  // A private directory, so nothing another user placed there is followed or loaded
+  auto pattern = (parent / "revsynth_circuit_XXXXXX").string();
+  if (::mkdtemp(pattern.data()) == nullptr) {
+    throw std::runtime_error("Cannot create a build directory in " + parent.string());
+  }
+  auto dir = std::filesystem::path(pattern);
+  auto source = dir / "circuit.cpp";
+  auto object = dir / "circuit.so";
+  auto log = dir / "circuit.log";
+
+  auto out = std::ofstream(source);
+  write_shared_source(out, circ, "compiled");
+  out.close();
+  auto command = compiler + " " + options.flags + " -shared -fPIC -o " + quoted(object) + " " +
+                 quoted(source) + " 2> " + quoted(log);
+  auto status = out ? std::system(command.c_str()) : -1;
+  auto errors = std::string();
+  if (status != 0) {
+    auto in = std::ifstream(log);
+    errors.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  else {
+    handle_ = ::dlopen(object.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle_ == nullptr) {
+      errors = ::dlerror();
+    }
+  }
+  // a loaded object stays mapped after it is unlinked
+  auto ignored = std::error_code();
+  std::filesystem::remove_all(dir, ignored);
+  if (!out) {
+    throw std::runtime_error("Cannot write " + source.string());
+  }
+  if (status != 0) {
+    throw std::runtime_error("Compiling circuit failed: " + command + "\n" + errors);
+  }
+  if (handle_ == nullptr) {
+    throw std::runtime_error("Cannot load compiled circuit: " + errors);
+  }
+
+  auto lookup = [this](const char *symbol) {
+    auto *address = ::dlsym(handle_, symbol);
+    if (address == nullptr) {
+      ::dlclose(handle_);
+      throw std::runtime_error(std::string("Compiled circuit lacks ") + symbol);
+    }
+    return address;
+  };
+  apply_ = reinterpret_cast<apply_function>(lookup("revsynth_apply"));
+  apply_rows_ = reinterpret_cast<rows_function>(lookup("revsynth_apply_rows"));
+  apply_sliced_ = reinterpret_cast<rows_function>(lookup("revsynth_apply_sliced"));
+}
+
+compiled_circuit::~compiled_circuit() { ::dlclose(handle_); }
+
+auto compiled_circuit::bits_num() const noexcept -> uint64_t { return bits_num_; }
+
+auto compiled_circuit::apply(uint64_t row) const noexcept -> uint64_t { return apply_(row); }
+
+auto compiled_circuit::apply_rows(std::span<uint64_t> rows) const noexcept -> void {
+  apply_rows_(rows.data(), rows.size());
+}
+
+auto compiled_circuit::apply_back(truth_table &tt) const -> void {
+  assert(tt.size() == bits_num_);
+  apply_rows(std::span(tt.begin(), tt.end()));
+}
+
+auto compiled_circuit::apply_sliced(std::span<uint64_t> lines) const -> void {
+  if (lines.size() % bits_num_ != 0) {
+    throw std::invalid_argument("Bit-sliced rows need as many words for every line");
+  }
+  apply_sliced_(lines.data(), lines.size() / bits_num_);
+}
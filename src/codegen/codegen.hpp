@@ -0,0 +1,64 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "truth_table/truth_table.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <string>
+
+// Straight-line C++ for circuits evaluated far more often than they change. Every gate becomes a
+// few bitwise operations on immediate masks, and a run of Toffoli gates on one target, none of
+// which can see the writes of the others, becomes a single xor of their conditions.
+//
+// The header declares in namespace name
+//   bits_num              lines of the circuit
+//   apply(row)            the circuit applied to a row, like circuit::apply
+//   apply_rows<N>(rows)   the same for N rows at once, interleaved so the processor overlaps
+//                         their gates instead of waiting on one chain of dependent gates
+//   apply_sliced(lines)   the circuit applied to bit-sliced rows: lines points to bits_num words
+//                         of type W, bit j of lines[l] being line l of row j, and W is uint64_t or
+//                         a GCC vector type for as many rows as it has bits
+// Steps are split into functions of a bounded size, which keeps compile time linear in gates.
+auto write_header(std::ostream &out, const circuit &circ, const std::string &name) -> void;
+
+// The code of the header with the extern "C" entry points compiled_circuit looks up.
+auto write_shared_source(std::ostream &out, const circuit &circ, const std::string &name) -> void;
+
+struct compile_options {
+  // Compiler command, $CXX or c++ if empty.
+  std::string compiler;
+  std::string flags = "-std=c++17 -O2 -march=native";
+  // Where the private directory holding the source and the shared object is made, the
+  // temporary directory if empty. It is removed once the object is loaded.
+  std::filesystem::path work_dir;
+};
+
+// Circuit compiled by the local compiler into a shared object loaded with dlopen. The compiler
+// run takes about two seconds per thousand gates, so it only pays off for circuits applied to
+// many rows.
+class compiled_circuit {
+  using apply_function = uint64_t (*)(uint64_t);
+  using rows_function = void (*)(uint64_t *, uint64_t);
+
+  void *handle_;
+  uint64_t bits_num_;
+  apply_function apply_;
+  rows_function apply_rows_;
+  rows_function apply_sliced_;
+
+public:
+  explicit compiled_circuit(const circuit &circ, const compile_options &options = {});
+  compiled_circuit(const compiled_circuit &) = delete;
+  auto operator=(const compiled_circuit &) -> compiled_circuit & = delete;
+  ~compiled_circuit();
+
+  [[nodiscard]] auto bits_num() const noexcept -> uint64_t;
+  [[nodiscard]] auto apply(uint64_t row) const noexcept -> uint64_t;
+  auto apply_rows(std::span<uint64_t> rows) const noexcept -> void;
+  // Like circuit::apply_back, without the table of the circuit.
+  auto apply_back(truth_table &tt) const -> void;
+  // Bit-sliced rows with words words per line: bit j of lines[l * words + w] is line l of row
+  // 64 * w + j.
+  auto apply_sliced(std::span<uint64_t> lines) const -> void;
+};
@@ -0,0 +1,78 @@
+#include "bench/bench.hpp"
+#include "codegen.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace codegen_bench {
+std::mt19937_64 mrnd;
+
+auto synthesized(bench_state &state) -> circuit {
+  auto circ = mmd03().synthesize(truth_table(state.bits_num()).shuffle(mrnd));
+  state.set_counter("gates", static_cast<double>(circ.gates_num()));
+  return circ;
+}
+
+auto random_rows(uint64_t bits) -> std::vector<uint64_t> {
+  auto rows = std::vector<uint64_t>(std::max(64UL, 1UL << bits));
+  for (auto &row : rows) {
+    row = mrnd() & ((1UL << bits) - 1);
+  }
+  return rows;
+}
+} // namespace codegen_bench
+
+using namespace codegen_bench;
+
+// Lookup in the table the circuit keeps up to date.
+REVSYNTH_BENCH("codegen/circuit_apply", 3, 10) {
+  auto circ = synthesized(state);
+  auto rows = random_rows(state.bits_num());
+  state.run(rows.size(), [&]() {
+    for (auto &row : rows) {
+      row = circ.apply(row);
+    }
+    do_not_optimize(rows);
+  });
+}
+
+// Gate by gate, as without a table.
+REVSYNTH_BENCH("codegen/interpreted", 3, 10) {
+  auto circ = synthesized(state);
+  auto masks = std::vector<gate_masks>();
+  for (const auto &g : circ.gates()) {
+    masks.push_back(g.masks());
+  }
+  auto rows = random_rows(state.bits_num());
+  state.run(rows.size(), [&]() {
+    for (auto &row : rows) {
+      for (const auto &m : masks) {
+        row = m.apply(row);
+      }
+    }
+    do_not_optimize(rows);
+  });
+}
+
+REVSYNTH_BENCH("codegen/compiled", 3, 10) {
+  auto compiled = compiled_circuit(synthesized(state));
+  auto rows = random_rows(state.bits_num());
+  state.run(rows.size(), [&]() {
+    compiled.apply_rows(rows);
+    do_not_optimize(rows);
+  });
+}
+
+REVSYNTH_BENCH("codegen/compiled_sliced", 3, 10) {
+  auto compiled = compiled_circuit(synthesized(state));
+  auto rows = random_rows(state.bits_num());
+  auto lines = std::vector<uint64_t>(rows.size() / 64 * state.bits_num());
+  for (auto &word : lines) {
+    word = mrnd();
+  }
+  state.run(rows.size(), [&]() {
+    compiled.apply_sliced(lines);
+    do_not_optimize(lines);
+  });
+}
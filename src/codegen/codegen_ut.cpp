@@ -0,0 +1,127 @@
+#include "codegen.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <sstream>
+
+namespace codegen_ut {
+std::mt19937_64 mrnd;
+
+auto occurrences(const std::string &text, const std::string &pattern) -> uint64_t {
+  auto count = 0UL;
+  for (auto at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1)) {
+    count++;
+  }
+  return count;
+}
+
+// Every gate kind with random polarities, runs of Toffoli gates on one target included.
+auto mixed_circuit(uint64_t bits, uint64_t gates_num) -> circuit {
+  auto circ = circuit(bits);
+  for (auto i = 0UL; i < gates_num; i++) {
+    auto g = gate(bits, mrnd);
+    auto second_target = (g.target() + 1 + mrnd() % (bits - 1)) % bits;
+    auto controls = g.controls();
+    std::erase(controls, second_target);
+    switch (mrnd() % 5) {
+    case 0:
+      g = gate::fredkin(bits, controls, g.target(), second_target);
+      break;
+    case 1:
+      g = gate::peres(bits, controls, g.target(), second_target);
+      break;
+    case 2:
+      g = gate::peres(bits, controls, g.target(), second_target).inverse();
+      break;
+    }
+    circ.push_back(g.with_polarity(mrnd() & g.control_mask()));
+    if (mrnd() % 3 == 0) {
+      auto same_target = gate(bits, controls, g.target());
+      circ.push_back(same_target.with_polarity(mrnd() & same_target.control_mask()));
+    }
+  }
+  return circ;
+}
+} // namespace codegen_ut
+
+using namespace codegen_ut;
+
+TEST_CASE("compiled circuits match the circuit", "[codegen]") {
+  auto circ = GENERATE(as<bool>(), true, false) ? mmd03().synthesize(truth_table(7).shuffle(mrnd))
+                                                : mixed_circuit(7, 300);
+  auto compiled = compiled_circuit(circ);
+  REQUIRE(compiled.bits_num() == circ.bits_num());
+
+  auto tt = truth_table(7).shuffle(mrnd);
+  auto expected = tt;
+  circ.apply_back(expected);
+  compiled.apply_back(tt);
+  REQUIRE(tt == expected);
+  for (auto row = 0UL; row < circ.output_tt().length(); row++) {
+    REQUIRE(compiled.apply(row) == circ.apply(row));
+  }
+
+  SECTION("bit-sliced rows") {
+    // 9 words per line: two 256 row vectors and one word left over
+    const auto words = 9UL;
+    auto rows = std::vector<uint64_t>(64 * words);
+    for (auto &row : rows) {
+      row = mrnd() % tt.length();
+    }
+    auto lines = std::vector<uint64_t>(circ.bits_num() * words);
+    for (auto r = 0UL; r < rows.size(); r++) {
+      for (auto l = 0UL; l < circ.bits_num(); l++) {
+        lines[l * words + r / 64] |= (rows[r] >> l & 1UL) << (r % 64);
+      }
+    }
+    compiled.apply_sliced(lines);
+    for (auto r = 0UL; r < rows.size(); r++) {
+      auto row = 0UL;
+      for (auto l = 0UL; l < circ.bits_num(); l++) {
+        row |= (lines[l * words + r / 64] >> (r % 64) & 1UL) << l;
+      }
+      REQUIRE(row == circ.apply(rows[r]));
+    }
+    lines.pop_back();
+    REQUIRE_THROWS_AS(compiled.apply_sliced(lines), std::invalid_argument);
+  }
+}
+
+TEST_CASE("generated code", "[codegen]") {
+  const auto bits = 4UL;
+  auto circ = circuit(bits);
+
+  SECTION("runs of Toffoli gates on one target are merged") {
+    circ.push_back(gate(bits, {0, 1}, 3));
+    circ.push_back(gate(bits, {2}, 3).with_polarity(0));
+    circ.push_back(gate(bits, {}, 3));
+    circ.push_back(gate(bits, {3}, 0));
+    auto out = std::stringstream();
+    write_header(out, circ, "merged");
+    REQUIRE(occurrences(out.str(), "row ^=") == 2);
+    REQUIRE(occurrences(out.str(), "lines[3] ^=") == 1);
+    REQUIRE(occurrences(out.str(), "~lines[2]") == 1);
+  }
+
+  SECTION("gates of a run met twice cancel") {
+    circ.push_back(gate(bits, {0, 1}, 3));
+    circ.push_back(gate(bits, {2}, 3));
+    circ.push_back(gate(bits, {0, 1}, 3));
+    circ.push_back(gate::fredkin(bits, {}, 1, 2));
+    auto out = std::stringstream();
+    write_header(out, circ, "cancelled");
+    REQUIRE(occurrences(out.str(), "0x3ULL") == 0);
+    REQUIRE(occurrences(out.str(), "const W d") == 1);
+  }
+
+  SECTION("errors") {
+    auto out = std::stringstream();
+    REQUIRE_THROWS_AS(write_header(out, circ, "1st"), std::invalid_argument);
+    REQUIRE_THROWS_AS(write_header(out, circ, "a-b"), std::invalid_argument);
+    auto options = compile_options();
+    options.compiler = "false";
+    REQUIRE_THROWS_AS(compiled_circuit(circ, options), std::runtime_error);
+  }
+}
@@ -0,0 +1,86 @@
+#include "cost.hpp"
+#include <limits>
+
+auto ncv_cost(uint64_t controls_num) noexcept -> uint64_t {
+  if (controls_num < 2) {
+    return 1;
+  }
+  // 2^(controls_num + 1) - 3, exact up to the 63 controls a gate can have
+  return (std::numeric_limits<uint64_t>::max() >> (63 - controls_num)) - 2;
+}
+
+auto cost_vector::operator[](cost_metric metric) const noexcept -> uint64_t {
+  switch (metric) {
+  case cost_metric::gates:
+    return gates;
+  case cost_metric::controls:
+    return controls;
+  case cost_metric::quantum_cost:
+    return quantum_cost;
+  }
+  return 0;
+}
+
+auto cost_vector::operator+=(const cost_vector &rhs) noexcept -> cost_vector & {
+  gates += rhs.gates;
+  controls += rhs.controls;
+  quantum_cost += rhs.quantum_cost;
+  return *this;
+}
+
+auto cost_vector::operator-=(const cost_vector &rhs) noexcept -> cost_vector & {
+  gates -= rhs.gates;
+  controls -= rhs.controls;
+  quantum_cost -= rhs.quantum_cost;
+  return *this;
+}
+
+auto gate_cost(const gate &g) noexcept -> cost_vector {
+  auto controls_num = g.controls_num();
+  auto inverted = controls_num > 0 && g.polarity_mask() == 0 ? 2UL : 0UL;
+  switch (g.kind()) {
+  case gate_kind::toffoli:
+    return {1, controls_num, ncv_cost(controls_num) + inverted};
+  case gate_kind::fredkin:
+    return {1, controls_num,
+            (controls_num == 1 ? 5 : ncv_cost(controls_num + 1) + 2) + inverted};
+  case gate_kind::peres:
+  case gate_kind::inverse_peres:
+    return {1, controls_num, (controls_num == 0 ? 2 : ncv_cost(controls_num + 1) - 1) + inverted};
+  }
+  return {};
+}
+
+auto lexicographic_less(const cost_vector &lhs, const cost_vector &rhs,
+                        std::span<const cost_metric> priority) noexcept -> bool {
+  for (auto metric : priority) {
+    if (lhs[metric] != rhs[metric]) {
+      return lhs[metric] < rhs[metric];
+    }
+  }
+  return false;
+}
+
+auto weighted_cost(const cost_vector &cost, const cost_weights &weights) noexcept -> double {
+  return weights.gates * static_cast<double>(cost.gates) +
+         weights.controls * static_cast<double>(cost.controls) +
+         weights.quantum_cost * static_cast<double>(cost.quantum_cost);
+}
+
+auto cost_tracker::add(const gate &g) noexcept -> void {
+  totals_ += gate_cost(g);
+  histogram_[g.controls_num()]++;
+}
+
+auto cost_tracker::remove(const gate &g) noexcept -> void {
+  totals_ -= gate_cost(g);
+  histogram_[g.controls_num()]--;
+}
+
+auto cost_tracker::clear() noexcept -> void { *this = cost_tracker(); }
+
+auto cost_tracker::totals() const noexcept -> const cost_vector & { return totals_; }
+
+auto cost_tracker::histogram() const noexcept -> const std::array<uint64_t, state::MAX_SIZE> & {
+  return histogram_;
+}
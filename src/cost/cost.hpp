@@ -0,0 +1,70 @@
+#pragma once
+#include "gate/gate.hpp"
+#include "state/state.hpp"
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <span>
+
+// NCV quantum cost of a Toffoli gate with controls_num controls and no ancilla lines: 1 for NOT
+// and CNOT, 5 for Toffoli, then 2^(controls_num + 1) - 3 (1, 1, 5, 13, 29, 61, ...).
+[[nodiscard]] auto ncv_cost(uint64_t controls_num) noexcept -> uint64_t;
+
+enum class cost_metric { gates, controls, quantum_cost };
+
+// Cost of a gate sequence. The default ordering compares gates, then controls, then quantum cost.
+struct cost_vector {
+  uint64_t gates = 0;
+  uint64_t controls = 0;
+  uint64_t quantum_cost = 0;
+
+  [[nodiscard]] auto operator[](cost_metric metric) const noexcept -> uint64_t;
+  auto operator<=>(const cost_vector &) const = default;
+  auto operator+=(const cost_vector &rhs) noexcept -> cost_vector &;
+  auto operator-=(const cost_vector &rhs) noexcept -> cost_vector &;
+};
+
+// Mixed polarity controls are free as long as one control is positive, otherwise a pair of NOT
+// gates inverts one of them. A Fredkin gate is a Toffoli gate with one more control between two
+// CNOTs, except the single control one which costs 5 like a Toffoli gate; a Peres gate costs 4
+// with a single control and one less than its Toffoli part above. These are the RevLib values.
+[[nodiscard]] auto gate_cost(const gate &g) noexcept -> cost_vector;
+
+template <typename Gates> [[nodiscard]] auto gates_cost(const Gates &gates) -> cost_vector {
+  auto total = cost_vector();
+  for (const auto &g : gates) {
+    total += gate_cost(g);
+  }
+  return total;
+}
+
+// Objectives for synthesisers and optimisers: metrics compared one after another in priority
+// order, or a weighted sum.
+[[nodiscard]] auto lexicographic_less(const cost_vector &lhs, const cost_vector &rhs,
+                                      std::span<const cost_metric> priority) noexcept -> bool;
+
+struct cost_weights {
+  double gates = 0.0;
+  double controls = 0.0;
+  double quantum_cost = 1.0;
+};
+
+[[nodiscard]] auto weighted_cost(const cost_vector &cost, const cost_weights &weights) noexcept
+    -> double;
+
+// Totals and histogram of control counts of a gate sequence, kept up to date gate by gate.
+class cost_tracker {
+  cost_vector totals_;
+  std::array<uint64_t, state::MAX_SIZE> histogram_{};
+
+public:
+  auto add(const gate &g) noexcept -> void;
+  auto remove(const gate &g) noexcept -> void;
+  auto clear() noexcept -> void;
+
+  [[nodiscard]] auto totals() const noexcept -> const cost_vector &;
+  // Number of gates with c controls at index c.
+  [[nodiscard]] auto histogram() const noexcept -> const std::array<uint64_t, state::MAX_SIZE> &;
+
+  auto operator==(const cost_tracker &) const -> bool = default;
+};
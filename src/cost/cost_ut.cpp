@@ -0,0 +1,118 @@
+#include "cost.hpp"
+#include "circuit/circuit.hpp"
+#include "optimisers/peephole/peephole.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+
+namespace cost_ut {
+const auto EPOCHS = 100;
+const auto max_bits = 8;
+std::mt19937_64 mrnd;
+
+auto recounted_histogram(const circuit &circ) -> std::array<uint64_t, state::MAX_SIZE> {
+  auto histogram = std::array<uint64_t, state::MAX_SIZE>{};
+  for (const auto &g : circ.gates()) {
+    histogram[g.controls_num()]++;
+  }
+  return histogram;
+}
+} // namespace cost_ut
+
+using namespace cost_ut;
+
+TEST_CASE("ncv cost table", "[cost]") {
+  auto expected = std::vector<uint64_t>{1, 1, 5, 13, 29, 61, 125, 253};
+  for (auto c = 0UL; c < expected.size(); c++) {
+    REQUIRE(ncv_cost(c) == expected[c]);
+  }
+  REQUIRE(ncv_cost(63) == std::numeric_limits<uint64_t>::max() - 2);
+  REQUIRE(gate_cost(gate(4, {0, 1, 2}, 3)) == cost_vector{1, 3, 13});
+}
+
+TEST_CASE("cost of mixed polarity, Fredkin and Peres gates", "[cost], [polarity]") {
+  REQUIRE(gate_cost(gate(3, {0, 1}, 2).with_polarity(1)) == cost_vector{1, 2, 5});
+  REQUIRE(gate_cost(gate(3, {0, 1}, 2).with_polarity(0)) == cost_vector{1, 2, 7});
+  REQUIRE(gate_cost(gate::fredkin(3, {0}, 1, 2)) == cost_vector{1, 1, 5});
+  REQUIRE(gate_cost(gate::fredkin(3, {0}, 1, 2).with_polarity(0)) == cost_vector{1, 1, 7});
+  REQUIRE(gate_cost(gate::fredkin(4, {0, 1}, 2, 3)) == cost_vector{1, 2, 15});
+  REQUIRE(gate_cost(gate::fredkin(2, {}, 0, 1)) == cost_vector{1, 0, 3});
+  REQUIRE(gate_cost(gate::peres(3, {0}, 1, 2)) == cost_vector{1, 1, 4});
+  REQUIRE(gate_cost(gate::peres(3, {0}, 1, 2).inverse()) == cost_vector{1, 1, 4});
+  REQUIRE(gate_cost(gate::peres(2, {}, 0, 1)) == cost_vector{1, 0, 2});
+}
+
+TEST_CASE("cost objectives", "[cost]") {
+  auto fewer_gates = cost_vector{3, 6, 25};
+  auto cheaper = cost_vector{4, 4, 20};
+
+  REQUIRE(fewer_gates < cheaper);
+  const auto by_quantum_cost = std::array{cost_metric::quantum_cost, cost_metric::gates};
+  REQUIRE(lexicographic_less(cheaper, fewer_gates, by_quantum_cost));
+  REQUIRE(!lexicographic_less(fewer_gates, cheaper, by_quantum_cost));
+  REQUIRE(!lexicographic_less(cheaper, cheaper, by_quantum_cost));
+  REQUIRE(weighted_cost(cheaper, {}) == 20.0);
+  REQUIRE(weighted_cost(cheaper, {1.0, 0.5, 0.0}) == 6.0);
+
+  auto total = fewer_gates;
+  total += cheaper;
+  REQUIRE(total == cost_vector{7, 10, 45});
+  total -= cheaper;
+  REQUIRE(total == fewer_gates);
+  REQUIRE(total[cost_metric::controls] == 6);
+}
+
+TEST_CASE("circuit cost follows every edit", "[cost], [circuit], [undo]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  auto tested = circuit(bits, mrnd() % 16, mrnd);
+  auto check = [&]() {
+    REQUIRE(tested.cost() == gates_cost(tested.gates()));
+    REQUIRE(tested.controls_histogram() == recounted_histogram(tested));
+  };
+  check();
+
+  auto random_edit = [&]() {
+    switch (mrnd() % 5) {
+    case 0:
+      tested.push_back(gate(bits, mrnd));
+      break;
+    case 1:
+      tested.push_front(gate(bits, mrnd));
+      break;
+    case 2:
+      if (tested.gates_num() > 0) {
+        tested.pop_back();
+      }
+      break;
+    case 3:
+      if (tested.gates_num() > 0) {
+        tested.pop_front();
+      }
+      break;
+    default:
+      if (tested.gates_num() > 0) {
+        tested.replace(mrnd() % tested.gates_num(), gate(bits, mrnd));
+      }
+    }
+  };
+
+  auto before = tested.cost();
+  tested.checkpoint();
+  for (auto i = 0UL; i < 16; i++) {
+    random_edit();
+    check();
+  }
+  // swaps the gates in through replace_gates, which rollback has to undo as well
+  auto report = peephole().optimize(tested);
+  check();
+  REQUIRE(report.cost_after == tested.cost());
+  REQUIRE(report.cost_after <= report.cost_before);
+  tested.rollback();
+  check();
+  REQUIRE(tested.cost() == before);
+
+  report = peephole().optimize(tested);
+  check();
+  REQUIRE(report.cost_after == tested.cost());
+}
@@ -0,0 +1,480 @@
+#include "decision_diagram.hpp"
+#include "state/state.hpp"
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+const auto NIL = std::numeric_limits<bdd_node>::max();
+const auto OP_AND = 1U;
+const auto OP_OR = 2U;
+const auto OP_XOR = 3U;
+const auto INITIAL_BUCKETS = 1UL << 10;
+
+auto mix(uint64_t x) noexcept -> uint64_t {
+  x = (x ^ (x >> 33)) * 0xff51afd7ed558ccdUL;
+  return x ^ (x >> 33);
+}
+
+} // namespace
+
+bdd_manager::bdd_manager(uint64_t vars_num, uint64_t max_cache_size, uint64_t gc_threshold)
+    : vars_num_(state::check_size(vars_num)), buckets_(INITIAL_BUCKETS, NIL),
+      cache_(std::min(INITIAL_BUCKETS, std::bit_ceil(std::max(max_cache_size, 1UL)))), free_(NIL),
+      max_cache_size_(std::bit_ceil(std::max(max_cache_size, 1UL))), gc_threshold_(gc_threshold) {
+  nodes_.push_back({TERMINAL_LEVEL, ZERO, ZERO, NIL, 0, false});
+  nodes_.push_back({TERMINAL_LEVEL, ONE, ONE, NIL, 0, false});
+  live_ = nodes_.size();
+}
+
+auto bdd_manager::vars_num() const noexcept -> uint64_t { return vars_num_; }
+
+auto bdd_manager::nodes_num() const noexcept -> uint64_t { return live_; }
+
+auto bdd_manager::collections() const noexcept -> uint64_t { return collections_; }
+
+auto bdd_manager::bucket(uint32_t level, bdd_node low, bdd_node high) const noexcept
+    -> uint64_t {
+  auto key = (static_cast<uint64_t>(low) << 32 | high) ^ mix(level);
+  return mix(key) & (buckets_.size() - 1);
+}
+
+auto bdd_manager::rehash(uint64_t buckets_num) -> void {
+  // entries keep their full key, so the ones left in slots of the smaller cache stay correct
+  if (cache_.size() < std::min(buckets_num, max_cache_size_)) {
+    cache_.resize(std::min(buckets_num, max_cache_size_));
+  }
+  buckets_.assign(buckets_num, NIL);
+  for (auto i = ONE + 1; i < nodes_.size(); i++) {
+    auto &n = nodes_[i];
+    if (n.level != FREE_LEVEL) {
+      auto &head = buckets_[bucket(n.level, n.low, n.high)];
+      n.next = head;
+      head = i;
+    }
+  }
+}
+
+auto bdd_manager::make(uint32_t level, bdd_node low, bdd_node high) -> bdd_node {
+  if (low == high) {
+    return low;
+  }
+  for (auto i = buckets_[bucket(level, low, high)]; i != NIL; i = nodes_[i].next) {
+    const auto &n = nodes_[i];
+    if (n.level == level && n.low == low && n.high == high) {
+      return i;
+    }
+  }
+  auto index = free_;
+  if (index != NIL) {
+    free_ = nodes_[index].next;
+  }
+  else {
+    if (nodes_.size() == NIL) {
+      throw std::length_error("Decision diagram node store is full");
+    }
+    index = static_cast<bdd_node>(nodes_.size());
+    nodes_.emplace_back();
+  }
+  auto &head = buckets_[bucket(level, low, high)];
+  nodes_[index] = {level, low, high, head, 0, false};
+  head = index;
+  if (++live_ > buckets_.size()) {
+    rehash(buckets_.size() * 2);
+  }
+  return index;
+}
+
+auto bdd_manager::apply(uint32_t op, bdd_node f, bdd_node g) -> bdd_node {
+  switch (op) {
+  case OP_AND:
+    if (f == ZERO || g == ZERO) {
+      return ZERO;
+    }
+    if (f == ONE || f == g) {
+      return g;
+    }
+    if (g == ONE) {
+      return f;
+    }
+    break;
+  case OP_OR:
+    if (f == ONE || g == ONE) {
+      return ONE;
+    }
+    if (f == ZERO || f == g) {
+      return g;
+    }
+    if (g == ZERO) {
+      return f;
+    }
+    break;
+  default:
+    if (f == g) {
+      return ZERO;
+    }
+    if (f == ZERO) {
+      return g;
+    }
+    if (g == ZERO) {
+      return f;
+    }
+  }
+  if (f > g) {
+    std::swap(f, g);
+  }
+  const auto slot = mix(static_cast<uint64_t>(f) << 32 | g) ^ op;
+  const auto &cached = cache_[slot & (cache_.size() - 1)];
+  if (cached.op == op && cached.f == f && cached.g == g) {
+    return cached.result;
+  }
+
+  const auto f_node = nodes_[f];
+  const auto g_node = nodes_[g];
+  const auto level = std::min(f_node.level, g_node.level);
+  const auto f_top = f_node.level == level;
+  const auto g_top = g_node.level == level;
+  auto low = apply(op, f_top ? f_node.low : f, g_top ? g_node.low : g);
+  auto high = apply(op, f_top ? f_node.high : f, g_top ? g_node.high : g);
+  auto result = make(level, low, high);
+  cache_[slot & (cache_.size() - 1)] = {op, f, g, result};
+  return result;
+}
+
+auto bdd_manager::mark(bdd_node f) -> void {
+  auto &n = nodes_[f];
+  if (n.marked) {
+    return;
+  }
+  n.marked = true;
+  if (n.level != TERMINAL_LEVEL) {
+    mark(n.low);
+    mark(n.high);
+  }
+}
+
+auto bdd_manager::reachable(std::vector<bdd_node> roots) const -> uint64_t {
+  auto visited = std::vector<bool>(nodes_.size());
+  auto count = 0UL;
+  while (!roots.empty()) {
+    auto f = roots.back();
+    roots.pop_back();
+    if (visited[f]) {
+      continue;
+    }
+    visited[f] = true;
+    count++;
+    const auto &n = nodes_[f];
+    if (n.level != TERMINAL_LEVEL) {
+      roots.push_back(n.low);
+      roots.push_back(n.high);
+    }
+  }
+  return count;
+}
+
+auto bdd_manager::collect_garbage() -> void {
+  for (auto i = 0UL; i < nodes_.size(); i++) {
+    if (nodes_[i].refs > 0) {
+      mark(static_cast<bdd_node>(i));
+    }
+  }
+  for (auto i = ONE + 1; i < nodes_.size(); i++) {
+    auto &n = nodes_[i];
+    if (n.level != FREE_LEVEL && !n.marked) {
+      n.level = FREE_LEVEL;
+      n.next = free_;
+      free_ = i;
+      live_--;
+    }
+    n.marked = false;
+  }
+  nodes_[ZERO].marked = false;
+  nodes_[ONE].marked = false;
+  rehash(buckets_.size());
+  std::fill(cache_.begin(), cache_.end(), cache_entry{});
+  collections_++;
+}
+
+auto bdd_manager::maybe_collect() -> void {
+  if (live_ < gc_threshold_) {
+    return;
+  }
+  collect_garbage();
+  if (live_ > gc_threshold_ / 2) {
+    gc_threshold_ *= 2;
+  }
+}
+
+auto bdd_manager::ref(bdd_node f) noexcept -> void { nodes_[f].refs++; }
+
+auto bdd_manager::deref(bdd_node f) noexcept -> void { nodes_[f].refs--; }
+
+auto bdd_manager::constant(bool value) -> bdd { return {this, value ? ONE : ZERO}; }
+
+auto bdd_manager::variable(uint64_t var) -> bdd {
+  if (var >= vars_num_) {
+    throw std::out_of_range("Variable exceeds number of variables");
+  }
+  return {this, make(static_cast<uint32_t>(vars_num_ - 1 - var), ZERO, ONE)};
+}
+
+auto bdd_manager::from_column(const truth_table &tt, uint64_t line, uint32_t level,
+                              uint64_t begin) -> bdd_node {
+  if (level == vars_num_) {
+    return (tt[begin] >> line & 1UL) != 0 ? ONE : ZERO;
+  }
+  auto half = 1UL << (vars_num_ - level - 1);
+  auto low = from_column(tt, line, level + 1, begin);
+  auto high = from_column(tt, line, level + 1, begin + half);
+  return make(level, low, high);
+}
+
+auto bdd_manager::to_column(bdd_node f, uint64_t line, uint32_t level, uint64_t begin,
+                            truth_table &tt) const -> void {
+  if (f == ZERO) {
+    return;
+  }
+  auto block = 1UL << (vars_num_ - level);
+  if (f == ONE) {
+    for (auto row = begin; row < begin + block; row++) {
+      tt[row] |= 1UL << line;
+    }
+    return;
+  }
+  const auto &n = nodes_[f];
+  auto skipped = n.level != level;
+  to_column(skipped ? f : n.low, line, level + 1, begin, tt);
+  to_column(skipped ? f : n.high, line, level + 1, begin + block / 2, tt);
+}
+
+auto bdd_manager::from_table(const truth_table &tt, uint64_t line) -> bdd {
+  if (tt.size() != vars_num_ || line >= vars_num_) {
+    throw std::invalid_argument("Table does not match the variables of the manager");
+  }
+  maybe_collect();
+  return {this, from_column(tt, line, 0, 0)};
+}
+
+bdd::bdd(bdd_manager *manager, bdd_node node) noexcept : manager_(manager), node_(node) {
+  manager_->ref(node_);
+}
+
+bdd::bdd(const bdd &other) noexcept : manager_(other.manager_), node_(other.node_) {
+  manager_->ref(node_);
+}
+
+bdd::bdd(bdd &&other) noexcept : manager_(std::exchange(other.manager_, nullptr)),
+                                 node_(other.node_) {}
+
+auto bdd::operator=(const bdd &other) noexcept -> bdd & {
+  if (this != &other) {
+    *this = bdd(other);
+  }
+  return *this;
+}
+
+auto bdd::operator=(bdd &&other) noexcept -> bdd & {
+  if (manager_ != nullptr) {
+    manager_->deref(node_);
+  }
+  manager_ = std::exchange(other.manager_, nullptr);
+  node_ = other.node_;
+  return *this;
+}
+
+bdd::~bdd() {
+  if (manager_ != nullptr) {
+    manager_->deref(node_);
+  }
+}
+
+auto bdd::node() const noexcept -> bdd_node { return node_; }
+
+auto bdd::is_constant() const noexcept -> bool { return node_ <= bdd_manager::ONE; }
+
+auto bdd::size() const -> uint64_t { return manager_->reachable({node_}); }
+
+auto bdd::evaluate(uint64_t vars) const noexcept -> bool {
+  const auto &nodes = manager_->nodes_;
+  const auto top_var = manager_->vars_num_ - 1;
+  auto f = node_;
+  while (nodes[f].level != bdd_manager::TERMINAL_LEVEL) {
+    const auto &n = nodes[f];
+    f = (vars >> (top_var - n.level) & 1UL) != 0 ? n.high : n.low;
+  }
+  return f == bdd_manager::ONE;
+}
+
+auto bdd::min_satisfying() const -> std::optional<uint64_t> {
+  if (node_ == bdd_manager::ZERO) {
+    return std::nullopt;
+  }
+  // every other node is satisfiable, so the low edge is taken unless it is the zero terminal
+  const auto &nodes = manager_->nodes_;
+  const auto top_var = manager_->vars_num_ - 1;
+  auto vars = 0UL;
+  auto f = node_;
+  while (nodes[f].level != bdd_manager::TERMINAL_LEVEL) {
+    const auto &n = nodes[f];
+    if (n.low != bdd_manager::ZERO) {
+      f = n.low;
+    }
+    else {
+      vars |= 1UL << (top_var - n.level);
+      f = n.high;
+    }
+  }
+  return vars;
+}
+
+auto bdd::operator&(const bdd &other) const -> bdd {
+  manager_->maybe_collect();
+  return {manager_, manager_->apply(OP_AND, node_, other.node_)};
+}
+
+auto bdd::operator|(const bdd &other) const -> bdd {
+  manager_->maybe_collect();
+  return {manager_, manager_->apply(OP_OR, node_, other.node_)};
+}
+
+auto bdd::operator^(const bdd &other) const -> bdd {
+  manager_->maybe_collect();
+  return {manager_, manager_->apply(OP_XOR, node_, other.node_)};
+}
+
+auto bdd::operator~() const -> bdd {
+  manager_->maybe_collect();
+  return {manager_, manager_->apply(OP_XOR, node_, bdd_manager::ONE)};
+}
+
+auto bdd::operator==(const bdd &other) const noexcept -> bool {
+  return manager_ == other.manager_ && node_ == other.node_;
+}
+
+bdd_function::bdd_function(bdd_manager &manager) : manager_(&manager) {
+  outputs_.reserve(manager.vars_num());
+  for (auto line = 0UL; line < manager.vars_num(); line++) {
+    outputs_.push_back(manager.variable(line));
+  }
+}
+
+bdd_function::bdd_function(bdd_manager &manager, const truth_table &tt) : manager_(&manager) {
+  outputs_.reserve(manager.vars_num());
+  for (auto line = 0UL; line < manager.vars_num(); line++) {
+    outputs_.push_back(manager.from_table(tt, line));
+  }
+}
+
+bdd_function::bdd_function(bdd_manager &manager, const std::deque<gate> &gates)
+    : bdd_function(manager) {
+  apply_back(gates);
+}
+
+bdd_function::bdd_function(bdd_manager &manager, const circuit &circ)
+    : bdd_function(manager, circ.gates()) {
+  if (circ.bits_num() != manager.vars_num()) {
+    throw std::invalid_argument("Circuit does not match the variables of the manager");
+  }
+}
+
+auto bdd_function::bits_num() const noexcept -> uint64_t { return outputs_.size(); }
+
+auto bdd_function::output(uint64_t line) const -> const bdd & { return outputs_.at(line); }
+
+auto bdd_function::nodes_num() const -> uint64_t {
+  auto roots = std::vector<bdd_node>();
+  for (const auto &output : outputs_) {
+    roots.push_back(output.node());
+  }
+  return manager_->reachable(std::move(roots));
+}
+
+auto bdd_function::apply(uint64_t row) const noexcept -> uint64_t {
+  auto value = 0UL;
+  for (auto line = 0UL; line < outputs_.size(); line++) {
+    value |= static_cast<uint64_t>(outputs_[line].evaluate(row)) << line;
+  }
+  return value;
+}
+
+auto bdd_function::to_table() const -> truth_table {
+  auto tt = truth_table(bits_num());
+  std::fill(tt.begin(), tt.end(), 0UL);
+  for (auto line = 0UL; line < outputs_.size(); line++) {
+    manager_->to_column(outputs_[line].node(), line, 0, 0, tt);
+  }
+  return tt;
+}
+
+auto bdd_function::first_moved_row() const -> std::optional<uint64_t> {
+  auto moved = manager_->constant(false);
+  for (auto line = 0UL; line < outputs_.size(); line++) {
+    moved = moved | (outputs_[line] ^ manager_->variable(line));
+  }
+  return moved.min_satisfying();
+}
+
+auto bdd_function::is_identity() const -> bool {
+  for (auto line = 0UL; line < outputs_.size(); line++) {
+    if (outputs_[line] != manager_->variable(line)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto bdd_function::apply_back(const gate &g) -> bdd_function & {
+  if (g.size() != bits_num()) {
+    throw std::invalid_argument("Gate does not match the lines of the function");
+  }
+  auto fires = manager_->constant(true);
+  for (auto control : g.controls()) {
+    auto positive = (g.polarity_mask() >> control & 1UL) != 0;
+    fires = fires & (positive ? outputs_[control] : ~outputs_[control]);
+  }
+  auto &target = outputs_[g.target()];
+  auto &second = outputs_[g.second_target()];
+  switch (g.kind()) {
+  case gate_kind::toffoli:
+    target = target ^ fires;
+    break;
+  case gate_kind::fredkin: {
+    auto swapped = fires & (target ^ second);
+    target = target ^ swapped;
+    second = second ^ swapped;
+    break;
+  }
+  case gate_kind::peres:
+    second = second ^ (fires & target);
+    target = target ^ fires;
+    break;
+  case gate_kind::inverse_peres:
+    target = target ^ fires;
+    second = second ^ (fires & target);
+    break;
+  }
+  return *this;
+}
+
+auto bdd_function::apply_back(const std::deque<gate> &gates) -> bdd_function & {
+  for (const auto &g : gates) {
+    apply_back(g);
+  }
+  return *this;
+}
+
+auto bdd_function::operator==(const bdd_function &other) const noexcept -> bool {
+  return manager_ == other.manager_ && outputs_ == other.outputs_;
+}
+
+auto equivalent(uint64_t bits_num, const std::deque<gate> &lhs, const std::deque<gate> &rhs)
+    -> bool {
+  auto manager = bdd_manager(bits_num);
+  return bdd_function(manager, lhs) == bdd_function(manager, rhs);
+}
+
+auto equivalent(const circuit &lhs, const circuit &rhs) -> bool {
+  return lhs.bits_num() == rhs.bits_num() && equivalent(lhs.bits_num(), lhs.gates(), rhs.gates());
+}
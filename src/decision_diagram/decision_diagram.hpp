@@ -0,0 +1,159 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "gate/gate.hpp"
+#include "truth_table/truth_table.hpp"
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Reduced ordered binary decision diagrams over vars_num variables, shared between all diagrams
+// of one manager. Variable vars_num - 1 is tested at the root and variable 0 just above the
+// terminals, so the paths of a diagram are ordered like the rows of a truth table.
+
+using bdd_node = uint32_t;
+
+class bdd;
+class bdd_function;
+
+class bdd_manager {
+  friend class bdd;
+  friend class bdd_function;
+
+  struct node {
+    uint32_t level; // vars_num - 1 - variable, TERMINAL_LEVEL for constants, FREE_LEVEL if unused
+    bdd_node low;
+    bdd_node high;
+    bdd_node next;  // next node of the same unique table bucket or of the free list
+    uint32_t refs;  // bdd handles pointing at the node
+    bool marked;
+  };
+
+  struct cache_entry {
+    uint32_t op;
+    bdd_node f;
+    bdd_node g;
+    bdd_node result;
+  };
+
+  uint64_t vars_num_;
+  std::vector<node> nodes_;
+  std::vector<bdd_node> buckets_;
+  std::vector<cache_entry> cache_;
+  bdd_node free_;
+  uint64_t live_ = 0;
+  uint64_t max_cache_size_;
+  uint64_t gc_threshold_;
+  uint64_t collections_ = 0;
+
+  auto make(uint32_t level, bdd_node low, bdd_node high) -> bdd_node;
+  auto apply(uint32_t op, bdd_node f, bdd_node g) -> bdd_node;
+  auto bucket(uint32_t level, bdd_node low, bdd_node high) const noexcept -> uint64_t;
+  auto rehash(uint64_t buckets_num) -> void;
+  auto mark(bdd_node f) -> void;
+  auto reachable(std::vector<bdd_node> roots) const -> uint64_t;
+  auto maybe_collect() -> void;
+  auto ref(bdd_node f) noexcept -> void;
+  auto deref(bdd_node f) noexcept -> void;
+  auto from_column(const truth_table &tt, uint64_t line, uint32_t level, uint64_t begin)
+      -> bdd_node;
+  auto to_column(bdd_node f, uint64_t line, uint32_t level, uint64_t begin, truth_table &tt) const
+      -> void;
+
+public:
+  static constexpr auto TERMINAL_LEVEL = std::numeric_limits<uint32_t>::max();
+  static constexpr auto FREE_LEVEL = TERMINAL_LEVEL - 1;
+  static constexpr bdd_node ZERO = 0;
+  static constexpr bdd_node ONE = 1;
+
+  // The computed cache grows with the unique table up to max_cache_size entries. Dead nodes are
+  // only reclaimed once the store holds gc_threshold nodes, which doubles when a collection frees
+  // less than half of them.
+  explicit bdd_manager(uint64_t vars_num, uint64_t max_cache_size = 1UL << 20,
+                       uint64_t gc_threshold = 1UL << 16);
+  bdd_manager(const bdd_manager &) = delete;
+  auto operator=(const bdd_manager &) -> bdd_manager & = delete;
+
+  [[nodiscard]] auto vars_num() const noexcept -> uint64_t;
+  auto constant(bool value) -> bdd;
+  auto variable(uint64_t var) -> bdd;
+  // Column line of tt, i.e. output line of a function given by its table.
+  auto from_table(const truth_table &tt, uint64_t line) -> bdd;
+
+  // Frees every node not reachable from a live bdd handle and clears the computed cache.
+  auto collect_garbage() -> void;
+  // Nodes in the store including constants and dead nodes not collected yet.
+  [[nodiscard]] auto nodes_num() const noexcept -> uint64_t;
+  [[nodiscard]] auto collections() const noexcept -> uint64_t;
+};
+
+// Counted reference to a diagram of a manager, which has to outlive it. Diagrams of one manager
+// are canonical: equal functions are equal handles, compared in constant time.
+class bdd {
+  friend class bdd_manager;
+
+  bdd_manager *manager_;
+  bdd_node node_;
+
+  bdd(bdd_manager *manager, bdd_node node) noexcept;
+
+public:
+  bdd(const bdd &other) noexcept;
+  bdd(bdd &&other) noexcept;
+  auto operator=(const bdd &other) noexcept -> bdd &;
+  auto operator=(bdd &&other) noexcept -> bdd &;
+  ~bdd();
+
+  [[nodiscard]] auto node() const noexcept -> bdd_node;
+  [[nodiscard]] auto is_constant() const noexcept -> bool;
+  // Nodes reachable from this diagram, constants included.
+  [[nodiscard]] auto size() const -> uint64_t;
+  // Value for the assignment with variable i set to bit i of vars.
+  [[nodiscard]] auto evaluate(uint64_t vars) const noexcept -> bool;
+  // Smallest assignment, read as a number, for which the function is true.
+  [[nodiscard]] auto min_satisfying() const -> std::optional<uint64_t>;
+
+  auto operator&(const bdd &other) const -> bdd;
+  auto operator|(const bdd &other) const -> bdd;
+  auto operator^(const bdd &other) const -> bdd;
+  auto operator~() const -> bdd;
+  auto operator==(const bdd &other) const noexcept -> bool;
+};
+
+// Reversible function of bits_num lines as one diagram per output line over the input lines.
+// Built gate by gate it needs no truth table, so circuits on far more lines than a table can hold
+// are compared in time proportional to the size of their diagrams.
+class bdd_function {
+  bdd_manager *manager_;
+  std::vector<bdd> outputs_;
+
+public:
+  // Identity on manager.vars_num() lines.
+  explicit bdd_function(bdd_manager &manager);
+  bdd_function(bdd_manager &manager, const truth_table &tt);
+  bdd_function(bdd_manager &manager, const std::deque<gate> &gates);
+  bdd_function(bdd_manager &manager, const circuit &circ);
+
+  [[nodiscard]] auto bits_num() const noexcept -> uint64_t;
+  [[nodiscard]] auto output(uint64_t line) const -> const bdd &;
+  // Shared size of all output diagrams.
+  [[nodiscard]] auto nodes_num() const -> uint64_t;
+  [[nodiscard]] auto apply(uint64_t row) const noexcept -> uint64_t;
+  [[nodiscard]] auto to_table() const -> truth_table;
+
+  // Smallest row not mapped onto itself, none for the identity.
+  [[nodiscard]] auto first_moved_row() const -> std::optional<uint64_t>;
+  [[nodiscard]] auto is_identity() const -> bool;
+
+  // g applied to the outputs, like gate::apply_back on the function's table.
+  auto apply_back(const gate &g) -> bdd_function &;
+  auto apply_back(const std::deque<gate> &gates) -> bdd_function &;
+
+  auto operator==(const bdd_function &other) const noexcept -> bool;
+};
+
+// Whether two gate lists on bits_num lines realise the same function, without truth tables.
+auto equivalent(uint64_t bits_num, const std::deque<gate> &lhs, const std::deque<gate> &rhs)
+    -> bool;
+auto equivalent(const circuit &lhs, const circuit &rhs) -> bool;
@@ -0,0 +1,73 @@
+#include "bench/bench.hpp"
+#include "decision_diagram.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include "synthesisers/mmd03_symbolic/mmd03_symbolic.hpp"
+
+// Functions of adder-like ripples of Toffoli gates, whose diagrams stay linear in the lines.
+
+namespace decision_diagram_bench {
+auto ripple(uint64_t bits_num) -> std::deque<gate> {
+  auto gates = std::deque<gate>();
+  for (auto line = 2UL; line < bits_num; line++) {
+    gates.emplace_back(bits_num, std::vector<uint64_t>{line - 2, line - 1}, line);
+  }
+  for (auto line = 1UL; line < bits_num; line++) {
+    gates.emplace_back(bits_num, std::vector<uint64_t>{line - 1}, line);
+  }
+  return gates;
+}
+} // namespace decision_diagram_bench
+
+using namespace decision_diagram_bench;
+
+REVSYNTH_BENCH("decision_diagram/build", 4, 64) {
+  auto bits = state.bits_num();
+  auto gates = ripple(bits);
+  auto manager = bdd_manager(bits);
+  auto nodes = 0UL;
+  state.run(gates.size(), [&]() { nodes = bdd_function(manager, gates).nodes_num(); });
+  state.set_counter("nodes", static_cast<double>(nodes));
+}
+
+REVSYNTH_BENCH("decision_diagram/equivalent", 4, 64) {
+  auto bits = state.bits_num();
+  auto gates = ripple(bits);
+  auto reversed = std::deque<gate>(gates.rbegin(), gates.rend());
+  state.run(gates.size(), [&]() { do_not_optimize(equivalent(bits, gates, reversed)); });
+}
+
+REVSYNTH_BENCH("decision_diagram/to_table", 4, 20) {
+  auto bits = state.bits_num();
+  auto manager = bdd_manager(bits);
+  auto f = bdd_function(manager, ripple(bits));
+  state.run(1UL << bits, [&]() { do_not_optimize(f.to_table()); });
+}
+
+// One moved row: mmd03 visits every row of the table, the symbolic engine finds the moved row in
+// the diagrams.
+REVSYNTH_BENCH("decision_diagram/mmd03/one_moved_row", 4, 20) {
+  auto target = truth_table(state.bits_num());
+  target.swap(target.length() - 2, target.length() - 1);
+  state.run(target.length(), [&]() { do_not_optimize(mmd03().synthesize(target)); });
+}
+
+REVSYNTH_BENCH("decision_diagram/symbolic/one_moved_row", 4, 64) {
+  auto bits = state.bits_num();
+  auto controls = std::vector<uint64_t>();
+  for (auto line = 1UL; line < bits; line++) {
+    controls.push_back(line);
+  }
+  auto manager = bdd_manager(bits);
+  auto target = bdd_function(manager, std::deque<gate>{gate(bits, controls, 0)});
+  state.run(1, [&]() {
+    auto remaining = target;
+    do_not_optimize(mmd03_symbolic().synthesize_gates(remaining));
+  });
+}
+
+REVSYNTH_BENCH("decision_diagram/from_table", 4, 20) {
+  auto bits = state.bits_num();
+  auto tt = circuit(bits, ripple(bits)).output_tt();
+  auto manager = bdd_manager(bits);
+  state.run(tt.length(), [&]() { do_not_optimize(bdd_function(manager, tt).nodes_num()); });
+}
@@ -0,0 +1,166 @@
+#include "decision_diagram.hpp"
+#include "optimisers/peephole/peephole.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <bit>
+#include <random>
+
+namespace decision_diagram_ut {
+const auto EPOCHS = 100;
+const auto max_bits = 10;
+std::mt19937_64 mrnd;
+} // namespace decision_diagram_ut
+
+using namespace decision_diagram_ut;
+
+TEST_CASE("bdd operations are canonical", "[decision_diagram]") {
+  auto manager = bdd_manager(3);
+  auto x0 = manager.variable(0);
+  auto x1 = manager.variable(1);
+  auto x2 = manager.variable(2);
+  auto zero = manager.constant(false);
+  auto one = manager.constant(true);
+
+  REQUIRE((x0 & x1) == (x1 & x0));
+  REQUIRE((x0 ^ x0) == zero);
+  REQUIRE((x0 | ~x0) == one);
+  REQUIRE(~(x0 & x1) == (~x0 | ~x1));
+  REQUIRE(((x0 ^ x1) ^ x2) == (x0 ^ (x1 ^ x2)));
+  REQUIRE((x0 & x1) != (x0 | x1));
+  REQUIRE(one.is_constant());
+  REQUIRE(!x2.is_constant());
+  REQUIRE((x0 ^ x1 ^ x2).size() == 7);
+
+  auto majority = (x0 & x1) | (x0 & x2) | (x1 & x2);
+  for (auto vars = 0UL; vars < 8; vars++) {
+    REQUIRE(majority.evaluate(vars) == (std::popcount(vars) >= 2));
+  }
+  REQUIRE(majority.min_satisfying() == 3UL);
+  REQUIRE((x2 & ~x1).min_satisfying() == 4UL);
+  REQUIRE(!zero.min_satisfying());
+  REQUIRE_THROWS_AS(manager.variable(3), std::out_of_range);
+}
+
+TEST_CASE("bdd garbage collection", "[decision_diagram]") {
+  auto manager = bdd_manager(16, 1UL << 10, 1UL << 8);
+  auto kept = manager.constant(false);
+  for (auto i = 0UL; i < 2000; i++) {
+    auto cube = manager.constant(true);
+    for (auto var = 0UL; var < 16; var++) {
+      cube = cube & ((mrnd() & 1UL) != 0 ? manager.variable(var) : ~manager.variable(var));
+    }
+    if (i % 100 == 0) {
+      kept = kept | cube;
+    }
+  }
+  REQUIRE(manager.collections() > 0);
+  auto before = kept.size();
+  manager.collect_garbage();
+  REQUIRE(kept.size() == before);
+  REQUIRE(manager.nodes_num() <= before + 16);
+}
+
+TEST_CASE("bdd_function conversions", "[decision_diagram], [truth_table]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto manager = bdd_manager(bits);
+  REQUIRE(bdd_function(manager).to_table() == truth_table(bits));
+  REQUIRE(bdd_function(manager).is_identity());
+  REQUIRE(!bdd_function(manager).first_moved_row());
+
+  auto tt = truth_table(bits).shuffle(mrnd);
+  auto f = bdd_function(manager, tt);
+  REQUIRE(f.to_table() == tt);
+  for (auto row = 0UL; row < tt.length(); row++) {
+    REQUIRE(f.apply(row) == tt[row]);
+  }
+  auto moved = f.first_moved_row();
+  REQUIRE(moved.has_value() == (tt != truth_table(bits)));
+  if (moved) {
+    REQUIRE(tt[*moved] != *moved);
+    for (auto row = 0UL; row < *moved; row++) {
+      REQUIRE(tt[row] == row);
+    }
+  }
+  REQUIRE_THROWS_AS(bdd_function(manager, truth_table(bits + 1)), std::invalid_argument);
+}
+
+TEST_CASE("bdd_function of circuits", "[decision_diagram], [circuit]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto circ = circuit(bits, mrnd() % 40, mrnd);
+  auto manager = bdd_manager(bits);
+  auto f = bdd_function(manager, circ);
+  REQUIRE(f.to_table() == circ.output_tt());
+
+  auto g = gate(bits, mrnd);
+  auto tt = circ.output_tt();
+  g.apply_back(tt);
+  REQUIRE(f.apply_back(g).to_table() == tt);
+  REQUIRE(bdd_function(manager, tt) == f);
+}
+
+TEST_CASE("bdd_function of mixed gates", "[decision_diagram], [polarity]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(2, max_bits))));
+
+  auto manager = bdd_manager(bits);
+  auto f = bdd_function(manager);
+  auto tt = truth_table(bits);
+  for (auto i = 0UL; i < 20; i++) {
+    auto g = gate(bits, mrnd);
+    auto second_target = (g.target() + 1 + mrnd() % (bits - 1)) % bits;
+    auto controls = g.controls();
+    std::erase(controls, second_target);
+    if (i % 3 == 1) {
+      g = gate::fredkin(bits, controls, g.target(), second_target);
+    }
+    else if (i % 3 == 2) {
+      g = gate::peres(bits, controls, g.target(), second_target);
+      g = mrnd() % 2 == 0 ? g : g.inverse();
+    }
+    g = g.with_polarity(mrnd() & g.control_mask());
+    g.apply_back(tt);
+    f.apply_back(g);
+  }
+  REQUIRE(f.to_table() == tt);
+}
+
+TEST_CASE("circuit equivalence", "[decision_diagram], [circuit]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto circ = mmd03().synthesize(truth_table(bits).shuffle(mrnd));
+  auto optimised = circ;
+  peephole().optimize(optimised);
+  REQUIRE(equivalent(circ, optimised));
+  REQUIRE(equivalent(circ, circuit(bits, circ.gates())));
+
+  auto changed = circ;
+  changed.push_back(gate(bits, mrnd));
+  REQUIRE(!equivalent(circ, changed));
+  REQUIRE(!equivalent(circ, circuit(bits + 1)));
+}
+
+TEST_CASE("equivalence beyond truth tables", "[decision_diagram]") {
+  // 40 line ripple of Toffoli gates and the same gates with a cancelling pair in between
+  const auto bits = 40UL;
+  auto gates = std::deque<gate>();
+  for (auto line = 2UL; line < bits; line++) {
+    gates.emplace_back(bits, std::vector<uint64_t>{line - 2, line - 1}, line);
+  }
+  auto padded = gates;
+  auto extra = gate(bits, {0, 7, 21}, 39);
+  padded.insert(padded.begin() + 10, {extra, extra});
+  REQUIRE(equivalent(bits, gates, padded));
+
+  padded.erase(padded.begin() + 10);
+  REQUIRE(!equivalent(bits, gates, padded));
+
+  auto manager = bdd_manager(bits);
+  auto f = bdd_function(manager, gates);
+  REQUIRE(f.nodes_num() < 1000);
+  // the first two lines set every following one
+  REQUIRE(f.apply(3) == state::mask(bits));
+  REQUIRE(f.apply(2) == 2UL);
+}
@@ -0,0 +1,112 @@
+#include "functions.hpp"
+#include "parallel/parallel.hpp"
+#include <bit>
+#include <stdexcept>
+
+namespace {
+
+const auto CHUNK_ROWS = 1UL << 14;
+
+auto rotate_left(uint64_t value, uint64_t shift, uint64_t bits_num, uint64_t mask) -> uint64_t {
+  shift %= bits_num;
+  if (shift == 0) {
+    return value;
+  }
+  return ((value << shift) | (value >> (bits_num - shift))) & mask;
+}
+
+template <typename F> auto tabulate(uint64_t bits_num, uint64_t threads, F &&f) -> truth_table {
+  auto tt = truth_table(bits_num);
+  auto length = tt.length();
+  auto fill = [&](uint64_t chunk) {
+    auto end = std::min(length, (chunk + 1) * CHUNK_ROWS);
+    for (auto row = chunk * CHUNK_ROWS; row < end; row++) {
+      tt[row] = f(row);
+    }
+  };
+  if (length < PARALLEL_ROWS) {
+    fill(0);
+  }
+  else {
+    parallel_for(0, (length + CHUNK_ROWS - 1) / CHUNK_ROWS, threads, fill);
+  }
+  return tt;
+}
+
+} // namespace
+
+auto hwb(uint64_t bits_num, uint64_t threads_num) -> truth_table {
+  auto mask = state::mask(bits_num);
+  return tabulate(bits_num, threads_num, [=](uint64_t x) {
+    return rotate_left(x, static_cast<uint64_t>(std::popcount(x)), bits_num, mask);
+  });
+}
+
+auto modular_adder(uint64_t bits_num, uint64_t addend, uint64_t threads_num) -> truth_table {
+  auto mask = state::mask(bits_num);
+  return tabulate(bits_num, threads_num, [=](uint64_t x) { return (x + addend) & mask; });
+}
+
+auto modular_multiplier(uint64_t bits_num, uint64_t factor, uint64_t threads_num)
+    -> truth_table {
+  if (factor % 2 == 0) {
+    throw std::invalid_argument("Multiplication modulo 2^n is reversible only for odd factors");
+  }
+  auto mask = state::mask(bits_num);
+  return tabulate(bits_num, threads_num, [=](uint64_t x) { return (x * factor) & mask; });
+}
+
+auto graycode(uint64_t bits_num, uint64_t threads_num) -> truth_table {
+  return tabulate(bits_num, threads_num, [](uint64_t x) { return x ^ (x >> 1); });
+}
+
+auto rd_embedding(uint64_t bits_num, uint64_t sum_bits, uint64_t threads_num) -> truth_table {
+  if (sum_bits == 0 || sum_bits >= bits_num) {
+    throw std::invalid_argument("rd embedding needs between 1 and bits_num - 1 sum lines");
+  }
+  auto sum_mask = (1UL << sum_bits) - 1;
+  return tabulate(bits_num, threads_num, [=](uint64_t x) {
+    return x ^ (static_cast<uint64_t>(std::popcount(x >> sum_bits)) & sum_mask);
+  });
+}
+
+auto rotation(uint64_t bits_num, uint64_t shift, uint64_t threads_num) -> truth_table {
+  auto mask = state::mask(bits_num);
+  return tabulate(bits_num, threads_num,
+                  [=](uint64_t x) { return rotate_left(x, shift, bits_num, mask); });
+}
+
+auto standard_functions(uint64_t bits_num, uint64_t threads_num)
+    -> std::vector<named_function> {
+  auto n = std::to_string(bits_num);
+  auto functions = std::vector<named_function>();
+  functions.push_back({"hwb" + n, hwb(bits_num, threads_num)});
+  functions.push_back({"add" + n, modular_adder(bits_num, 1, threads_num)});
+  functions.push_back({"mul" + n, modular_multiplier(bits_num, 3, threads_num)});
+  functions.push_back({"graycode" + n, graycode(bits_num, threads_num)});
+  if (bits_num >= 2) {
+    // rd-style: enough sum lines to count every remaining line
+    auto sum_bits = 1UL;
+    while (sum_bits + 1 < bits_num && (1UL << sum_bits) <= bits_num - sum_bits) {
+      sum_bits++;
+    }
+    functions.push_back({"rd" + n, rd_embedding(bits_num, sum_bits, threads_num)});
+  }
+  functions.push_back({"rotate" + n, rotation(bits_num, 1, threads_num)});
+  return functions;
+}
+
+auto random_functions(uint64_t bits_num, uint64_t count, uint64_t seed, uint64_t threads_num)
+    -> std::vector<named_function> {
+  auto prefix = "rand" + std::to_string(bits_num) + "_";
+  auto functions = std::vector<named_function>();
+  functions.reserve(count);
+  for (auto i = 0UL; i < count; i++) {
+    functions.push_back({prefix + std::to_string(i), truth_table(bits_num)});
+  }
+  parallel_for(0, count, threads_num, [&](uint64_t i) {
+    auto rng = xoshiro256ss(seed, i);
+    functions[i].tt.shuffle(rng, threads_num);
+  });
+  return functions;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "truth_table/truth_table.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Standard reversible benchmark families, tabulated for any number of lines. Tables with at
+// least PARALLEL_ROWS rows are filled by threads_num threads (0 picks the hardware default).
+
+const auto PARALLEL_ROWS = 1UL << 16;
+
+// hwb_n: x rotated left by its own Hamming weight.
+auto hwb(uint64_t bits_num, uint64_t threads_num = 0) -> truth_table;
+// x + addend mod 2^n.
+auto modular_adder(uint64_t bits_num, uint64_t addend, uint64_t threads_num = 0) -> truth_table;
+// x * factor mod 2^n, factor has to be odd to be reversible.
+auto modular_multiplier(uint64_t bits_num, uint64_t factor, uint64_t threads_num = 0)
+    -> truth_table;
+// graycode_n: x ^ (x >> 1).
+auto graycode(uint64_t bits_num, uint64_t threads_num = 0) -> truth_table;
+// rd-style counting embedded reversibly: the low sum_bits lines are xored with the number of
+// ones on the remaining lines.
+auto rd_embedding(uint64_t bits_num, uint64_t sum_bits, uint64_t threads_num = 0) -> truth_table;
+// x rotated left by shift.
+auto rotation(uint64_t bits_num, uint64_t shift, uint64_t threads_num = 0) -> truth_table;
+
+struct named_function {
+  std::string name;
+  truth_table tt;
+};
+
+// count uniformly random permutations of bits_num lines named rand<bits_num>_<i>. Function i is
+// drawn from stream i of seed, so the batch is the same for any threads_num.
+auto random_functions(uint64_t bits_num, uint64_t count, uint64_t seed, uint64_t threads_num = 0)
+    -> std::vector<named_function>;
+
+// One representative of every family for bits_num lines, named RevLib style (hwb4, graycode4,
+// ...). Families that need more lines than bits_num are skipped.
+auto standard_functions(uint64_t bits_num, uint64_t threads_num = 0)
+    -> std::vector<named_function>;
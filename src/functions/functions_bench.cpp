@@ -0,0 +1,31 @@
+#include "bench/bench.hpp"
+#include "functions.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+
+// Synthesis of every standard family, reporting gate and control counts next to the runtime.
+
+namespace functions_bench {
+auto synthesize_family(bench_state &state, uint64_t family) -> void {
+  auto target = standard_functions(state.bits_num()).at(family).tt;
+  auto synth = mmd03();
+  auto circ = circuit(state.bits_num());
+  state.run(target.length(), [&]() { circ = synth.synthesize(target); });
+  state.set_counter("gates", static_cast<double>(circ.gates_num()));
+  state.set_counter("controls", static_cast<double>(circ.controls_num()));
+  state.set_counter("quantum_cost", static_cast<double>(circ.quantum_cost()));
+}
+} // namespace functions_bench
+
+using namespace functions_bench;
+
+REVSYNTH_BENCH("functions/mmd03/hwb", 3, 16) { synthesize_family(state, 0); }
+REVSYNTH_BENCH("functions/mmd03/add", 3, 16) { synthesize_family(state, 1); }
+REVSYNTH_BENCH("functions/mmd03/mul", 3, 16) { synthesize_family(state, 2); }
+REVSYNTH_BENCH("functions/mmd03/graycode", 3, 16) { synthesize_family(state, 3); }
+REVSYNTH_BENCH("functions/mmd03/rd", 3, 16) { synthesize_family(state, 4); }
+REVSYNTH_BENCH("functions/mmd03/rotate", 3, 16) { synthesize_family(state, 5); }
+
+REVSYNTH_BENCH("functions/generate/hwb", 3, 24) {
+  auto bits = state.bits_num();
+  state.run(1UL << bits, [&]() { do_not_optimize(hwb(bits)); });
+}
@@ -0,0 +1,90 @@
+#include "functions.hpp"
+#include <algorithm>
+#include <bit>
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <numeric>
+#include <random>
+
+namespace functions_ut {
+const auto EPOCHS = 50;
+const auto max_bits = 12;
+std::mt19937_64 mrnd;
+
+auto is_permutation(const truth_table &tt) -> bool {
+  auto rows = std::vector<uint64_t>(tt.data().begin(), tt.data().end());
+  std::sort(rows.begin(), rows.end());
+  auto identity = std::vector<uint64_t>(rows.size());
+  std::iota(identity.begin(), identity.end(), 0);
+  return rows == identity;
+}
+} // namespace functions_ut
+
+using namespace functions_ut;
+
+TEST_CASE("standard functions are reversible", "[functions]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  for (const auto &[name, tt] : standard_functions(bits)) {
+    INFO(name);
+    REQUIRE(tt.size() == bits);
+    REQUIRE(is_permutation(tt));
+  }
+}
+
+TEST_CASE("standard function values", "[functions]") {
+  SECTION("hwb4") {
+    auto tt = hwb(4);
+    REQUIRE(tt[0b0000] == 0b0000);
+    REQUIRE(tt[0b0001] == 0b0010);
+    REQUIRE(tt[0b0011] == 0b1100);
+    REQUIRE(tt[0b0111] == 0b1011);
+    REQUIRE(tt[0b1111] == 0b1111);
+  }
+
+  SECTION("graycode") {
+    auto tt = graycode(5);
+    for (auto x = 1UL; x < tt.length(); x++) {
+      REQUIRE(std::popcount(tt[x] ^ tt[x - 1]) == 1);
+    }
+  }
+
+  SECTION("arithmetic") {
+    const auto bits = 1 + mrnd() % max_bits;
+    auto mask = (1UL << bits) - 1;
+    auto add = modular_adder(bits, 5);
+    auto mul = modular_multiplier(bits, 7);
+    for (auto x = 0UL; x < add.length(); x++) {
+      REQUIRE(add[x] == ((x + 5) & mask));
+      REQUIRE(mul[x] == ((x * 7) & mask));
+    }
+    REQUIRE_THROWS_AS(modular_multiplier(bits, 2), std::invalid_argument);
+  }
+
+  SECTION("rd embedding is an involution counting high ones") {
+    auto tt = rd_embedding(7, 3);
+    for (auto x = 0UL; x < tt.length(); x++) {
+      REQUIRE((tt[x] ^ x) == static_cast<uint64_t>(std::popcount(x >> 3)));
+      REQUIRE(tt[tt[x]] == x);
+    }
+    REQUIRE_THROWS_AS(rd_embedding(4, 4), std::invalid_argument);
+  }
+
+  SECTION("rotations compose to identity") {
+    const auto bits = 1 + mrnd() % max_bits;
+    const auto shift = mrnd() % bits;
+    REQUIRE(rotation(bits, shift) + rotation(bits, bits - shift) == truth_table(bits));
+  }
+}
+
+TEST_CASE("parallel tabulation", "[functions], [parallel]") {
+  auto bits = 17UL; // above PARALLEL_ROWS
+  auto tt = hwb(bits, 4);
+  auto mask = (1UL << bits) - 1;
+  for (auto x = 0UL; x < tt.length(); x += 97) {
+    auto weight = static_cast<uint64_t>(std::popcount(x)) % bits;
+    auto expected = weight == 0 ? x : ((x << weight) | (x >> (bits - weight))) & mask;
+    REQUIRE(tt[x] == expected);
+  }
+  REQUIRE(is_permutation(tt));
+}
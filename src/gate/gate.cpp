@@ -1,10 +1,37 @@
 #include "gate.hpp"
+#include "instrument/instrument.hpp"
+#include "memory/memory.hpp"
+#include "parallel/parallel.hpp"
 #include "utils/utils.hpp"
+#include <bit>
 #include <iostream>
 #include <ostream>
 #include <random>
 #include <stdexcept>
 
+namespace {
+
+template <typename Rng> auto random_gate(uint64_t size, Rng &rng) -> gate {
+  const auto taps_num = uniform_below(rng, size) + 1; // actual controls_num + target;
+  auto controls = random_unique_vector(taps_num, size, rng);
+  const auto target = controls.back();
+  controls.pop_back();
+  return gate(size, std::move(controls), target);
+}
+
+auto inverse_kind(gate_kind kind) noexcept -> gate_kind {
+  switch (kind) {
+  case gate_kind::peres:
+    return gate_kind::inverse_peres;
+  case gate_kind::inverse_peres:
+    return gate_kind::peres;
+  default:
+    return kind;
+  }
+}
+
+} // namespace
+
 auto gate::sort_controls(std::vector<uint64_t> &controls) {
   std::sort(controls.begin(), controls.end());
   return controls;
@@ -21,25 +48,64 @@ auto gate::control_mask(const std::vector<uint64_t> &controls) {
 auto gate::target_mask(uint64_t target) { return 1UL << target; }
 
 gate::gate(uint64_t size, std::vector<uint64_t> controls, uint64_t target)
-    : _size(size), _controls(sort_controls(controls)), _target(target),
-      _control_mask(control_mask(controls)), _target_mask(target_mask(target)) {}
+    : _size(size), _controls(current_resource()), _target(target),
+      _control_mask(control_mask(controls)), _target_mask(target_mask(target)),
+      _polarity_mask(_control_mask), _second_target(target) {
+  sort_controls(controls);
+  _controls.assign(controls.begin(), controls.end());
+}
 
-gate::gate(uint64_t size, std::mt19937_64 mrnd) : _size(size) {
-  const auto taps_num = mrnd() % size + 1; // actual controls_num + target;
-  auto controls = random_unique_vector(taps_num, size, mrnd);
-  const auto target = controls.back();
-  controls.pop_back();
-  sort(controls.begin(), controls.end());
+gate::gate(const gate &other)
+    : _size(other._size), _controls(other._controls, current_resource()), _target(other._target),
+      _control_mask(other._control_mask), _target_mask(other._target_mask),
+      _polarity_mask(other._polarity_mask), _second_target(other._second_target),
+      _second_target_mask(other._second_target_mask), _kind(other._kind) {}
+
+auto gate::two_target(gate_kind kind, uint64_t size, std::vector<uint64_t> controls,
+                      uint64_t target, uint64_t second_target) -> gate {
+  auto result = gate(size, std::move(controls), target);
+  if (target == second_target || (result._control_mask & target_mask(second_target)) != 0 ||
+      (result._control_mask & result._target_mask) != 0) {
+    throw std::invalid_argument("Targets of a gate have to be distinct lines");
+  }
+  result._kind = kind;
+  result._second_target = second_target;
+  result._second_target_mask = target_mask(second_target);
+  return result;
+}
+
+auto gate::fredkin(uint64_t size, std::vector<uint64_t> controls, uint64_t target,
+                   uint64_t second_target) -> gate {
+  return two_target(gate_kind::fredkin, size, std::move(controls), target, second_target);
+}
+
+auto gate::peres(uint64_t size, std::vector<uint64_t> controls, uint64_t target,
+                 uint64_t second_target) -> gate {
+  return two_target(gate_kind::peres, size, std::move(controls), target, second_target);
+}
 
-  _controls = controls;
-  _control_mask = control_mask(controls);
-  _target = target;
-  _target_mask = target_mask(target);
+auto gate::from_masks(uint64_t size, const gate_masks &masks) -> gate {
+  auto controls = std::vector<uint64_t>();
+  for (auto mask = masks.control_mask; mask != 0; mask &= mask - 1) {
+    controls.push_back(static_cast<uint64_t>(std::countr_zero(mask)));
+  }
+  auto target = static_cast<uint64_t>(std::countr_zero(masks.target_mask));
+  auto second_target = static_cast<uint64_t>(std::countr_zero(masks.second_target_mask));
+  auto result = masks.kind == gate_kind::toffoli
+                    ? gate(size, std::move(controls), target)
+                    : two_target(masks.kind, size, std::move(controls), target, second_target);
+  return result.with_polarity(masks.polarity_mask);
 }
 
+gate::gate(uint64_t size, std::mt19937_64 &mrnd) : gate(random_gate(size, mrnd)) {}
+
+gate::gate(uint64_t size, xoshiro256ss &rng) : gate(random_gate(size, rng)) {}
+
 auto gate::size() const noexcept -> uint64_t { return _size; }
 
-auto gate::controls() const noexcept -> std::vector<uint64_t> { return _controls; }
+auto gate::controls() const noexcept -> std::vector<uint64_t> {
+  return {_controls.begin(), _controls.end()};
+}
 
 auto gate::controls_num() const noexcept -> uint64_t { return _controls.size(); }
 
@@ -49,13 +115,47 @@ auto gate::control_mask() const noexcept -> uint64_t { return _control_mask; }
 
 auto gate::target_mask() const noexcept -> uint64_t { return _target_mask; }
 
-auto gate::apply(uint64_t row) const noexcept -> uint64_t {
-  if ((row & _control_mask) == _control_mask) {
-    return row ^ _target_mask;
-  }
-  else {
-    return row;
+auto gate::polarity_mask() const noexcept -> uint64_t { return _polarity_mask; }
+
+auto gate::kind() const noexcept -> gate_kind { return _kind; }
+
+auto gate::second_target() const noexcept -> uint64_t { return _second_target; }
+
+auto gate::second_target_mask() const noexcept -> uint64_t { return _second_target_mask; }
+
+auto gate::lines_mask() const noexcept -> uint64_t {
+  return _control_mask | _target_mask | _second_target_mask;
+}
+
+auto gate::masks() const noexcept -> gate_masks {
+  return {_control_mask, _polarity_mask, _target_mask, _second_target_mask, _kind};
+}
+
+auto gate::with_polarity(uint64_t polarity_mask) const -> gate {
+  if ((polarity_mask & ~_control_mask) != 0) {
+    throw std::invalid_argument("Polarity mask has to be a subset of the control mask");
   }
+  auto result = *this;
+  result._polarity_mask = polarity_mask;
+  return result;
+}
+
+auto gate::is_self_inverse() const noexcept -> bool {
+  return _kind == gate_kind::toffoli || _kind == gate_kind::fredkin;
+}
+
+auto gate::inverse() const -> gate {
+  auto result = *this;
+  result._kind = inverse_kind(_kind);
+  return result;
+}
+
+auto gate::apply(uint64_t row) const noexcept -> uint64_t { return masks().apply(row); }
+
+auto gate::apply_inverse(uint64_t row) const noexcept -> uint64_t {
+  auto inverse_masks = masks();
+  inverse_masks.kind = inverse_kind(_kind);
+  return inverse_masks.apply(row);
 }
 
 auto gate::apply(state &s) const -> void {
@@ -65,12 +165,66 @@ auto gate::apply(state &s) const -> void {
   s.set_value(apply(s.value()));
 }
 
+namespace {
+
+// Replaces every row of tt with kernel(row), in chunks spread over default_pool() for large
+// tables. Kernels are branch free per kind so the row loop vectorises.
+template <typename Kernel> auto transform_rows(truth_table &tt, Kernel kernel) -> void {
+  auto apply_rows = [&](uint64_t begin, uint64_t end) {
+    for (auto index = begin; index < end; index++) {
+      tt[index] = kernel(tt[index]);
+    }
+  };
+  if (tt.length() >= PARALLEL_GATE_ROWS) {
+    parallel_for_chunks(0, tt.length(), GATE_CHUNK_ROWS, 0, apply_rows);
+  }
+  else {
+    apply_rows(0, tt.length());
+  }
+}
+
+// Calls cycle(index) for every index in chunks spread over default_pool() for large tables. Every
+// cycle of the gate has to be rotated by the call of exactly one of its rows, so chunks touch
+// disjoint rows.
+template <typename Cycle> auto for_each_index(truth_table &tt, Cycle cycle) -> void {
+  auto visit = [&](uint64_t begin, uint64_t end) {
+    for (auto index = begin; index < end; index++) {
+      cycle(index);
+    }
+  };
+  if (tt.length() >= PARALLEL_GATE_ROWS) {
+    parallel_for_chunks(0, tt.length(), GATE_CHUNK_ROWS, 0, visit);
+  }
+  else {
+    visit(0, tt.length());
+  }
+}
+
+} // namespace
+
 auto gate::apply_back(truth_table &tt) const -> void {
   if (tt.size() != size()) {
     throw std::invalid_argument("Cannot apply gate to truth_table of different size");
   }
-  for (auto index = 0UL; auto row : tt) {
-    tt.set_row(index++, apply(row));
+  REVSYNTH_COUNT(gate_rows_touched, tt.length());
+  const auto c = _control_mask;
+  const auto p = _polarity_mask;
+  const auto t = _target_mask;
+  const auto s = _second_target_mask;
+  switch (_kind) {
+  case gate_kind::toffoli:
+    transform_rows(tt, [=](uint64_t row) { return (row & c) == p ? row ^ t : row; });
+    break;
+  case gate_kind::fredkin:
+    transform_rows(tt, [=](uint64_t row) {
+      auto differ = ((row & t) == 0) != ((row & s) == 0);
+      return (row & c) == p && differ ? row ^ t ^ s : row;
+    });
+    break;
+  case gate_kind::peres:
+  case gate_kind::inverse_peres:
+    transform_rows(tt, [m = masks()](uint64_t row) { return m.apply(row); });
+    break;
   }
 }
 
@@ -78,14 +232,123 @@ auto gate::apply_front(truth_table &tt) const -> void {
   if (tt.size() != size()) {
     throw std::invalid_argument("Cannot apply gate to truth_table of different size");
   }
-  for (auto index = 0UL; index < tt.length(); index++) {
-    bool is_control_set = (index & _control_mask) == _control_mask;
-    bool is_target_set = (index & _target_mask) == _target_mask;
-    if (is_control_set && is_target_set) {
-      auto next_index = index ^ _target_mask;
-      tt.swap(index, next_index);
+  REVSYNTH_COUNT(gate_rows_touched, tt.length());
+  const auto c = _control_mask;
+  const auto p = _polarity_mask;
+  const auto t = _target_mask;
+  const auto s = _second_target_mask;
+  switch (_kind) {
+  case gate_kind::toffoli:
+    // every swapped pair is rotated from its row with the target bit set
+    for_each_index(tt, [&](uint64_t index) {
+      if ((index & c) == p && (index & t) != 0) {
+        std::swap(tt[index], tt[index ^ t]);
+      }
+    });
+    break;
+  case gate_kind::fredkin:
+    // and here from its row with target set and second_target clear
+    for_each_index(tt, [&](uint64_t index) {
+      if ((index & c) == p && (index & (t | s)) == t) {
+        std::swap(tt[index], tt[index ^ t ^ s]);
+      }
+    });
+    break;
+  case gate_kind::peres:
+  case gate_kind::inverse_peres:
+    // rows matching the controls form 4-cycles over both targets, rotated from their row with
+    // both targets clear so that row x takes the value of row g(x)
+    for_each_index(tt, [&, m = masks()](uint64_t index) {
+      if ((index & c) == p && (index & (t | s)) == 0) {
+        auto r1 = m.apply(index);
+        auto r2 = m.apply(r1);
+        auto r3 = m.apply(r2);
+        auto first = tt[index];
+        tt[index] = tt[r1];
+        tt[r1] = tt[r2];
+        tt[r2] = tt[r3];
+        tt[r3] = first;
+      }
+    });
+    break;
+  }
+}
+
+auto apply_gates_back(const std::deque<gate> &gates, truth_table &tt) -> void {
+  auto masks = std::vector<gate_masks>();
+  masks.reserve(gates.size());
+  auto toffoli_only = true;
+  for (const auto &g : gates) {
+    if (tt.size() != g.size()) {
+      throw std::invalid_argument("Cannot apply gate to truth_table of different size");
     }
+    masks.push_back(g.masks());
+    toffoli_only = toffoli_only && g.kind() == gate_kind::toffoli;
+  }
+  REVSYNTH_COUNT(gate_rows_touched, gates.size() * tt.length());
+  if (toffoli_only) {
+    transform_rows(tt, [&](uint64_t row) {
+      for (const auto &m : masks) {
+        row = (row & m.control_mask) == m.polarity_mask ? row ^ m.target_mask : row;
+      }
+      return row;
+    });
+  }
+  else {
+    transform_rows(tt, [&](uint64_t row) {
+      for (const auto &m : masks) {
+        row = m.apply(row);
+      }
+      return row;
+    });
+  }
+}
+
+auto write_gate(std::vector<uint8_t> &buffer, const gate &g, uint64_t previous_field) -> uint64_t {
+  if (g.kind() == gate_kind::toffoli && g.polarity_mask() == g.control_mask()) {
+    write_varint(buffer, g.control_mask() ^ previous_field);
+    write_varint(buffer, g.target());
+    return g.control_mask();
   }
+  auto field = g.control_mask() | g.target_mask();
+  write_varint(buffer, field ^ previous_field);
+  write_varint(buffer, g.target());
+  write_varint(buffer, g.polarity_mask());
+  write_varint(buffer, static_cast<uint64_t>(g.kind()) << 6 | g.second_target());
+  return field;
+}
+
+auto read_gate_masks(const uint8_t *&position, const uint8_t *end, uint64_t bits_num,
+                     uint64_t &previous_field) -> gate_masks {
+  auto field = read_varint(position, end) ^ previous_field;
+  auto target = read_varint(position, end);
+  auto lines = state::mask(bits_num);
+  if (target >= bits_num || (field & ~lines) != 0) {
+    throw std::invalid_argument("Corrupted gate encoding");
+  }
+  previous_field = field;
+  auto target_mask = gate::target_mask(target);
+  if ((field & target_mask) == 0) {
+    return {field, field, target_mask, 0, gate_kind::toffoli};
+  }
+  auto control_mask = field ^ target_mask;
+  auto polarity_mask = read_varint(position, end);
+  auto kind_and_target = read_varint(position, end);
+  auto kind = kind_and_target >> 6;
+  auto second_target = kind_and_target & 63;
+  auto second_target_mask = kind == 0 ? 0 : gate::target_mask(second_target);
+  if (kind > static_cast<uint64_t>(gate_kind::inverse_peres) ||
+      (polarity_mask & ~control_mask) != 0 ||
+      (kind != 0 && (second_target >= bits_num || (second_target_mask & field) != 0))) {
+    throw std::invalid_argument("Corrupted gate encoding");
+  }
+  return {control_mask, polarity_mask, target_mask, second_target_mask,
+          static_cast<gate_kind>(kind)};
+}
+
+auto read_gate(const uint8_t *&position, const uint8_t *end, uint64_t bits_num) -> gate {
+  auto previous_field = 0UL;
+  return gate::from_masks(bits_num, read_gate_masks(position, end, bits_num, previous_field));
 }
 
 auto gate::print() const -> void {
@@ -97,5 +360,11 @@ auto gate::print() const -> void {
   }
   std::cout << "T mask:   " << _target_mask << std::endl;
   std::cout << "C mask:   " << _control_mask << std::endl;
+  if (_polarity_mask != _control_mask) {
+    std::cout << "P mask:   " << _polarity_mask << std::endl;
+  }
+  if (_kind != gate_kind::toffoli) {
+    std::cout << "Target 2: " << _second_target << std::endl;
+  }
   std::cout << std::endl;
 }
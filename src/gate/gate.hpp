@@ -2,22 +2,92 @@
 #include "state/state.hpp"
 #include "truth_table/truth_table.hpp"
 #include <cstdint>
+#include <deque>
+#include <memory_resource>
 #include <vector>
 
+// Tables of at least PARALLEL_GATE_ROWS rows are split into chunks of GATE_CHUNK_ROWS rows
+// between the workers of default_pool() when gates are applied.
+const auto PARALLEL_GATE_ROWS = 1UL << 18;
+const auto GATE_CHUNK_ROWS = 1UL << 14;
+
+// What a gate does to its targets once its controls match. Controls of every kind may be negative,
+// i.e. match when their line is 0.
+enum class gate_kind : uint8_t {
+  toffoli,      // flips target
+  fredkin,      // swaps target and second_target
+  peres,        // flips second_target if target is 1, then flips target
+  inverse_peres // flips target, then flips second_target if target is 1
+};
+
+// Raw form of a gate as used by the row kernels: apply matches (row & control_mask) against
+// polarity_mask. second_target_mask is 0 for Toffoli gates.
+struct gate_masks {
+  uint64_t control_mask;
+  uint64_t polarity_mask;
+  uint64_t target_mask;
+  uint64_t second_target_mask;
+  gate_kind kind;
+
+  [[nodiscard]] constexpr auto apply(uint64_t row) const noexcept -> uint64_t {
+    if ((row & control_mask) != polarity_mask) {
+      return row;
+    }
+    switch (kind) {
+    case gate_kind::toffoli:
+      return row ^ target_mask;
+    case gate_kind::fredkin:
+      return ((row & target_mask) == 0) != ((row & second_target_mask) == 0)
+                 ? row ^ target_mask ^ second_target_mask
+                 : row;
+    case gate_kind::peres:
+      row ^= (row & target_mask) != 0 ? second_target_mask : 0;
+      return row ^ target_mask;
+    case gate_kind::inverse_peres:
+      row ^= target_mask;
+      return (row & target_mask) != 0 ? row ^ second_target_mask : row;
+    }
+    return row;
+  }
+};
+
 class gate {
   uint64_t _size;
-  std::vector<uint64_t> _controls;
+  std::pmr::vector<uint64_t> _controls;
   uint64_t _target;
   uint64_t _control_mask;
   uint64_t _target_mask;
+  uint64_t _polarity_mask;
+  uint64_t _second_target;
+  uint64_t _second_target_mask = 0;
+  gate_kind _kind = gate_kind::toffoli;
+
+  static auto two_target(gate_kind kind, uint64_t size, std::vector<uint64_t> controls,
+                         uint64_t target, uint64_t second_target) -> gate;
 
 public:
   static auto sort_controls(std::vector<uint64_t> &controls);
   static auto control_mask(const std::vector<uint64_t> &contrsols);
   static auto target_mask(uint64_t target);
 
+  // Toffoli gate with positive controls.
   gate(uint64_t size, std::vector<uint64_t> controls, uint64_t target);
-  gate(uint64_t size, std::mt19937_64 mrnd);
+  // Controlled swap and Peres gate, i.e. Toffoli(controls + target; second_target) followed by
+  // Toffoli(controls; target) as a single gate. Both targets have to differ from the controls.
+  static auto fredkin(uint64_t size, std::vector<uint64_t> controls, uint64_t target,
+                      uint64_t second_target) -> gate;
+  static auto peres(uint64_t size, std::vector<uint64_t> controls, uint64_t target,
+                    uint64_t second_target) -> gate;
+  // Inverse of masks().
+  static auto from_masks(uint64_t size, const gate_masks &masks) -> gate;
+  // Random gate: 0 to size - 1 controls, every line equally likely to be the target.
+  gate(uint64_t size, std::mt19937_64 &mrnd);
+  gate(uint64_t size, xoshiro256ss &rng);
+  // Controls are stored in the current_resource() of the constructing or copying thread.
+  gate(const gate &other);
+  gate(gate &&other) noexcept = default;
+  auto operator=(const gate &other) -> gate & = default;
+  auto operator=(gate &&other) noexcept -> gate & = default;
 
   [[nodiscard]] auto size() const noexcept -> uint64_t;
   [[nodiscard]] auto controls() const noexcept -> std::vector<uint64_t>;
@@ -25,8 +95,24 @@ public:
   [[nodiscard]] auto target() const noexcept -> uint64_t;
   [[nodiscard]] auto control_mask() const noexcept -> uint64_t;
   [[nodiscard]] auto target_mask() const noexcept -> uint64_t;
+  // Controls whose bit is clear here are negative. Equal to control_mask unless changed.
+  [[nodiscard]] auto polarity_mask() const noexcept -> uint64_t;
+  [[nodiscard]] auto kind() const noexcept -> gate_kind;
+  // Same as target for Toffoli gates, whose second_target_mask is 0.
+  [[nodiscard]] auto second_target() const noexcept -> uint64_t;
+  [[nodiscard]] auto second_target_mask() const noexcept -> uint64_t;
+  // Every line the gate reads or writes.
+  [[nodiscard]] auto lines_mask() const noexcept -> uint64_t;
+  [[nodiscard]] auto masks() const noexcept -> gate_masks;
+
+  // Copy matching polarity_mask on its controls, which has to be a subset of control_mask.
+  [[nodiscard]] auto with_polarity(uint64_t polarity_mask) const -> gate;
+  [[nodiscard]] auto is_self_inverse() const noexcept -> bool;
+  // Only Peres gates are not their own inverse.
+  [[nodiscard]] auto inverse() const -> gate;
 
   [[nodiscard]] auto apply(uint64_t row) const noexcept -> uint64_t;
+  [[nodiscard]] auto apply_inverse(uint64_t row) const noexcept -> uint64_t;
   auto apply(state &s) const -> void;
   auto apply_back(truth_table &tt) const -> void;
   auto apply_front(truth_table &tt) const -> void;
@@ -34,3 +120,18 @@ public:
   auto operator==(const gate &) const -> bool = default;
   auto print() const -> void;
 };
+
+// Same as calling apply_back of every gate in order, but with a single pass over the rows.
+auto apply_gates_back(const std::deque<gate> &gates, truth_table &tt) -> void;
+
+// Varint encoding of a gate on bits_num lines: varint(control_mask) varint(target) for positive
+// Toffoli gates. Every other gate sets the bit of its own target in the control mask field, which
+// no Toffoli gate has, and goes on with varint(polarity_mask) varint(kind << 6 | second_target).
+// The field is stored xored with previous_field, so a stream of gates sharing their controls can
+// delta-encode it, and returned as the previous_field of the next gate.
+auto write_gate(std::vector<uint8_t> &buffer, const gate &g, uint64_t previous_field = 0)
+    -> uint64_t;
+// Both throw std::invalid_argument on gates that do not fit bits_num lines.
+auto read_gate_masks(const uint8_t *&position, const uint8_t *end, uint64_t bits_num,
+                     uint64_t &previous_field) -> gate_masks;
+auto read_gate(const uint8_t *&position, const uint8_t *end, uint64_t bits_num) -> gate;
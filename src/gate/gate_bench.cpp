@@ -0,0 +1,43 @@
+#include "bench/bench.hpp"
+#include "gate.hpp"
+#include <random>
+
+namespace gate_bench {
+std::mt19937_64 mrnd;
+} // namespace gate_bench
+
+using namespace gate_bench;
+
+REVSYNTH_BENCH("gate/apply_back", 3, 24) {
+  auto bits = state.bits_num();
+  auto g = gate(bits, mrnd);
+  auto tt = truth_table(bits).shuffle(mrnd);
+  state.run(tt.length(), [&]() {
+    g.apply_back(tt);
+    do_not_optimize(tt);
+  });
+}
+
+REVSYNTH_BENCH("gate/apply_front", 3, 24) {
+  auto bits = state.bits_num();
+  auto g = gate(bits, mrnd);
+  auto tt = truth_table(bits).shuffle(mrnd);
+  state.run(tt.length(), [&]() {
+    g.apply_front(tt);
+    do_not_optimize(tt);
+  });
+}
+
+REVSYNTH_BENCH("gate/apply_run16", 3, 24) {
+  auto bits = state.bits_num();
+  auto gates = std::deque<gate>();
+  for (auto i = 0; i < 16; i++) {
+    gates.emplace_back(bits, mrnd);
+  }
+  auto tt = truth_table(bits).shuffle(mrnd);
+  state.run(tt.length(), [&]() {
+    apply_gates_back(gates, tt);
+    do_not_optimize(tt);
+  });
+  state.set_counter("gates", 16);
+}
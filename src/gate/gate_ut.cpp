@@ -1,5 +1,6 @@
 #include "gate.hpp"
 #include "utils/utils.hpp"
+#include <bit>
 #include <bits/fs_fwd.h>
 #include <catch2/catch_all.hpp>
 #include <catch2/catch_message.hpp>
@@ -162,3 +163,159 @@ TEST_CASE("complex gate apply", "[gate], [apply]") {
     REQUIRE(tt_forward == tt_backward);
   }
 }
+
+TEST_CASE("row-parallel gate apply", "[gate], [apply], [parallel]") {
+  std::mt19937_64 mrnd;
+  const auto size = static_cast<uint64_t>(std::countr_zero(PARALLEL_GATE_ROWS));
+  const auto gates_num = 1 + mrnd() % 8;
+
+  auto tt = truth_table(size).shuffle(mrnd);
+  auto gates = std::deque<gate>();
+  for (auto i = 0UL; i < gates_num; i++) {
+    gates.emplace_back(size, mrnd);
+  }
+
+  auto expected_back = std::vector<uint64_t>(tt.begin(), tt.end());
+  auto expected_front = expected_back;
+  for (const auto &g : gates) {
+    for (auto &row : expected_back) {
+      row = g.apply(row);
+    }
+    auto permuted = expected_front;
+    for (auto index = 0UL; index < permuted.size(); index++) {
+      permuted[index] = expected_front[g.apply(index)];
+    }
+    expected_front = permuted;
+  }
+
+  auto back = tt;
+  auto front = tt;
+  for (const auto &g : gates) {
+    g.apply_back(back);
+    g.apply_front(front);
+  }
+  REQUIRE(std::ranges::equal(back, expected_back));
+  REQUIRE(std::ranges::equal(front, expected_front));
+
+  auto run = tt;
+  apply_gates_back(gates, run);
+  REQUIRE(run == back);
+}
+
+namespace gate_ut {
+
+// Random gate of any kind with random control polarities.
+auto random_mixed_gate(uint64_t size, std::mt19937_64 &mrnd) -> gate {
+  auto kind = size < 2 ? 0 : mrnd() % 4;
+  auto taps = random_unique_vector(mrnd() % size + 1, size, mrnd);
+  if (kind == 0 || taps.size() < 2) {
+    auto target = taps.back();
+    taps.pop_back();
+    auto g = gate(size, taps, target);
+    return g.with_polarity(mrnd() & g.control_mask());
+  }
+  auto second_target = taps.back();
+  taps.pop_back();
+  auto target = taps.back();
+  taps.pop_back();
+  auto g = kind == 1 ? gate::fredkin(size, taps, target, second_target)
+                     : gate::peres(size, taps, target, second_target);
+  g = g.with_polarity(mrnd() & g.control_mask());
+  return kind == 3 ? g.inverse() : g;
+}
+
+} // namespace gate_ut
+
+TEST_CASE("mixed polarity, Fredkin and Peres gates", "[gate], [apply], [polarity]") {
+  SECTION("truth tables") {
+    // lines a = 2, b = 1, c = 0 with the first declared line most significant
+    auto negative = gate(3, {2, 1}, 0).with_polarity(0b100);
+    auto fredkin = gate::fredkin(3, {2}, 1, 0);
+    auto peres = gate::peres(3, {2}, 1, 0);
+    for (auto row = 0UL; row < 8; row++) {
+      auto a = row >> 2 & 1UL;
+      auto b = row >> 1 & 1UL;
+      auto c = row & 1UL;
+      REQUIRE(negative.apply(row) == (a == 1 && b == 0 ? row ^ 1UL : row));
+      REQUIRE(fredkin.apply(row) == (a == 1 ? a << 2 | c << 1 | b : row));
+      REQUIRE(peres.apply(row) == (a << 2 | (a ^ b) << 1 | (c ^ (a & b))));
+      REQUIRE(peres.inverse().apply(peres.apply(row)) == row);
+      REQUIRE(peres.apply_inverse(peres.apply(row)) == row);
+    }
+    REQUIRE(peres.is_self_inverse() == false);
+    REQUIRE(peres.inverse().inverse() == peres);
+    REQUIRE(fredkin.lines_mask() == 0b111);
+    REQUIRE_THROWS_AS(gate(3, {1}, 0).with_polarity(0b100), std::invalid_argument);
+    REQUIRE_THROWS_AS(gate::fredkin(3, {1}, 1, 0), std::invalid_argument);
+    REQUIRE_THROWS_AS(gate::peres(3, {}, 2, 2), std::invalid_argument);
+
+    auto buffer = std::vector<uint8_t>();
+    write_gate(buffer, gate::fredkin(4, {3}, 1, 0).with_polarity(0));
+    const auto *position = buffer.data();
+    REQUIRE_THROWS_AS(read_gate(position, buffer.data() + buffer.size(), 3),
+                      std::invalid_argument);
+  }
+
+  std::mt19937_64 mrnd;
+  const auto size = static_cast<uint64_t>(GENERATE(take(EPOCHS / 10, random(1, max_size))));
+  auto tested = random_mixed_gate(size, mrnd);
+
+  SECTION("kernels") {
+    auto back = truth_table(size).shuffle(mrnd);
+    auto front = back;
+    auto expected_back = back;
+    auto expected_front = back;
+    for (auto index = 0UL; index < back.length(); index++) {
+      expected_back[index] = tested.apply(back[index]);
+      expected_front[index] = back[tested.apply(index)];
+    }
+    tested.apply_back(back);
+    tested.apply_front(front);
+    REQUIRE(back == expected_back);
+    REQUIRE(front == expected_front);
+    REQUIRE(gate::from_masks(size, tested.masks()) == tested);
+  }
+
+  SECTION("encoding") {
+    auto buffer = std::vector<uint8_t>();
+    auto other = random_mixed_gate(size, mrnd);
+    auto field = write_gate(buffer, tested);
+    write_gate(buffer, other, field);
+    const auto *position = buffer.data();
+    auto previous_field = 0UL;
+    REQUIRE(gate::from_masks(size, read_gate_masks(position, buffer.data() + buffer.size(), size,
+                                                   previous_field)) == tested);
+    REQUIRE(gate::from_masks(size, read_gate_masks(position, buffer.data() + buffer.size(), size,
+                                                   previous_field)) == other);
+    REQUIRE(position == buffer.data() + buffer.size());
+  }
+}
+
+TEST_CASE("row-parallel kernels of every gate kind", "[gate], [apply], [parallel], [polarity]") {
+  std::mt19937_64 mrnd(7);
+  const auto size = static_cast<uint64_t>(std::countr_zero(PARALLEL_GATE_ROWS));
+
+  auto tt = truth_table(size).shuffle(mrnd);
+  auto gates = std::deque<gate>();
+  for (auto i = 0UL; i < 8; i++) {
+    gates.push_back(random_mixed_gate(size, mrnd));
+  }
+
+  auto expected = std::vector<uint64_t>(tt.begin(), tt.end());
+  auto back = tt;
+  for (const auto &g : gates) {
+    for (auto &row : expected) {
+      row = g.apply(row);
+    }
+    g.apply_back(back);
+    auto front = back;
+    g.inverse().apply_front(front);
+    g.apply_front(front);
+    REQUIRE(front == back);
+  }
+  REQUIRE(std::ranges::equal(back, expected));
+
+  auto run = tt;
+  apply_gates_back(gates, run);
+  REQUIRE(run == back);
+}
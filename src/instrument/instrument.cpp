@@ -0,0 +1,222 @@
+#include "instrument.hpp"
+#include "utils/utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace instrument {
+
+namespace {
+
+struct trace_event {
+  const char *name;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+};
+
+struct aggregate {
+  uint64_t calls = 0;
+  uint64_t total_ns = 0;
+};
+
+// Counters are added to by the owning thread and cleared by reset from any thread, so updates
+// are relaxed fetch_adds, which neither lose nor reapply an increment racing with a reset.
+struct thread_data {
+  uint64_t thread_id;
+  std::array<std::atomic<uint64_t>, COUNTERS_NUM> counters{};
+  std::mutex mutex;
+  std::vector<trace_event> events;
+  std::unordered_map<const char *, aggregate> timers;
+  uint64_t dropped_events = 0;
+};
+
+struct registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<thread_data>> live;
+  std::array<uint64_t, COUNTERS_NUM> retired_counters{};
+  std::map<std::string, aggregate> retired_timers;
+  std::vector<std::pair<uint64_t, trace_event>> retired_events;
+  uint64_t retired_dropped = 0;
+  uint64_t next_thread_id = 1;
+};
+
+auto global() -> registry & {
+  static auto instance = registry();
+  return instance;
+}
+
+auto now_ns() -> uint64_t {
+  static const auto epoch = std::chrono::steady_clock::now();
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - epoch)
+                                   .count());
+}
+
+template <typename Map>
+auto merge(std::map<std::string, aggregate> &into, const Map &from) -> void {
+  for (const auto &[name, stats] : from) {
+    into[name].calls += stats.calls;
+    into[name].total_ns += stats.total_ns;
+  }
+}
+
+// Registers the thread on first use and folds its data into the retired totals on exit.
+class thread_slot {
+  std::shared_ptr<thread_data> data_;
+
+public:
+  thread_slot() : data_(std::make_shared<thread_data>()) {
+    auto &reg = global();
+    auto lock = std::lock_guard(reg.mutex);
+    data_->thread_id = reg.next_thread_id++;
+    reg.live.push_back(data_);
+  }
+  thread_slot(const thread_slot &) = delete;
+  auto operator=(const thread_slot &) -> thread_slot & = delete;
+
+  ~thread_slot() {
+    auto &reg = global();
+    auto lock = std::lock_guard(reg.mutex);
+    auto data_lock = std::lock_guard(data_->mutex);
+    for (auto i = 0UL; i < COUNTERS_NUM; i++) {
+      reg.retired_counters[i] += data_->counters[i].load(std::memory_order_relaxed);
+    }
+    merge(reg.retired_timers, data_->timers);
+    for (const auto &event : data_->events) {
+      reg.retired_events.emplace_back(data_->thread_id, event);
+    }
+    reg.retired_dropped += data_->dropped_events;
+    std::erase(reg.live, data_);
+  }
+
+  [[nodiscard]] auto data() -> thread_data & { return *data_; }
+};
+
+auto local() -> thread_data & {
+  thread_local auto slot = thread_slot();
+  return slot.data();
+}
+
+const auto COUNTER_NAMES = std::array<std::string_view, COUNTERS_NUM>{
+    "rows_processed",  "gates_first_row", "gates_01",
+    "gates_10",        "gate_rows_touched", "table_copies",
+    "tables_composed", "tables_inverted", "circuit_gates_pushed",
+    "circuit_gates_popped",
+};
+
+} // namespace
+
+auto counter_name(counter c) -> std::string_view {
+  return COUNTER_NAMES[static_cast<uint64_t>(c)];
+}
+
+auto add(counter c, uint64_t value) -> void {
+  local().counters[static_cast<uint64_t>(c)].fetch_add(value, std::memory_order_relaxed);
+}
+
+auto report::operator[](counter c) const -> uint64_t {
+  return counters[static_cast<uint64_t>(c)];
+}
+
+auto snapshot() -> report {
+  auto &reg = global();
+  auto lock = std::lock_guard(reg.mutex);
+  auto result = report{reg.retired_counters, {}, reg.retired_dropped};
+  auto timers = reg.retired_timers;
+  for (const auto &data : reg.live) {
+    for (auto i = 0UL; i < COUNTERS_NUM; i++) {
+      result.counters[i] += data->counters[i].load(std::memory_order_relaxed);
+    }
+    auto data_lock = std::lock_guard(data->mutex);
+    merge(timers, data->timers);
+    result.dropped_events += data->dropped_events;
+  }
+  for (const auto &[name, stats] : timers) {
+    result.timers.push_back({name, stats.calls, stats.total_ns});
+  }
+  return result;
+}
+
+auto reset() -> void {
+  auto &reg = global();
+  auto lock = std::lock_guard(reg.mutex);
+  reg.retired_counters = {};
+  reg.retired_timers.clear();
+  reg.retired_events.clear();
+  reg.retired_dropped = 0;
+  for (const auto &data : reg.live) {
+    for (auto &c : data->counters) {
+      c.store(0, std::memory_order_relaxed);
+    }
+    auto data_lock = std::lock_guard(data->mutex);
+    data->events.clear();
+    data->timers.clear();
+    data->dropped_events = 0;
+  }
+}
+
+auto write_report_json(std::ostream &out) -> void {
+  auto r = snapshot();
+  out << "{\"enabled\": " << (enabled() ? "true" : "false") << ", \"counters\": {";
+  for (auto i = 0UL; i < COUNTERS_NUM; i++) {
+    out << (i == 0 ? "" : ", ") << json_string(COUNTER_NAMES[i]) << ": " << r.counters[i];
+  }
+  out << "}, \"timers\": [";
+  for (auto i = 0UL; i < r.timers.size(); i++) {
+    out << (i == 0 ? "" : ", ") << "{\"name\": " << json_string(r.timers[i].name)
+        << ", \"calls\": " << r.timers[i].calls << ", \"total_ns\": " << r.timers[i].total_ns
+        << "}";
+  }
+  out << "], \"dropped_events\": " << r.dropped_events << "}\n";
+}
+
+auto write_chrome_trace(std::ostream &out) -> void {
+  auto events = std::vector<std::pair<uint64_t, trace_event>>();
+  {
+    auto &reg = global();
+    auto lock = std::lock_guard(reg.mutex);
+    events = reg.retired_events;
+    for (const auto &data : reg.live) {
+      auto data_lock = std::lock_guard(data->mutex);
+      for (const auto &event : data->events) {
+        events.emplace_back(data->thread_id, event);
+      }
+    }
+  }
+  std::sort(events.begin(), events.end(), [](const auto &lhs, const auto &rhs) {
+    return lhs.second.start_ns < rhs.second.start_ns;
+  });
+
+  out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  for (auto i = 0UL; i < events.size(); i++) {
+    const auto &[tid, event] = events[i];
+    out << (i == 0 ? "\n" : ",\n") << "{\"name\": " << json_string(event.name)
+        << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid
+        << ", \"ts\": " << static_cast<double>(event.start_ns) / 1000.0
+        << ", \"dur\": " << static_cast<double>(event.duration_ns) / 1000.0 << "}";
+  }
+  out << "\n]}\n";
+}
+
+scoped_timer::scoped_timer(const char *name) noexcept : name_(name), start_ns_(now_ns()) {}
+
+scoped_timer::~scoped_timer() {
+  auto duration = now_ns() - start_ns_;
+  auto &data = local();
+  auto lock = std::lock_guard(data.mutex);
+  auto &stats = data.timers[name_];
+  stats.calls++;
+  stats.total_ns += duration;
+  if (data.events.size() < MAX_TRACE_EVENTS) {
+    data.events.push_back({name_, start_ns_, duration});
+  }
+  else {
+    data.dropped_events++;
+  }
+}
+
+} // namespace instrument
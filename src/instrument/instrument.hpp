@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Hot path counters and scoped timers. The REVSYNTH_COUNT and REVSYNTH_SCOPE macros expand to
+// nothing unless the build defines REVSYNTH_INSTRUMENT (cmake -DREVSYNTH_INSTRUMENT=ON), so
+// regular builds pay nothing. Every thread counts into its own slots, a snapshot sums the live
+// threads with the ones that already exited.
+
+namespace instrument {
+
+enum class counter : uint8_t {
+  rows_processed,
+  gates_first_row,
+  gates_01,
+  gates_10,
+  gate_rows_touched,
+  table_copies,
+  tables_composed,
+  tables_inverted,
+  circuit_gates_pushed,
+  circuit_gates_popped,
+};
+const auto COUNTERS_NUM = static_cast<uint64_t>(counter::circuit_gates_popped) + 1;
+
+[[nodiscard]] constexpr auto enabled() noexcept -> bool {
+#ifdef REVSYNTH_INSTRUMENT
+  return true;
+#else
+  return false;
+#endif
+}
+
+[[nodiscard]] auto counter_name(counter c) -> std::string_view;
+
+// Registers the calling thread on its first call, which allocates and may throw.
+auto add(counter c, uint64_t value) -> void;
+
+struct timer_stats {
+  std::string name;
+  uint64_t calls;
+  uint64_t total_ns;
+};
+
+struct report {
+  std::array<uint64_t, COUNTERS_NUM> counters;
+  std::vector<timer_stats> timers;
+  uint64_t dropped_events;
+
+  [[nodiscard]] auto operator[](counter c) const -> uint64_t;
+};
+
+[[nodiscard]] auto snapshot() -> report;
+auto reset() -> void;
+
+// {"counters": {...}, "timers": [{"name", "calls", "total_ns"}, ...]}
+auto write_report_json(std::ostream &out) -> void;
+// Complete ("X") events of every timed scope, loadable in chrome://tracing or Perfetto.
+// Each thread keeps at most MAX_TRACE_EVENTS, later scopes are only aggregated.
+auto write_chrome_trace(std::ostream &out) -> void;
+
+const auto MAX_TRACE_EVENTS = 1UL << 20;
+
+// Records the lifetime of a scope. name has to outlive the report, in practice a literal.
+class scoped_timer {
+  const char *name_;
+  uint64_t start_ns_;
+
+public:
+  explicit scoped_timer(const char *name) noexcept;
+  scoped_timer(const scoped_timer &) = delete;
+  auto operator=(const scoped_timer &) -> scoped_timer & = delete;
+  ~scoped_timer();
+};
+
+} // namespace instrument
+
+#define REVSYNTH_INSTRUMENT_CONCAT_(a, b) a##b
+#define REVSYNTH_INSTRUMENT_CONCAT(a, b) REVSYNTH_INSTRUMENT_CONCAT_(a, b)
+
+#ifdef REVSYNTH_INSTRUMENT
+#define REVSYNTH_COUNT(name, value) ::instrument::add(::instrument::counter::name, (value))
+#define REVSYNTH_SCOPE(name)                                                                       \
+  const ::instrument::scoped_timer REVSYNTH_INSTRUMENT_CONCAT(revsynth_scope_, __LINE__)(name)
+#else
+#define REVSYNTH_COUNT(name, value) ((void)0)
+#define REVSYNTH_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,74 @@
+#include "instrument.hpp"
+#include "circuit/circuit.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace instrument_ut {
+const auto EPOCHS = 20;
+const auto max_bits = 8;
+std::mt19937_64 mrnd;
+} // namespace instrument_ut
+
+using namespace instrument_ut;
+
+TEST_CASE("instrument counters and timers", "[instrument]") {
+  instrument::reset();
+
+  SECTION("counters sum over threads, including exited ones") {
+    instrument::add(instrument::counter::rows_processed, 3);
+    auto worker = std::thread([]() { instrument::add(instrument::counter::rows_processed, 4); });
+    worker.join();
+    REQUIRE(instrument::snapshot()[instrument::counter::rows_processed] == 7);
+
+    instrument::reset();
+    REQUIRE(instrument::snapshot()[instrument::counter::rows_processed] == 0);
+  }
+
+  SECTION("timers aggregate and trace") {
+    for (auto i = 0; i < 3; i++) {
+      auto timer = instrument::scoped_timer("ut/scope");
+    }
+    auto r = instrument::snapshot();
+    REQUIRE(r.timers.size() == 1);
+    REQUIRE(r.timers.front().name == "ut/scope");
+    REQUIRE(r.timers.front().calls == 3);
+
+    auto trace = std::ostringstream();
+    instrument::write_chrome_trace(trace);
+    REQUIRE(trace.str().find("\"name\": \"ut/scope\", \"ph\": \"X\"") != std::string::npos);
+
+    auto report = std::ostringstream();
+    instrument::write_report_json(report);
+    REQUIRE(report.str().find("\"calls\": 3") != std::string::npos);
+  }
+}
+
+TEST_CASE("instrumented mmd03", "[instrument], [mmd03]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  auto target = truth_table(bits).shuffle(mrnd);
+
+  instrument::reset();
+  auto circ = mmd03().synthesize(target);
+  auto r = instrument::snapshot();
+
+  if constexpr (instrument::enabled()) {
+    using instrument::counter;
+    REQUIRE(r[counter::rows_processed] == target.length());
+    REQUIRE(r[counter::gates_first_row] + r[counter::gates_01] + r[counter::gates_10] ==
+            circ.gates_num());
+    REQUIRE(r[counter::circuit_gates_pushed] == circ.gates_num());
+    // tables of up to small_perm::MAX_BITS lines are synthesised without touching gate rows
+    REQUIRE(r[counter::gate_rows_touched] ==
+            (bits > small_perm::MAX_BITS ? 2 * circ.gates_num() * target.length() : 0));
+    REQUIRE(r.timers.size() == 2);
+  }
+  else {
+    REQUIRE(std::all_of(r.counters.begin(), r.counters.end(), [](auto c) { return c == 0; }));
+    REQUIRE(r.timers.empty());
+  }
+}
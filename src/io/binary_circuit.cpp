@@ -0,0 +1,318 @@
+#include "binary_circuit.hpp"
+#include "parallel/parallel.hpp"
+#include "utils/utils.hpp"
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const auto MAGIC = std::string_view("RSCIRC01");
+const auto HEADER_FIELDS = 5UL;
+const auto HEADER_SIZE = MAGIC.size() + HEADER_FIELDS * sizeof(uint64_t);
+const auto INDEX_ENTRY_SIZE = 2 * sizeof(uint64_t);
+
+auto io_error(const std::string &what) -> std::runtime_error {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+auto load_u64(const uint8_t *position) -> uint64_t {
+  auto value = uint64_t();
+  std::memcpy(&value, position, sizeof(value));
+  return value;
+}
+
+auto store_u64(std::vector<uint8_t> &buffer, uint64_t value) -> void {
+  auto bytes = std::bit_cast<std::array<uint8_t, sizeof(value)>>(value);
+  buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+}
+
+auto checksum(const uint8_t *data, uint64_t size) -> uint64_t {
+  auto hash = 0x9E3779B97F4A7C15UL ^ size;
+  auto absorb = [&hash](uint64_t word) {
+    hash = std::rotl(hash ^ (word * 0xFF51AFD7ED558CCDUL), 31) * 0xC4CEB9FE1A85EC53UL;
+  };
+  auto i = 0UL;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    absorb(load_u64(data + i));
+  }
+  auto tail = 0UL;
+  std::memcpy(&tail, data + i, size - i);
+  absorb(tail);
+  return hash ^ (hash >> 29);
+}
+
+} // namespace
+
+auto packed_gate::apply(uint64_t row) const noexcept -> uint64_t { return masks.apply(row); }
+
+auto packed_gate::to_gate(uint64_t bits_num) const -> gate {
+  return gate::from_masks(bits_num, masks);
+}
+
+binary_circuit_writer::binary_circuit_writer(const std::filesystem::path &path,
+                                             uint64_t bits_num, uint64_t block_gates)
+    : out_(path, std::ios::binary | std::ios::trunc), bits_num_(bits_num),
+      block_gates_(block_gates), offset_(HEADER_SIZE) {
+  if (bits_num_ == 0 || bits_num_ > 64 || block_gates_ == 0) {
+    throw std::invalid_argument("Invalid binary circuit parameters");
+  }
+  if (!out_) {
+    throw std::runtime_error("Cannot create " + path.string());
+  }
+  auto placeholder = std::array<char, HEADER_SIZE>();
+  out_.write(placeholder.data(), placeholder.size());
+}
+
+auto binary_circuit_writer::operator()(const gate &g) -> void {
+  assert(g.size() == bits_num_);
+  previous_mask_ = write_gate(block_, g, previous_mask_);
+  gates_num_++;
+  if (gates_num_ % block_gates_ == 0) {
+    flush_block();
+  }
+}
+
+auto binary_circuit_writer::flush_block() -> void {
+  store_u64(index_, offset_);
+  store_u64(index_, checksum(block_.data(), block_.size()));
+  out_.write(reinterpret_cast<const char *>(block_.data()),
+             static_cast<std::streamsize>(block_.size()));
+  offset_ += block_.size();
+  block_.clear();
+  previous_mask_ = 0;
+}
+
+auto binary_circuit_writer::finish() -> void {
+  if (gates_num_ % block_gates_ != 0) {
+    flush_block();
+  }
+  out_.write(reinterpret_cast<const char *>(index_.data()),
+             static_cast<std::streamsize>(index_.size()));
+
+  auto header = std::vector<uint8_t>(MAGIC.begin(), MAGIC.end());
+  store_u64(header, bits_num_);
+  store_u64(header, gates_num_);
+  store_u64(header, block_gates_);
+  store_u64(header, offset_);
+  store_u64(header, checksum(index_.data(), index_.size()));
+  out_.seekp(0);
+  out_.write(reinterpret_cast<const char *>(header.data()),
+             static_cast<std::streamsize>(header.size()));
+  out_.flush();
+  if (!out_) {
+    throw std::runtime_error("Cannot write binary circuit");
+  }
+}
+
+auto write_binary(const std::filesystem::path &path, const circuit &circ, uint64_t block_gates)
+    -> void {
+  auto writer = binary_circuit_writer(path, circ.bits_num(), block_gates);
+  for (const auto &g : circ.gates()) {
+    writer(g);
+  }
+  writer.finish();
+}
+
+gate_cursor::gate_cursor(const uint8_t *position, const uint8_t *end, uint64_t bits_num,
+                         uint64_t block_gates, uint64_t left)
+    : position_(position), end_(end), bits_num_(bits_num),
+      block_gates_(block_gates), left_(left), in_block_(0) {}
+
+auto gate_cursor::gates_left() const noexcept -> uint64_t { return left_; }
+
+auto gate_cursor::next(packed_gate &g) -> bool {
+  if (left_ == 0) {
+    return false;
+  }
+  if (in_block_ == block_gates_) {
+    in_block_ = 0;
+    previous_mask_ = 0;
+  }
+  g.masks = read_gate_masks(position_, end_, bits_num_, previous_mask_);
+  in_block_++;
+  left_--;
+  return true;
+}
+
+binary_circuit_reader::binary_circuit_reader(const std::filesystem::path &path)
+    : fd_(::open(path.c_str(), O_RDONLY | O_CLOEXEC)), map_(nullptr), map_size_(0) {
+  if (fd_ < 0) {
+    throw io_error("Cannot open binary circuit " + path.string());
+  }
+  struct stat info {};
+  if (::fstat(fd_, &info) != 0) {
+    ::close(fd_);
+    throw io_error("Cannot stat binary circuit " + path.string());
+  }
+  map_size_ = static_cast<uint64_t>(info.st_size);
+  if (map_size_ < HEADER_SIZE) {
+    ::close(fd_);
+    throw std::invalid_argument("File is not a binary circuit: " + path.string());
+  }
+  auto mapped = ::mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    ::close(fd_);
+    throw io_error("Cannot map binary circuit " + path.string());
+  }
+  map_ = static_cast<const uint8_t *>(mapped);
+
+  auto field = [this](uint64_t i) {
+    return load_u64(map_ + MAGIC.size() + i * sizeof(uint64_t));
+  };
+  bits_num_ = field(0);
+  gates_num_ = field(1);
+  block_gates_ = field(2);
+  auto index_offset = field(3);
+  auto index_checksum = field(4);
+  blocks_num_ = block_gates_ == 0 ? 0 : (gates_num_ + block_gates_ - 1) / block_gates_;
+  index_ = map_ + index_offset;
+
+  auto valid = std::memcmp(map_, MAGIC.data(), MAGIC.size()) == 0 && bits_num_ > 0 &&
+               bits_num_ <= 64 && block_gates_ > 0 && index_offset >= HEADER_SIZE &&
+               index_offset <= map_size_ &&
+               (map_size_ - index_offset) == blocks_num_ * INDEX_ENTRY_SIZE &&
+               checksum(index_, blocks_num_ * INDEX_ENTRY_SIZE) == index_checksum;
+  for (auto block = 0UL; valid && block < blocks_num_; block++) {
+    valid = block_offset(block) <= block_end(block) && block_end(block) <= index_offset &&
+            block_offset(block) >= HEADER_SIZE;
+  }
+  if (!valid) {
+    ::munmap(const_cast<uint8_t *>(map_), map_size_);
+    ::close(fd_);
+    throw std::invalid_argument("File is not a valid binary circuit: " + path.string());
+  }
+}
+
+binary_circuit_reader::~binary_circuit_reader() {
+  ::munmap(const_cast<uint8_t *>(map_), map_size_);
+  ::close(fd_);
+}
+
+auto binary_circuit_reader::block_offset(uint64_t block) const -> uint64_t {
+  return load_u64(index_ + block * INDEX_ENTRY_SIZE);
+}
+
+auto binary_circuit_reader::block_end(uint64_t block) const -> uint64_t {
+  return block + 1 < blocks_num_ ? block_offset(block + 1)
+                                 : static_cast<uint64_t>(index_ - map_);
+}
+
+auto binary_circuit_reader::bits_num() const noexcept -> uint64_t { return bits_num_; }
+
+auto binary_circuit_reader::gates_num() const noexcept -> uint64_t { return gates_num_; }
+
+auto binary_circuit_reader::blocks_num() const noexcept -> uint64_t { return blocks_num_; }
+
+auto binary_circuit_reader::block_valid(uint64_t block) const -> bool {
+  auto stored = load_u64(index_ + block * INDEX_ENTRY_SIZE + sizeof(uint64_t));
+  return checksum(map_ + block_offset(block), block_end(block) - block_offset(block)) == stored;
+}
+
+auto binary_circuit_reader::check_block(uint64_t block) const -> void {
+  if (!block_valid(block)) {
+    throw std::invalid_argument("Block " + std::to_string(block) +
+                                " of binary circuit fails its checksum");
+  }
+}
+
+auto binary_circuit_reader::verify() const -> bool {
+  for (auto block = 0UL; block < blocks_num_; block++) {
+    if (!block_valid(block)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto binary_circuit_reader::cursor(uint64_t first_gate) const -> gate_cursor {
+  if (first_gate > gates_num_) {
+    throw std::out_of_range("Gate index out of range");
+  }
+  if (first_gate == gates_num_) {
+    return {map_, map_, bits_num_, block_gates_, 0};
+  }
+  auto block = first_gate / block_gates_;
+  auto position = map_ + block_offset(block);
+  auto end = map_ + block_end(blocks_num_ - 1);
+  auto cur = gate_cursor(position, end, bits_num_, block_gates_,
+                         gates_num_ - block * block_gates_);
+  auto skipped = packed_gate();
+  for (auto i = block * block_gates_; i < first_gate; i++) {
+    cur.next(skipped);
+  }
+  return cur;
+}
+
+auto binary_circuit_reader::operator[](uint64_t index) const -> gate {
+  auto cur = cursor(index);
+  auto g = packed_gate();
+  if (!cur.next(g)) {
+    throw std::out_of_range("Gate index out of range");
+  }
+  return g.to_gate(bits_num_);
+}
+
+auto binary_circuit_reader::apply(uint64_t row) const -> uint64_t {
+  auto cur = cursor();
+  auto g = packed_gate();
+  while (cur.next(g)) {
+    row = g.apply(row);
+  }
+  return row;
+}
+
+auto binary_circuit_reader::apply_back(truth_table &tt) const -> void {
+  if (tt.size() != bits_num_) {
+    throw std::invalid_argument("Truth table and circuit sizes differ");
+  }
+  // Decodes one block at a time and runs every row through it, so the table is swept once per
+  // block rather than once per gate.
+  auto cur = cursor();
+  auto block = std::vector<packed_gate>();
+  block.reserve(block_gates_);
+  for (auto block_index = 0UL; cur.gates_left() > 0; block_index++) {
+    check_block(block_index);
+    block.clear();
+    auto g = packed_gate();
+    while (block.size() < block_gates_ && cur.next(g)) {
+      block.push_back(g);
+    }
+    auto apply_rows = [&](uint64_t begin, uint64_t end) {
+      for (auto index = begin; index < end; index++) {
+        auto row = tt[index];
+        for (const auto &bg : block) {
+          row = bg.apply(row);
+        }
+        tt[index] = row;
+      }
+    };
+    if (tt.length() >= PARALLEL_GATE_ROWS) {
+      parallel_for_chunks(0, tt.length(), GATE_CHUNK_ROWS, 0, apply_rows);
+    }
+    else {
+      apply_rows(0, tt.length());
+    }
+  }
+}
+
+auto binary_circuit_reader::to_circuit() const -> circuit {
+  auto gates = std::deque<gate>();
+  auto cur = cursor();
+  auto g = packed_gate();
+  for (auto i = 0UL; i < gates_num_; i++) {
+    if (i % block_gates_ == 0) {
+      check_block(i / block_gates_);
+    }
+    cur.next(g);
+    gates.push_back(g.to_gate(bits_num_));
+  }
+  return {bits_num_, std::move(gates)};
+}
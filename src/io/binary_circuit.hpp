@@ -0,0 +1,107 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "truth_table/truth_table.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// Binary circuit file, little endian:
+//   header  magic "RSCIRC01", bits_num, gates_num, block_gates, index_offset, index_checksum
+//   blocks  block_gates gates each (the last one may be shorter), a gate being written by
+//           write_gate with the control mask field of the previous gate; the previous field
+//           starts from 0 in every block so each block decodes on its own
+//   index   per block its file offset and checksum
+// Consecutive MMD gates mostly share their controls, so the xor delta usually fits a byte.
+
+const auto DEFAULT_BLOCK_GATES = 4096UL;
+
+struct packed_gate {
+  gate_masks masks;
+
+  [[nodiscard]] auto apply(uint64_t row) const noexcept -> uint64_t;
+  [[nodiscard]] auto to_gate(uint64_t bits_num) const -> gate;
+};
+
+// Streams gates into a file, usable as a gate_sink. The header is only written by finish, so an
+// unfinished file is never mistaken for a complete one.
+class binary_circuit_writer {
+  std::ofstream out_;
+  uint64_t bits_num_;
+  uint64_t block_gates_;
+  uint64_t gates_num_ = 0;
+  uint64_t offset_;
+  uint64_t previous_mask_ = 0;
+  std::vector<uint8_t> block_;
+  std::vector<uint8_t> index_;
+
+  auto flush_block() -> void;
+
+public:
+  binary_circuit_writer(const std::filesystem::path &path, uint64_t bits_num,
+                        uint64_t block_gates = DEFAULT_BLOCK_GATES);
+
+  auto operator()(const gate &g) -> void;
+  auto finish() -> void;
+};
+
+auto write_binary(const std::filesystem::path &path, const circuit &circ,
+                  uint64_t block_gates = DEFAULT_BLOCK_GATES) -> void;
+
+// Sequential decoder over the mapped blocks.
+class gate_cursor {
+  const uint8_t *position_;
+  const uint8_t *end_;
+  uint64_t bits_num_;
+  uint64_t block_gates_;
+  uint64_t left_;
+  uint64_t in_block_;
+  uint64_t previous_mask_ = 0;
+
+public:
+  gate_cursor(const uint8_t *position, const uint8_t *end, uint64_t bits_num,
+              uint64_t block_gates, uint64_t left);
+
+  [[nodiscard]] auto gates_left() const noexcept -> uint64_t;
+  auto next(packed_gate &g) -> bool;
+};
+
+// Read-only memory map of a binary circuit file. Gates are decoded on the fly, the block index
+// gives random access without touching earlier blocks.
+class binary_circuit_reader {
+  int fd_;
+  const uint8_t *map_;
+  uint64_t map_size_;
+  uint64_t bits_num_;
+  uint64_t gates_num_;
+  uint64_t block_gates_;
+  uint64_t blocks_num_;
+  const uint8_t *index_;
+
+  [[nodiscard]] auto block_offset(uint64_t block) const -> uint64_t;
+  [[nodiscard]] auto block_end(uint64_t block) const -> uint64_t;
+  [[nodiscard]] auto block_valid(uint64_t block) const -> bool;
+  auto check_block(uint64_t block) const -> void;
+
+public:
+  explicit binary_circuit_reader(const std::filesystem::path &path);
+  binary_circuit_reader(const binary_circuit_reader &) = delete;
+  auto operator=(const binary_circuit_reader &) -> binary_circuit_reader & = delete;
+  ~binary_circuit_reader();
+
+  [[nodiscard]] auto bits_num() const noexcept -> uint64_t;
+  [[nodiscard]] auto gates_num() const noexcept -> uint64_t;
+  [[nodiscard]] auto blocks_num() const noexcept -> uint64_t;
+
+  // Recomputes the checksum of every block.
+  [[nodiscard]] auto verify() const -> bool;
+
+  // Random access decodes without checksums, verify first where that matters.
+  [[nodiscard]] auto cursor(uint64_t first_gate = 0) const -> gate_cursor;
+  [[nodiscard]] auto operator[](uint64_t index) const -> gate;
+  [[nodiscard]] auto apply(uint64_t row) const -> uint64_t;
+
+  // Check every block before decoding it, throwing std::invalid_argument on a bad checksum.
+  auto apply_back(truth_table &tt) const -> void;
+  [[nodiscard]] auto to_circuit() const -> circuit;
+};
@@ -0,0 +1,139 @@
+#include "binary_circuit.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace binary_circuit_ut {
+const auto EPOCHS = 100;
+const auto max_bits = 12;
+std::mt19937_64 mrnd;
+
+auto temp_path() -> std::filesystem::path {
+  return std::filesystem::temp_directory_path() /
+         ("binary_circuit_ut_" + std::to_string(mrnd()) + ".rsc");
+}
+} // namespace binary_circuit_ut
+
+using namespace binary_circuit_ut;
+
+TEST_CASE("binary circuit round trip", "[binary_circuit]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  const auto gates_num = mrnd() % 300;
+  const auto block_gates = 1 + mrnd() % 64;
+  auto circ = circuit(bits, gates_num, mrnd);
+  auto path = temp_path();
+
+  write_binary(path, circ, block_gates);
+  {
+    auto reader = binary_circuit_reader(path);
+    REQUIRE(reader.bits_num() == bits);
+    REQUIRE(reader.gates_num() == gates_num);
+    REQUIRE(reader.blocks_num() == (gates_num + block_gates - 1) / block_gates);
+    REQUIRE(reader.verify());
+    REQUIRE(reader.to_circuit() == circ);
+
+    SECTION("random access") {
+      for (auto i = 0UL; i < 16 && gates_num > 0; i++) {
+        auto index = mrnd() % gates_num;
+        REQUIRE(reader[index] == circ[index]);
+      }
+      REQUIRE_THROWS_AS(reader[gates_num], std::out_of_range);
+    }
+
+    SECTION("applications without decoding to gates") {
+      auto tt = truth_table(bits).shuffle(mrnd);
+      auto expected = tt;
+      circ.apply_back(expected);
+      reader.apply_back(tt);
+      REQUIRE(tt == expected);
+
+      auto row = mrnd() % (1UL << bits);
+      REQUIRE(reader.apply(row) == circ.apply(row));
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("binary circuit damage", "[binary_circuit]") {
+  auto circ = circuit(8, 1000, mrnd);
+  auto path = temp_path();
+  write_binary(path, circ, 100);
+  auto size = std::filesystem::file_size(path);
+
+  SECTION("flipped block byte fails verification") {
+    {
+      auto file = std::fstream(path, std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(100);
+      file.put('\x7f');
+    }
+    auto reader = binary_circuit_reader(path);
+    REQUIRE_FALSE(reader.verify());
+    REQUIRE_THROWS_AS(reader.to_circuit(), std::invalid_argument);
+    auto tt = truth_table(8);
+    REQUIRE_THROWS_AS(reader.apply_back(tt), std::invalid_argument);
+  }
+
+  SECTION("truncated file is rejected") {
+    std::filesystem::resize_file(path, size - 1);
+    REQUIRE_THROWS_AS(binary_circuit_reader(path), std::invalid_argument);
+  }
+
+  SECTION("unfinished writer leaves no valid file") {
+    {
+      auto writer = binary_circuit_writer(path, 8);
+      writer(gate(8, mrnd));
+    }
+    REQUIRE_THROWS_AS(binary_circuit_reader(path), std::invalid_argument);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("binary circuit is compact", "[binary_circuit]") {
+  auto circ = circuit(10, 5000, mrnd);
+  auto path = temp_path();
+  write_binary(path, circ);
+  // masks of 10 bits and the target fit three bytes even without shared controls
+  REQUIRE(std::filesystem::file_size(path) < 48 + 3 * 5000 + 64);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("binary circuit of mixed gates", "[binary_circuit], [polarity]") {
+  const auto bits = 6UL;
+  auto circ = circuit(bits);
+  for (auto i = 0UL; i < 40; i++) {
+    auto g = gate(bits, mrnd);
+    auto second_target = (g.target() + 1 + mrnd() % (bits - 1)) % bits;
+    auto controls = g.controls();
+    std::erase(controls, second_target);
+    switch (i % 4) {
+    case 1:
+      g = gate::fredkin(bits, controls, g.target(), second_target);
+      break;
+    case 2:
+      g = gate::peres(bits, controls, g.target(), second_target);
+      break;
+    case 3:
+      g = gate::peres(bits, controls, g.target(), second_target).inverse();
+      break;
+    }
+    circ.push_back(g.with_polarity(mrnd() & g.control_mask()));
+  }
+  auto path = temp_path();
+
+  write_binary(path, circ, 16);
+  {
+    auto reader = binary_circuit_reader(path);
+    REQUIRE(reader.verify());
+    REQUIRE(reader.to_circuit() == circ);
+    REQUIRE(reader[37] == circ[37]);
+    auto tt = truth_table(bits).shuffle(mrnd);
+    auto expected = tt;
+    circ.apply_back(expected);
+    reader.apply_back(tt);
+    REQUIRE(tt == expected);
+  }
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,560 @@
+#include "revlib.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+const auto CHUNK_SIZE = 1UL << 16;
+const auto FLUSH_SIZE = 1UL << 20;
+
+// Hands out lines as views into a chunk buffer that is refilled from the stream, so parsing
+// allocates nothing per line. Comments, surrounding blanks and empty lines are skipped.
+class line_reader {
+  std::istream &in_;
+  std::vector<char> buffer_;
+  uint64_t begin_ = 0;
+  uint64_t end_ = 0;
+  uint64_t line_number_ = 0;
+  bool eof_ = false;
+  std::string_view last_;
+  bool pending_ = false;
+
+  auto refill() -> bool {
+    if (eof_) {
+      return false;
+    }
+    auto left = end_ - begin_;
+    std::memmove(buffer_.data(), buffer_.data() + begin_, left);
+    begin_ = 0;
+    end_ = left;
+    if (end_ == buffer_.size()) {
+      buffer_.resize(2 * buffer_.size()); // line longer than a chunk
+    }
+    in_.read(buffer_.data() + end_, static_cast<std::streamsize>(buffer_.size() - end_));
+    auto read = static_cast<uint64_t>(in_.gcount());
+    end_ += read;
+    eof_ = read == 0;
+    return !eof_;
+  }
+
+  auto raw_line(std::string_view &line) -> bool {
+    while (true) {
+      auto first = buffer_.data() + begin_;
+      auto last = buffer_.data() + end_;
+      auto newline = std::find(first, last, '\n');
+      if (newline != last) {
+        line = std::string_view(first, static_cast<uint64_t>(newline - first));
+        begin_ += line.size() + 1;
+        return true;
+      }
+      if (!refill()) {
+        if (begin_ == end_) {
+          return false;
+        }
+        // refill moved the bytes to the front and may have reallocated, so first is stale
+        line = std::string_view(buffer_.data() + begin_, end_ - begin_);
+        begin_ = end_;
+        return true;
+      }
+    }
+  }
+
+public:
+  explicit line_reader(std::istream &in) : in_(in), buffer_(CHUNK_SIZE) {}
+
+  [[nodiscard]] auto line_number() const noexcept -> uint64_t { return line_number_; }
+
+  // Makes next return the last line again. Only valid right after a successful next.
+  auto unget() noexcept -> void { pending_ = true; }
+
+  auto next(std::string_view &line) -> bool {
+    if (pending_) {
+      pending_ = false;
+      line = last_;
+      return true;
+    }
+    while (raw_line(line)) {
+      line_number_++;
+      line = line.substr(0, line.find('#'));
+      auto first = line.find_first_not_of(" \t\r");
+      if (first == std::string_view::npos) {
+        continue;
+      }
+      line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+      last_ = line;
+      return true;
+    }
+    return false;
+  }
+
+  [[nodiscard]] auto error(const std::string &what) const -> std::invalid_argument {
+    return std::invalid_argument("Line " + std::to_string(line_number_) + ": " + what);
+  }
+};
+
+// Splits off the next blank separated token of line.
+auto next_token(std::string_view &line) -> std::string_view {
+  auto first = line.find_first_not_of(" \t");
+  if (first == std::string_view::npos) {
+    line = {};
+    return {};
+  }
+  line.remove_prefix(first);
+  auto token = line.substr(0, line.find_first_of(" \t"));
+  line.remove_prefix(token.size());
+  return token;
+}
+
+auto parse_number(std::string_view token, const line_reader &reader) -> uint64_t {
+  auto value = uint64_t();
+  auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+  if (error != std::errc() || end != token.data() + token.size()) {
+    throw reader.error("Expected a number, got '" + std::string(token) + "'");
+  }
+  return value;
+}
+
+auto parse_bits(std::string_view token, uint64_t bits_num, const line_reader &reader)
+    -> uint64_t {
+  if (token.size() != bits_num) {
+    throw reader.error("Expected " + std::to_string(bits_num) + " bits, got '" +
+                       std::string(token) + "'");
+  }
+  auto value = 0UL;
+  for (auto c : token) {
+    if (c != '0' && c != '1') {
+      throw reader.error("Only completely specified rows are supported, got '" +
+                         std::string(token) + "'");
+    }
+    value = (value << 1) | static_cast<uint64_t>(c - '0');
+  }
+  return value;
+}
+
+auto check_bits_num(uint64_t bits_num, uint64_t limit, const line_reader &reader) -> void {
+  if (bits_num == 0 || bits_num > limit) {
+    throw reader.error("Unsupported number of lines " + std::to_string(bits_num));
+  }
+}
+
+auto variable_names(uint64_t bits_num) -> std::vector<std::string> {
+  auto names = std::vector<std::string>();
+  for (auto k = 0UL; k < bits_num; k++) {
+    names.push_back(bits_num <= 26 ? std::string(1, static_cast<char>('a' + k))
+                                   : std::string("x").append(std::to_string(k)));
+  }
+  return names;
+}
+
+class output_buffer {
+  std::ostream &out_;
+  std::string buffer_;
+
+public:
+  explicit output_buffer(std::ostream &out) : out_(out) { buffer_.reserve(FLUSH_SIZE); }
+
+  auto append(std::string_view text) -> output_buffer & {
+    buffer_.append(text);
+    return *this;
+  }
+
+  auto append(uint64_t value) -> output_buffer & {
+    char digits[20];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    buffer_.append(digits, end);
+    return *this;
+  }
+
+  auto append_bits(uint64_t value, uint64_t bits_num) -> output_buffer & {
+    for (auto k = bits_num; k > 0; k--) {
+      buffer_.push_back(static_cast<char>('0' + ((value >> (k - 1)) & 1UL)));
+    }
+    if (buffer_.size() >= FLUSH_SIZE) {
+      flush();
+    }
+    return *this;
+  }
+
+  auto flush() -> void {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+    if (!out_) {
+      throw std::runtime_error("Cannot write RevLib output");
+    }
+  }
+};
+
+auto append_names(output_buffer &out, std::string_view keyword,
+                  const std::vector<std::string> &names) -> void {
+  out.append(keyword);
+  for (const auto &name : names) {
+    out.append(" ").append(name);
+  }
+  out.append("\n");
+}
+
+// Reads "input output" rows up to .end/.e or the end of the stream.
+auto parse_rows(line_reader &reader, uint64_t bits_num) -> truth_table {
+  auto length = 1UL << bits_num;
+  auto data = std::vector<uint64_t>(length);
+  auto seen_inputs = std::vector<bool>(length);
+  auto seen_outputs = std::vector<bool>(length);
+  auto rows_num = 0UL;
+
+  auto line = std::string_view();
+  while (reader.next(line)) {
+    if (line[0] == '.') {
+      auto keyword = next_token(line);
+      if (keyword != ".end" && keyword != ".e") {
+        throw reader.error("Unexpected keyword inside table");
+      }
+      break;
+    }
+    auto input = parse_bits(next_token(line), bits_num, reader);
+    auto output = parse_bits(next_token(line), bits_num, reader);
+    if (seen_inputs[input] || seen_outputs[output]) {
+      throw reader.error("Table is not a permutation");
+    }
+    seen_inputs[input] = true;
+    seen_outputs[output] = true;
+    data[input] = output;
+    rows_num++;
+  }
+  if (rows_num != length) {
+    throw reader.error("Table has " + std::to_string(rows_num) + " of " + std::to_string(length) +
+                       " rows");
+  }
+  auto tt = truth_table(bits_num);
+  tt.set_data(std::move(data));
+  return tt;
+}
+
+auto write_rows(output_buffer &out, const truth_table &tt) -> void {
+  for (auto row = 0UL; row < tt.length(); row++) {
+    out.append_bits(row, tt.size()).append(" ");
+    out.append_bits(tt[row], tt.size()).append("\n");
+  }
+}
+
+auto open_input(const std::filesystem::path &path) -> std::ifstream {
+  auto in = std::ifstream(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Cannot open " + path.string());
+  }
+  return in;
+}
+
+auto open_output(const std::filesystem::path &path) -> std::ofstream {
+  auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Cannot create " + path.string());
+  }
+  return out;
+}
+
+} // namespace
+
+auto read_real(std::istream &in, const gate_sink &sink) -> uint64_t {
+  auto reader = line_reader(in);
+  auto line = std::string_view();
+  auto bits_num = 0UL;
+  auto names = std::vector<std::string>();
+
+  while (true) {
+    if (!reader.next(line)) {
+      throw reader.error("Missing .begin");
+    }
+    auto keyword = next_token(line);
+    if (keyword == ".numvars") {
+      bits_num = parse_number(next_token(line), reader);
+      check_bits_num(bits_num, 64, reader);
+    }
+    else if (keyword == ".variables") {
+      for (auto name = next_token(line); !name.empty(); name = next_token(line)) {
+        names.emplace_back(name);
+      }
+    }
+    else if (keyword == ".begin") {
+      break;
+    }
+    else if (keyword.empty() || keyword[0] != '.') {
+      throw reader.error("Gate before .begin");
+    }
+  }
+  if (bits_num == 0 || names.size() != bits_num) {
+    throw reader.error(".numvars and .variables do not match");
+  }
+
+  auto line_of = [&](std::string_view name) {
+    auto it = std::find(names.begin(), names.end(), name);
+    if (it == names.end()) {
+      throw reader.error("Unknown variable '" + std::string(name) + "'");
+    }
+    return bits_num - 1 - static_cast<uint64_t>(it - names.begin());
+  };
+
+  auto lines = std::vector<uint64_t>();
+  while (true) {
+    if (!reader.next(line)) {
+      throw reader.error("Missing .end");
+    }
+    auto kind = next_token(line);
+    if (kind == ".end") {
+      return bits_num;
+    }
+    if (kind.size() < 2 || (kind[0] != 't' && kind[0] != 'f' && kind[0] != 'p')) {
+      throw reader.error("Unsupported gate '" + std::string(kind) + "'");
+    }
+    auto targets_num = kind[0] == 't' ? 1UL : 2UL;
+    auto taps_num = parse_number(kind.substr(1), reader);
+    if (taps_num < targets_num || taps_num > bits_num) {
+      throw reader.error("Invalid gate size");
+    }
+
+    lines.clear();
+    auto used_mask = 0UL;
+    auto polarity_mask = 0UL;
+    for (auto i = 0UL; i < taps_num; i++) {
+      auto name = next_token(line);
+      auto negative = !name.empty() && name[0] == '-';
+      if (negative) {
+        name.remove_prefix(1);
+      }
+      if (name.empty()) {
+        throw reader.error("Gate has fewer lines than declared");
+      }
+      auto id = line_of(name);
+      if ((used_mask >> id & 1UL) != 0) {
+        throw reader.error("Gate uses line '" + std::string(name) + "' twice");
+      }
+      if (negative && i + targets_num >= taps_num) {
+        throw reader.error("Target '" + std::string(name) + "' cannot be negative");
+      }
+      used_mask |= 1UL << id;
+      polarity_mask |= negative ? 0UL : 1UL << id;
+      lines.push_back(id);
+    }
+    if (!next_token(line).empty()) {
+      throw reader.error("Gate has more lines than declared");
+    }
+    auto target = lines[taps_num - targets_num];
+    auto second_target = lines.back();
+    lines.resize(taps_num - targets_num);
+    auto controls_mask = used_mask & ~(1UL << target) & ~(1UL << second_target);
+    polarity_mask &= controls_mask;
+    if (kind[0] == 't') {
+      sink(gate(bits_num, lines, target).with_polarity(polarity_mask));
+    }
+    else if (kind[0] == 'f') {
+      sink(gate::fredkin(bits_num, lines, target, second_target).with_polarity(polarity_mask));
+    }
+    else {
+      sink(gate::peres(bits_num, lines, target, second_target).with_polarity(polarity_mask));
+    }
+  }
+}
+
+auto read_real(std::istream &in) -> circuit {
+  auto gates = std::deque<gate>();
+  auto bits_num = read_real(in, [&gates](const gate &g) { gates.push_back(g); });
+  return {bits_num, std::move(gates)};
+}
+
+auto read_real(const std::filesystem::path &path) -> circuit {
+  auto in = open_input(path);
+  return read_real(in);
+}
+
+auto write_real(std::ostream &out, const circuit &circ) -> void {
+  auto writer = real_writer(out, circ.bits_num());
+  for (const auto &g : circ.gates()) {
+    writer(g);
+  }
+  writer.finish();
+}
+
+auto write_real(const std::filesystem::path &path, const circuit &circ) -> void {
+  auto out = open_output(path);
+  write_real(out, circ);
+}
+
+auto read_spec(std::istream &in) -> truth_table {
+  auto reader = line_reader(in);
+  auto line = std::string_view();
+  auto bits_num = 0UL;
+
+  while (true) {
+    if (!reader.next(line)) {
+      throw reader.error("Missing .begin");
+    }
+    auto keyword = next_token(line);
+    if (keyword == ".numvars") {
+      bits_num = parse_number(next_token(line), reader);
+      check_bits_num(bits_num, 32, reader);
+    }
+    else if (keyword == ".begin") {
+      break;
+    }
+    else if (keyword.empty() || keyword[0] != '.') {
+      throw reader.error("Row before .begin");
+    }
+  }
+  if (bits_num == 0) {
+    throw reader.error("Missing .numvars");
+  }
+  return parse_rows(reader, bits_num);
+}
+
+auto read_spec(const std::filesystem::path &path) -> truth_table {
+  auto in = open_input(path);
+  return read_spec(in);
+}
+
+auto read_pla(std::istream &in) -> truth_table {
+  auto reader = line_reader(in);
+  auto line = std::string_view();
+  auto inputs_num = 0UL;
+  auto outputs_num = 0UL;
+
+  while (true) {
+    if (!reader.next(line)) {
+      throw reader.error("Missing table");
+    }
+    if (line[0] != '.') {
+      reader.unget();
+      break;
+    }
+    auto keyword = next_token(line);
+    if (keyword == ".i") {
+      inputs_num = parse_number(next_token(line), reader);
+    }
+    else if (keyword == ".o") {
+      outputs_num = parse_number(next_token(line), reader);
+    }
+  }
+  if (inputs_num != outputs_num) {
+    throw reader.error("Reversible table needs as many outputs as inputs");
+  }
+  check_bits_num(inputs_num, 32, reader);
+
+  return parse_rows(reader, inputs_num);
+}
+
+auto read_pla(const std::filesystem::path &path) -> truth_table {
+  auto in = open_input(path);
+  return read_pla(in);
+}
+
+auto write_spec(std::ostream &out, const truth_table &tt) -> void {
+  auto buffer = output_buffer(out);
+  auto names = variable_names(tt.size());
+  buffer.append(".version 1.0\n.numvars ").append(tt.size()).append("\n");
+  append_names(buffer, ".variables", names);
+  append_names(buffer, ".inputs", names);
+  append_names(buffer, ".outputs", names);
+  buffer.append(".begin\n");
+  write_rows(buffer, tt);
+  buffer.append(".end\n");
+  buffer.flush();
+}
+
+auto write_spec(const std::filesystem::path &path, const truth_table &tt) -> void {
+  auto out = open_output(path);
+  write_spec(out, tt);
+}
+
+auto write_pla(std::ostream &out, const truth_table &tt) -> void {
+  auto buffer = output_buffer(out);
+  buffer.append(".i ").append(tt.size()).append("\n");
+  buffer.append(".o ").append(tt.size()).append("\n");
+  buffer.append(".p ").append(tt.length()).append("\n");
+  write_rows(buffer, tt);
+  buffer.append(".e\n");
+  buffer.flush();
+}
+
+auto write_pla(const std::filesystem::path &path, const truth_table &tt) -> void {
+  auto out = open_output(path);
+  write_pla(out, tt);
+}
+
+real_writer::real_writer(std::ostream &out, uint64_t bits_num)
+    : out_(out), bits_num_(bits_num), names_(variable_names(bits_num)) {
+  buffer_.reserve(FLUSH_SIZE);
+  auto header = output_buffer(out_);
+  header.append(".version 1.0\n.numvars ").append(bits_num_).append("\n");
+  append_names(header, ".variables", names_);
+  append_names(header, ".inputs", names_);
+  append_names(header, ".outputs", names_);
+  header.append(".constants ").append(std::string(bits_num_, '-')).append("\n");
+  header.append(".garbage ").append(std::string(bits_num_, '-')).append("\n");
+  header.append(".begin\n");
+  header.flush();
+}
+
+auto real_writer::flush_if_full() -> void {
+  if (buffer_.size() >= FLUSH_SIZE) {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+    if (!out_) {
+      throw std::runtime_error("Cannot write RevLib output");
+    }
+  }
+}
+
+auto real_writer::write_gate(char kind, const gate &g, uint64_t extra_control,
+                             std::initializer_list<uint64_t> targets) -> void {
+  char digits[20];
+  auto taps_num = g.controls_num() + (extra_control < bits_num_ ? 1 : 0) + targets.size();
+  auto end = std::to_chars(digits, digits + sizeof(digits), taps_num).ptr;
+  buffer_.push_back(kind);
+  buffer_.append(digits, end);
+  for (auto control : g.controls()) {
+    buffer_.append((g.polarity_mask() >> control & 1UL) != 0 ? " " : " -");
+    buffer_.append(names_[bits_num_ - 1 - control]);
+  }
+  if (extra_control < bits_num_) {
+    buffer_.push_back(' ');
+    buffer_.append(names_[bits_num_ - 1 - extra_control]);
+  }
+  for (auto target : targets) {
+    buffer_.push_back(' ');
+    buffer_.append(names_[bits_num_ - 1 - target]);
+  }
+  buffer_.push_back('\n');
+}
+
+auto real_writer::operator()(const gate &g) -> void {
+  assert(g.size() == bits_num_);
+  switch (g.kind()) {
+  case gate_kind::toffoli:
+    write_gate('t', g, bits_num_, {g.target()});
+    break;
+  case gate_kind::fredkin:
+    write_gate('f', g, bits_num_, {g.target(), g.second_target()});
+    break;
+  case gate_kind::peres:
+    write_gate('p', g, bits_num_, {g.target(), g.second_target()});
+    break;
+  case gate_kind::inverse_peres:
+    write_gate('t', g, bits_num_, {g.target()});
+    write_gate('t', g, g.target(), {g.second_target()});
+    break;
+  }
+  flush_if_full();
+}
+
+auto real_writer::finish() -> void {
+  buffer_.append(".end\n");
+  out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  buffer_.clear();
+  out_.flush();
+  if (!out_) {
+    throw std::runtime_error("Cannot write RevLib output");
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "synthesisers/synthesiser.hpp"
+#include "truth_table/truth_table.hpp"
+#include <filesystem>
+#include <initializer_list>
+#include <istream>
+#include <ostream>
+#include <string>
+
+// RevLib text formats. The first declared variable is the most significant line, so variable k
+// of an n-line file is line n-1-k and the rows of .spec/.pla tables read as binary numbers.
+// Inputs are read in large chunks and parsed in place, malformed files throw
+// std::invalid_argument naming the offending line.
+
+// Reads a .real circuit of Toffoli (t), Fredkin (f) and Peres (p) gates whose last one or two
+// lines are targets, passing every gate to sink as soon as it is parsed. Controls written as -a
+// are negative. Returns the number of lines.
+auto read_real(std::istream &in, const gate_sink &sink) -> uint64_t;
+auto read_real(std::istream &in) -> circuit;
+auto read_real(const std::filesystem::path &path) -> circuit;
+
+auto write_real(std::ostream &out, const circuit &circ) -> void;
+auto write_real(const std::filesystem::path &path, const circuit &circ) -> void;
+
+// Only completely specified reversible functions are accepted: every input row has to appear
+// exactly once and don't care entries are rejected.
+auto read_spec(std::istream &in) -> truth_table;
+auto read_spec(const std::filesystem::path &path) -> truth_table;
+auto read_pla(std::istream &in) -> truth_table;
+auto read_pla(const std::filesystem::path &path) -> truth_table;
+
+auto write_spec(std::ostream &out, const truth_table &tt) -> void;
+auto write_spec(const std::filesystem::path &path, const truth_table &tt) -> void;
+auto write_pla(std::ostream &out, const truth_table &tt) -> void;
+auto write_pla(const std::filesystem::path &path, const truth_table &tt) -> void;
+
+// Incremental .real writer, usable as a gate_sink so synthesised gates go straight to disk.
+// Output is buffered, finish writes the trailer and flushes. RevLib has no inverse Peres gate, so
+// it is written as its two Toffoli gates.
+class real_writer {
+  std::ostream &out_;
+  uint64_t bits_num_;
+  std::string buffer_;
+  std::vector<std::string> names_;
+
+  auto flush_if_full() -> void;
+  // One line of kind for the controls of g, then extra_control unless it is bits_num, then targets.
+  auto write_gate(char kind, const gate &g, uint64_t extra_control,
+                  std::initializer_list<uint64_t> targets) -> void;
+
+public:
+  real_writer(std::ostream &out, uint64_t bits_num);
+
+  auto operator()(const gate &g) -> void;
+  auto finish() -> void;
+};
@@ -0,0 +1,170 @@
+#include "revlib.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <sstream>
+
+namespace revlib_ut {
+const auto EPOCHS = 200;
+const auto max_bits = 10;
+std::mt19937_64 mrnd;
+} // namespace revlib_ut
+
+using namespace revlib_ut;
+
+TEST_CASE("real round trip", "[revlib], [real]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  const auto gates_num = mrnd() % 64;
+  auto circ = circuit(bits, gates_num, mrnd);
+
+  auto out = std::stringstream();
+  write_real(out, circ);
+  auto in = std::stringstream(out.str());
+  REQUIRE(read_real(in) == circ);
+}
+
+TEST_CASE("real parsing", "[revlib], [real]") {
+  SECTION("variable order, comments and blank lines") {
+    auto in = std::stringstream("# toffoli and cnot\n"
+                                ".version 1.0\n"
+                                ".numvars 3\n"
+                                ".variables a b c\n"
+                                ".inputs a b c\n"
+                                ".outputs a b c\n"
+                                ".constants ---\n"
+                                ".garbage ---\n"
+                                ".begin\n"
+                                "t3 a b c  # full toffoli\n"
+                                "\n"
+                                "\tt2 c a\r\n"
+                                "t1 b\n"
+                                ".end\n");
+    auto expected = circuit(3);
+    expected.push_back(gate(3, {2, 1}, 0));
+    expected.push_back(gate(3, {0}, 2));
+    expected.push_back(gate(3, {}, 1));
+    REQUIRE(read_real(in) == expected);
+  }
+
+  SECTION("streaming into a sink") {
+    auto circ = circuit(6, 20000, mrnd); // larger than a read chunk
+    auto out = std::stringstream();
+    write_real(out, circ);
+
+    auto in = std::stringstream(out.str());
+    auto gates = std::deque<gate>();
+    REQUIRE(read_real(in, [&gates](const gate &g) { gates.push_back(g); }) == 6);
+    REQUIRE(gates == circ.gates());
+  }
+
+  SECTION("last line without a newline") {
+    auto header = std::string(".numvars 2\n.variables a b\n.begin\nt2 a b\n");
+    auto expected = circuit(2);
+    expected.push_back(gate(2, {1}, 0));
+    auto in = std::stringstream(header + ".end # trailing comment written without a newline");
+    REQUIRE(read_real(in) == expected);
+
+    auto long_in = std::stringstream(header + ".end # " + std::string(2 * (1UL << 16), 'x'));
+    REQUIRE(read_real(long_in) == expected);
+  }
+
+  SECTION("malformed files") {
+    auto header = std::string(".numvars 2\n.variables a b\n.begin\n");
+    for (const auto *body : {"t2 a c\n.end\n", "t3 a b\n.end\n", "t2 a a\n.end\n",
+                             "v2 a b\n.end\n", "t2 a b\n", "t1 a b\n.end\n"}) {
+      auto in = std::stringstream(header + body);
+      REQUIRE_THROWS_AS(read_real(in), std::invalid_argument);
+    }
+    auto in = std::stringstream(".numvars 2\n.variables a\n.begin\n.end\n");
+    REQUIRE_THROWS_AS(read_real(in), std::invalid_argument);
+  }
+}
+
+TEST_CASE("spec and pla round trip", "[revlib], [spec], [pla]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  auto tt = truth_table(bits).shuffle(mrnd);
+
+  auto spec = std::stringstream();
+  write_spec(spec, tt);
+  auto spec_in = std::stringstream(spec.str());
+  REQUIRE(read_spec(spec_in) == tt);
+
+  auto pla = std::stringstream();
+  write_pla(pla, tt);
+  auto pla_in = std::stringstream(pla.str());
+  REQUIRE(read_pla(pla_in) == tt);
+}
+
+TEST_CASE("table parsing", "[revlib], [spec], [pla]") {
+  SECTION("rows are binary numbers, first variable first") {
+    auto in = std::stringstream(".i 2\n.o 2\n.p 4\n00 01\n01 10\n10 11\n11 00\n.e\n");
+    auto expected = truth_table(2);
+    expected.set_data({1, 2, 3, 0});
+    REQUIRE(read_pla(in) == expected);
+  }
+
+  SECTION("incomplete and non reversible tables") {
+    for (const auto *body : {"00 01\n01 10\n10 11\n.e\n", "00 01\n01 01\n10 11\n11 00\n.e\n",
+                             "00 0-\n01 10\n10 11\n11 00\n.e\n", "00 01\n01 10\n10 11\n11 000\n"}) {
+      auto in = std::stringstream(std::string(".i 2\n.o 2\n") + body);
+      REQUIRE_THROWS_AS(read_pla(in), std::invalid_argument);
+    }
+    auto in = std::stringstream(".i 2\n.o 1\n00 0\n");
+    REQUIRE_THROWS_AS(read_pla(in), std::invalid_argument);
+  }
+
+  SECTION("last line without a newline") {
+    auto rows = std::string(".numvars 2\n.variables a b\n.begin\n00 01\n01 10\n10 11\n11 00\n");
+    auto expected = truth_table(2);
+    expected.set_data({1, 2, 3, 0});
+    auto in = std::stringstream(rows + ".end # trailing comment written without a newline");
+    REQUIRE(read_spec(in) == expected);
+
+    auto long_in = std::stringstream(rows + ".end # " + std::string(2 * (1UL << 16), 'x'));
+    REQUIRE(read_spec(long_in) == expected);
+  }
+
+  SECTION("spec without header") {
+    auto in = std::stringstream("00 00\n");
+    REQUIRE_THROWS_AS(read_spec(in), std::invalid_argument);
+  }
+}
+
+TEST_CASE("real mixed polarity, Fredkin and Peres gates", "[revlib], [real], [polarity]") {
+  SECTION("parsing") {
+    auto in = std::stringstream(".numvars 4\n.variables a b c d\n.begin\n"
+                                "t3 -a b d\nf3 a c d\np4 -b a c d\n.end\n");
+    auto circ = read_real(in);
+    REQUIRE(circ.gates_num() == 3);
+    REQUIRE(circ[0] == gate(4, {3, 2}, 0).with_polarity(1UL << 2));
+    REQUIRE(circ[1] == gate::fredkin(4, {3}, 1, 0));
+    REQUIRE(circ[2] == gate::peres(4, {2, 3}, 1, 0).with_polarity(1UL << 3));
+
+    auto negative_target = std::stringstream(".numvars 2\n.variables a b\n.begin\nt2 a -b\n.end\n");
+    REQUIRE_THROWS_AS(read_real(negative_target), std::invalid_argument);
+    auto short_fredkin = std::stringstream(".numvars 2\n.variables a b\n.begin\nf1 a\n.end\n");
+    REQUIRE_THROWS_AS(read_real(short_fredkin), std::invalid_argument);
+  }
+
+  SECTION("round trip") {
+    const auto bits = 5UL;
+    auto circ = circuit(bits);
+    circ.push_back(gate(bits, {0, 1}, 4).with_polarity(1UL << 1));
+    circ.push_back(gate::fredkin(bits, {2}, 0, 3).with_polarity(0));
+    circ.push_back(gate::peres(bits, {4}, 1, 2));
+    auto out = std::stringstream();
+    write_real(out, circ);
+    auto in = std::stringstream(out.str());
+    REQUIRE(read_real(in) == circ);
+
+    // inverse Peres gates have no RevLib name and are written as the two Toffoli gates they are
+    circ.push_back(gate::peres(bits, {0, 3}, 4, 1).with_polarity(1UL << 3).inverse());
+    out = std::stringstream();
+    write_real(out, circ);
+    in = std::stringstream(out.str());
+    auto read = read_real(in);
+    REQUIRE(read.gates_num() == circ.gates_num() + 1);
+    REQUIRE(read.output_tt() == circ.output_tt());
+  }
+}
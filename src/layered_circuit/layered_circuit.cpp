@@ -0,0 +1,165 @@
+#include "layered_circuit.hpp"
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// Uses of one line alternate between groups of readers (controls) and writers (targets).
+// Gates of one group commute, so a gate depends only on the latest group of the other kind.
+struct line_uses {
+  std::vector<uint64_t> readers;
+  std::vector<uint64_t> writers;
+  bool writing = false;
+};
+
+auto use_line(line_uses &uses, uint64_t index, bool write, std::vector<uint64_t> &predecessors)
+    -> void {
+  auto &own = write ? uses.writers : uses.readers;
+  auto &other = write ? uses.readers : uses.writers;
+  predecessors.insert(predecessors.end(), other.begin(), other.end());
+  if (uses.writing != write) {
+    own.clear();
+    uses.writing = write;
+  }
+  own.push_back(index);
+}
+
+// Targets of Fredkin and Peres gates are read and written at once, so such a use depends on every
+// latest use of the line and every later use depends on it.
+auto claim_line(line_uses &uses, uint64_t index, std::vector<uint64_t> &predecessors) -> void {
+  predecessors.insert(predecessors.end(), uses.readers.begin(), uses.readers.end());
+  predecessors.insert(predecessors.end(), uses.writers.begin(), uses.writers.end());
+  uses.readers = {index};
+  uses.writers = {index};
+  uses.writing = true;
+}
+
+} // namespace
+
+layered_circuit::layered_circuit(const circuit &circ, layering mode)
+    : bits_num_(circ.bits_num()), mode_(mode), gates_(circ.gates().begin(), circ.gates().end()),
+      predecessors_(gates_.size()), asap_(gates_.size(), 0), alap_(gates_.size(), 0) {
+  auto uses = std::vector<line_uses>(bits_num_);
+  auto last_use = std::vector<int64_t>(bits_num_, -1);
+
+  for (auto i = 0UL; i < gates_.size(); i++) {
+    auto &predecessors = predecessors_[i];
+    const auto &g = gates_[i];
+    auto lines = g.controls();
+    lines.push_back(g.target());
+    if (g.kind() != gate_kind::toffoli) {
+      lines.push_back(g.second_target());
+    }
+
+    if (mode_ == layering::disjoint) {
+      for (auto line : lines) {
+        if (last_use[line] >= 0) {
+          predecessors.push_back(static_cast<uint64_t>(last_use[line]));
+        }
+        last_use[line] = static_cast<int64_t>(i);
+      }
+    }
+    else {
+      for (auto control : g.controls()) {
+        use_line(uses[control], i, false, predecessors);
+      }
+      if (g.kind() == gate_kind::toffoli) {
+        use_line(uses[g.target()], i, true, predecessors);
+      }
+      else {
+        claim_line(uses[g.target()], i, predecessors);
+        claim_line(uses[g.second_target()], i, predecessors);
+      }
+    }
+
+    std::sort(predecessors.begin(), predecessors.end());
+    predecessors.erase(std::unique(predecessors.begin(), predecessors.end()), predecessors.end());
+    for (auto p : predecessors) {
+      asap_[i] = std::max(asap_[i], asap_[p] + 1);
+    }
+  }
+
+  auto layers_num = gates_.empty() ? 0UL : *std::max_element(asap_.begin(), asap_.end()) + 1;
+  layers_ = std::vector<std::vector<uint64_t>>(layers_num);
+  std::fill(alap_.begin(), alap_.end(), layers_num == 0 ? 0 : layers_num - 1);
+  for (auto i = gates_.size(); i-- > 0;) {
+    layers_[asap_[i]].push_back(i);
+    for (auto p : predecessors_[i]) {
+      alap_[p] = std::min(alap_[p], alap_[i] - 1);
+    }
+  }
+  for (auto &layer : layers_) {
+    std::reverse(layer.begin(), layer.end());
+  }
+}
+
+auto layered_circuit::bits_num() const -> uint64_t { return bits_num_; }
+
+auto layered_circuit::mode() const -> layering { return mode_; }
+
+auto layered_circuit::gates() const -> const std::vector<gate> & { return gates_; }
+
+auto layered_circuit::gates_num() const -> uint64_t { return gates_.size(); }
+
+auto layered_circuit::depth() const -> uint64_t { return layers_.size(); }
+
+auto layered_circuit::predecessors(uint64_t index) const -> const std::vector<uint64_t> & {
+  return predecessors_[index];
+}
+
+auto layered_circuit::asap() const -> const std::vector<uint64_t> & { return asap_; }
+
+auto layered_circuit::alap() const -> const std::vector<uint64_t> & { return alap_; }
+
+auto layered_circuit::layers() const -> const std::vector<std::vector<uint64_t>> & {
+  return layers_;
+}
+
+auto layered_circuit::apply(uint64_t row) const -> uint64_t {
+  for (const auto &layer : layers_) {
+    for (auto i : layer) {
+      row = gates_[i].apply(row);
+    }
+  }
+  return row;
+}
+
+auto layered_circuit::apply_back(truth_table &tt) const -> void {
+  if (tt.size() != bits_num_) {
+    throw std::invalid_argument("Cannot apply layered_circuit to truth_table of different size");
+  }
+  auto layer_gates = std::vector<gate>();
+  for (const auto &layer : layers_) {
+    layer_gates.clear();
+    for (auto i : layer) {
+      layer_gates.push_back(gates_[i]);
+    }
+    for (auto &row : tt) {
+      for (const auto &g : layer_gates) {
+        row = g.apply(row);
+      }
+    }
+  }
+}
+
+auto layered_circuit::to_circuit() const -> circuit {
+  auto gates = std::deque<gate>();
+  for (const auto &layer : layers_) {
+    for (auto i : layer) {
+      gates.push_back(gates_[i]);
+    }
+  }
+  return {bits_num_, std::move(gates)};
+}
+
+auto layered_circuit::print() const -> void {
+  for (auto l = 0UL; l < layers_.size(); l++) {
+    std::cout << "Layer " << l << ": ";
+    for (auto i : layers_[l]) {
+      std::cout << i << ", ";
+    }
+    std::cout << std::endl;
+  }
+}
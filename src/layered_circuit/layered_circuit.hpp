@@ -0,0 +1,41 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include <cstdint>
+#include <vector>
+
+// disjoint  - gates sharing any line depend on each other
+// commuting - gates depend on each other only when one targets a control line of the other, or a
+//             target of a Fredkin or Peres gate
+enum class layering { disjoint, commuting };
+
+// Dependency DAG of the gates of a circuit together with their ASAP and ALAP layers. All gates
+// of one layer commute, so a layer is applied to every row in a single pass.
+class layered_circuit {
+  uint64_t bits_num_;
+  layering mode_;
+  std::vector<gate> gates_;
+  std::vector<std::vector<uint64_t>> predecessors_;
+  std::vector<uint64_t> asap_;
+  std::vector<uint64_t> alap_;
+  std::vector<std::vector<uint64_t>> layers_;
+
+public:
+  explicit layered_circuit(const circuit &circ, layering mode = layering::commuting);
+
+  [[nodiscard]] auto bits_num() const -> uint64_t;
+  [[nodiscard]] auto mode() const -> layering;
+  [[nodiscard]] auto gates() const -> const std::vector<gate> &;
+  [[nodiscard]] auto gates_num() const -> uint64_t;
+  [[nodiscard]] auto depth() const -> uint64_t;
+  [[nodiscard]] auto predecessors(uint64_t index) const -> const std::vector<uint64_t> &;
+  [[nodiscard]] auto asap() const -> const std::vector<uint64_t> &;
+  [[nodiscard]] auto alap() const -> const std::vector<uint64_t> &;
+  // Indices of gates in every ASAP layer.
+  [[nodiscard]] auto layers() const -> const std::vector<std::vector<uint64_t>> &;
+
+  [[nodiscard]] auto apply(uint64_t row) const -> uint64_t;
+  auto apply_back(truth_table &tt) const -> void;
+  [[nodiscard]] auto to_circuit() const -> circuit;
+
+  auto print() const -> void;
+};
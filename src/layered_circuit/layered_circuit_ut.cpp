@@ -0,0 +1,86 @@
+#include "layered_circuit.hpp"
+#include "optimisers/peephole/peephole.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <random>
+
+namespace layered_circuit_ut {
+const auto EPOCHS = 1000;
+const auto max_bits = 10;
+std::mt19937_64 mrnd;
+} // namespace layered_circuit_ut
+
+using namespace layered_circuit_ut;
+
+TEST_CASE("layered_circuit layers", "[layered_circuit]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  const auto mode = GENERATE(layering::disjoint, layering::commuting);
+
+  auto circ = circuit(bits, mrnd() % 64, mrnd);
+  auto tested = layered_circuit(circ, mode);
+  REQUIRE(tested.gates_num() == circ.gates_num());
+  REQUIRE(tested.depth() <= circ.gates_num());
+
+  auto gates_in_layers = 0UL;
+  for (const auto &layer : tested.layers()) {
+    REQUIRE_FALSE(layer.empty());
+    gates_in_layers += layer.size();
+    for (auto i : layer) {
+      for (auto j : layer) {
+        const auto &lhs = tested.gates()[i];
+        const auto &rhs = tested.gates()[j];
+        if (i == j) {
+          continue;
+        }
+        if (mode == layering::disjoint) {
+          auto lhs_lines = lhs.control_mask() | lhs.target_mask();
+          auto rhs_lines = rhs.control_mask() | rhs.target_mask();
+          REQUIRE((lhs_lines & rhs_lines) == 0);
+        }
+        else {
+          REQUIRE(peephole::commute(lhs, rhs));
+        }
+      }
+    }
+  }
+  REQUIRE(gates_in_layers == circ.gates_num());
+
+  for (auto i = 0UL; i < tested.gates_num(); i++) {
+    REQUIRE(tested.asap()[i] <= tested.alap()[i]);
+    REQUIRE(tested.alap()[i] < tested.depth());
+    for (auto p : tested.predecessors(i)) {
+      REQUIRE(p < i);
+      REQUIRE(tested.asap()[p] < tested.asap()[i]);
+      REQUIRE(tested.alap()[p] < tested.alap()[i]);
+    }
+  }
+}
+
+TEST_CASE("layered_circuit evaluation", "[layered_circuit], [apply]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  const auto mode = GENERATE(layering::disjoint, layering::commuting);
+
+  auto circ = circuit(bits, mrnd() % 64, mrnd);
+  auto tested = layered_circuit(circ, mode);
+
+  auto tt = truth_table(bits);
+  tested.apply_back(tt);
+  REQUIRE(tt == circ.output_tt());
+  REQUIRE(tested.to_circuit().output_tt() == circ.output_tt());
+
+  auto row = mrnd() & state::mask(bits);
+  REQUIRE(tested.apply(row) == circ.apply(row));
+}
+
+TEST_CASE("layered_circuit depth", "[layered_circuit]") {
+  const auto bits = 4UL;
+  auto circ = circuit(bits);
+  circ.push_back(gate(bits, {0}, 1));
+  circ.push_back(gate(bits, {0}, 2));
+  circ.push_back(gate(bits, {3}, 1));
+  circ.push_back(gate(bits, {1}, 3));
+
+  REQUIRE(layered_circuit(circ, layering::disjoint).depth() == 3);
+  REQUIRE(layered_circuit(circ, layering::commuting).depth() == 2);
+  REQUIRE(layered_circuit(circuit(bits)).depth() == 0);
+}
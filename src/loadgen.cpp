@@ -0,0 +1,196 @@
+#include "server/server.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const auto USAGE = std::string_view(
+    "usage: sts_loadgen --socket PATH [options]\n"
+    "  --connections N   concurrent client connections, 4 by default\n"
+    "  --requests N      requests per connection, 10000 by default\n"
+    "  --in-flight N     requests a connection keeps outstanding, 1 by default\n"
+    "  --min-bits N      smallest target, 3 by default\n"
+    "  --max-bits N      largest target, 8 by default\n"
+    "  --distinct N      distinct random targets cycled through, 0 - every target fresh\n"
+    "  --seed N\n");
+
+struct options {
+  std::filesystem::path socket;
+  uint64_t connections = 4;
+  uint64_t requests = 10000;
+  uint64_t in_flight = 1;
+  uint64_t min_bits = 3;
+  uint64_t max_bits = 8;
+  uint64_t distinct = 0;
+  uint64_t seed = 1;
+};
+
+auto parse_number(std::string_view flag, std::string_view text) -> uint64_t {
+  auto value = uint64_t();
+  auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end != text.data() + text.size()) {
+    throw std::invalid_argument("Invalid value for " + std::string(flag));
+  }
+  return value;
+}
+
+auto parse_options(int argc, char **argv) -> options {
+  auto opts = options();
+  for (auto i = 1; i + 1 < argc; i += 2) {
+    auto flag = std::string_view(argv[i]);
+    auto value = std::string_view(argv[i + 1]);
+    if (flag == "--socket") {
+      opts.socket = value;
+    }
+    else if (flag == "--connections") {
+      opts.connections = parse_number(flag, value);
+    }
+    else if (flag == "--requests") {
+      opts.requests = parse_number(flag, value);
+    }
+    else if (flag == "--in-flight") {
+      opts.in_flight = std::max(1UL, parse_number(flag, value));
+    }
+    else if (flag == "--min-bits") {
+      opts.min_bits = parse_number(flag, value);
+    }
+    else if (flag == "--max-bits") {
+      opts.max_bits = parse_number(flag, value);
+    }
+    else if (flag == "--distinct") {
+      opts.distinct = parse_number(flag, value);
+    }
+    else if (flag == "--seed") {
+      opts.seed = parse_number(flag, value);
+    }
+    else {
+      throw std::invalid_argument("Unknown option " + std::string(flag));
+    }
+  }
+  if (argc % 2 == 0) {
+    throw std::invalid_argument("Missing value for " + std::string(argv[argc - 1]));
+  }
+  if (opts.socket.empty() || opts.min_bits == 0 || opts.min_bits > opts.max_bits) {
+    throw std::invalid_argument("Invalid options");
+  }
+  return opts;
+}
+
+auto random_target(const options &opts, xoshiro256ss &rng) -> truth_table {
+  auto bits = opts.min_bits + uniform_below(rng, opts.max_bits - opts.min_bits + 1);
+  return truth_table(bits).shuffle(rng);
+}
+
+struct connection_result {
+  std::vector<double> latencies_us;
+  uint64_t failed = 0;
+};
+
+// Keeps in_flight requests outstanding and records the latency of every answer.
+auto drive(const options &opts, uint64_t connection_index, const std::vector<truth_table> &pool)
+    -> connection_result {
+  using clock = std::chrono::steady_clock;
+  auto rng = xoshiro256ss(opts.seed, connection_index);
+  auto client = synthesis_client(opts.socket);
+  auto sent_at = std::unordered_map<uint64_t, clock::time_point>();
+  auto result = connection_result();
+  result.latencies_us.reserve(opts.requests);
+
+  auto sent = 0UL;
+  auto send_next = [&]() {
+    auto target = pool.empty() ? random_target(opts, rng) : pool[uniform_below(rng, pool.size())];
+    sent_at[sent] = clock::now();
+    client.send({sent++, target});
+  };
+  while (sent < std::min(opts.in_flight, opts.requests)) {
+    send_next();
+  }
+  for (auto received = 0UL; received < opts.requests; received++) {
+    auto response = client.receive();
+    auto latency = clock::now() - sent_at.at(response.id);
+    sent_at.erase(response.id);
+    result.latencies_us.push_back(std::chrono::duration<double, std::micro>(latency).count());
+    result.failed += response.circ ? 0 : 1;
+    if (sent < opts.requests) {
+      send_next();
+    }
+  }
+  return result;
+}
+
+auto percentile(const std::vector<double> &sorted, double p) -> double {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto index = static_cast<uint64_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+} // namespace
+
+// Load generator for sts --serve, prints one JSON object with latency percentiles and throughput,
+// e.g. sts_loadgen --socket /tmp/sts.sock --connections 16 --in-flight 8 --distinct 1000
+auto main(int argc, char **argv) -> int {
+  auto opts = options();
+  try {
+    opts = parse_options(argc, argv);
+  }
+  catch (const std::exception &e) {
+    std::cerr << e.what() << "\n" << USAGE;
+    return 2;
+  }
+
+  // pool targets come from their own streams, disjoint from the connection streams
+  auto rng = xoshiro256ss(opts.seed, opts.connections);
+  auto pool = std::vector<truth_table>();
+  for (auto i = 0UL; i < opts.distinct; i++) {
+    pool.push_back(random_target(opts, rng));
+  }
+
+  auto results = std::vector<connection_result>(opts.connections);
+  auto errors = std::vector<std::string>(opts.connections);
+  auto start = std::chrono::steady_clock::now();
+  auto threads = std::vector<std::thread>();
+  for (auto c = 0UL; c < opts.connections; c++) {
+    threads.emplace_back([&, c]() {
+      try {
+        results[c] = drive(opts, c, pool);
+      }
+      catch (const std::exception &e) {
+        errors[c] = e.what();
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  for (const auto &error : errors) {
+    if (!error.empty()) {
+      std::cerr << error << "\n";
+      return 1;
+    }
+  }
+
+  auto latencies = std::vector<double>();
+  auto failed = 0UL;
+  for (const auto &r : results) {
+    latencies.insert(latencies.end(), r.latencies_us.begin(), r.latencies_us.end());
+    failed += r.failed;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << "{\"requests\": " << latencies.size() << ", \"failed\": " << failed
+            << ", \"seconds\": " << seconds
+            << ", \"requests_per_second\": " << static_cast<double>(latencies.size()) / seconds
+            << ", \"p50_us\": " << percentile(latencies, 0.50)
+            << ", \"p99_us\": " << percentile(latencies, 0.99)
+            << ", \"max_us\": " << (latencies.empty() ? 0 : latencies.back()) << "}\n";
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,430 @@
+#include "codegen/codegen.hpp"
+#include "functions/functions.hpp"
+#include "io/binary_circuit.hpp"
+#include "io/revlib.hpp"
+#include "pipeline/pipeline.hpp"
+#include "server/server.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include "synthesisers/mmd03_beam/mmd03_beam.hpp"
+#include "synthesisers/mmd03_symbolic/mmd03_symbolic.hpp"
+#include "utils/utils.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const auto USAGE = std::string_view(
+    "usage: sts [options] [TARGET...]\n"
+    "       sts --serve SOCKET [--engine E] [--threads N] [--cache N] [--batch N]\n"
+    "  TARGET                 .spec, .pla, .real, .rsc (binary circuit) or .tt (raw little\n"
+    "                         endian uint64 rows) file\n"
+    "  --generate FAMILY:N[-M] hwb, add, mul, graycode, rd, rotate or all on N to M lines\n"
+    "  --engine E             synthesiser: mmd03 (default), mixed (mmd03 with negative controls\n"
+    "                         fixing rows from both ends), beam or symbolic (mmd03 on decision\n"
+    "                         diagrams, fast for targets that move few rows)\n"
+    "  --beam-width N         beam width of the beam engine\n"
+    "  --threads N            synthesis workers, all hardware threads by default\n"
+    "  --queue N              capacity of the read and write queues\n"
+    "  --timeout-ms N         per target deadline, engines then finish the rows left in their\n"
+    "                         cheapest mode\n"
+    "  --output-dir DIR       write every circuit to DIR/NAME.FORMAT\n"
+    "  --format real|rsc|hpp  circuit file format, real by default, hpp for straight-line C++\n"
+    "  --stats PATH           per target JSON lines, stdout by default\n"
+    "  --serve SOCKET         answer synthesis requests on a Unix socket until interrupted\n"
+    "  --cache N              circuits kept warm by the server\n"
+    "  --batch N              most requests a server worker takes at once\n");
+
+const auto FAMILIES = std::array<std::string_view, 7>{"all",      "hwb", "add",   "mul",
+                                                     "graycode", "rd",  "rotate"};
+
+struct generate_spec {
+  std::string family;
+  uint64_t min_bits;
+  uint64_t max_bits;
+};
+
+struct options {
+  std::vector<std::filesystem::path> targets;
+  std::vector<generate_spec> generated;
+  std::string engine = "mmd03";
+  beam_options beam;
+  batch_options batch;
+  std::filesystem::path output_dir;
+  std::string format = "real";
+  std::filesystem::path stats;
+  std::filesystem::path serve;
+  server_options server;
+};
+
+auto parse_number(std::string_view flag, std::string_view text) -> uint64_t {
+  auto value = uint64_t();
+  auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end != text.data() + text.size()) {
+    throw std::invalid_argument("Invalid value for " + std::string(flag));
+  }
+  return value;
+}
+
+auto parse_generate(std::string_view text) -> generate_spec {
+  auto colon = text.find(':');
+  if (colon == std::string_view::npos) {
+    throw std::invalid_argument("--generate expects FAMILY:N[-M]");
+  }
+  auto range = text.substr(colon + 1);
+  auto dash = range.find('-');
+  auto min_bits = parse_number("--generate", range.substr(0, dash));
+  auto max_bits = min_bits;
+  if (dash != std::string_view::npos) {
+    max_bits = parse_number("--generate", range.substr(dash + 1));
+  }
+  if (min_bits == 0 || min_bits > max_bits) {
+    throw std::invalid_argument("Invalid line range for --generate");
+  }
+  auto family = text.substr(0, colon);
+  if (std::find(FAMILIES.begin(), FAMILIES.end(), family) == FAMILIES.end()) {
+    throw std::invalid_argument("Unknown function family " + std::string(family));
+  }
+  return {std::string(family), min_bits, max_bits};
+}
+
+auto parse_options(int argc, char **argv) -> options {
+  auto opts = options();
+  for (auto i = 1; i < argc; i++) {
+    auto flag = std::string_view(argv[i]);
+    if (!flag.starts_with("--")) {
+      opts.targets.emplace_back(flag);
+      continue;
+    }
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Missing value for " + std::string(flag));
+    }
+    auto value = std::string_view(argv[++i]);
+    if (flag == "--generate") {
+      opts.generated.push_back(parse_generate(value));
+    }
+    else if (flag == "--engine") {
+      if (value != "mmd03" && value != "mixed" && value != "beam" && value != "symbolic") {
+        throw std::invalid_argument("Unknown engine " + std::string(value));
+      }
+      opts.engine = value;
+    }
+    else if (flag == "--beam-width") {
+      opts.beam.beam_width = parse_number(flag, value);
+    }
+    else if (flag == "--threads") {
+      opts.batch.threads_num = parse_number(flag, value);
+    }
+    else if (flag == "--queue") {
+      opts.batch.queue_size = parse_number(flag, value);
+    }
+    else if (flag == "--timeout-ms") {
+      opts.batch.item_timeout =
+          std::chrono::milliseconds(static_cast<int64_t>(parse_number(flag, value)));
+    }
+    else if (flag == "--output-dir") {
+      opts.output_dir = value;
+    }
+    else if (flag == "--format") {
+      if (value != "real" && value != "rsc" && value != "hpp") {
+        throw std::invalid_argument("Unknown format " + std::string(value));
+      }
+      opts.format = value;
+    }
+    else if (flag == "--stats") {
+      opts.stats = value;
+    }
+    else if (flag == "--serve") {
+      opts.serve = value;
+    }
+    else if (flag == "--cache") {
+      opts.server.cache_capacity = parse_number(flag, value);
+    }
+    else if (flag == "--batch") {
+      opts.server.batch_size = parse_number(flag, value);
+    }
+    else {
+      throw std::invalid_argument("Unknown option " + std::string(flag));
+    }
+  }
+  opts.server.threads_num = opts.batch.threads_num;
+  if (opts.serve.empty() && opts.targets.empty() && opts.generated.empty()) {
+    throw std::invalid_argument("No targets given");
+  }
+  return opts;
+}
+
+auto read_raw_table(const std::filesystem::path &path) -> truth_table {
+  auto in = std::ifstream(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Cannot open " + path.string());
+  }
+  auto rows = std::vector<uint64_t>(std::filesystem::file_size(path) / sizeof(uint64_t));
+  in.read(reinterpret_cast<char *>(rows.data()),
+          static_cast<std::streamsize>(rows.size() * sizeof(uint64_t)));
+  if (rows.size() < 2 || !std::has_single_bit(rows.size()) || !in) {
+    throw std::invalid_argument("Not a raw truth table: " + path.string());
+  }
+  auto seen = std::vector<bool>(rows.size());
+  for (auto row : rows) {
+    if (row >= rows.size() || seen[row]) {
+      throw std::invalid_argument("Target is not a permutation: " + path.string());
+    }
+    seen[row] = true;
+  }
+  auto tt = truth_table(static_cast<uint64_t>(std::countr_zero(rows.size())));
+  tt.set_data(std::move(rows));
+  return tt;
+}
+
+auto read_target(const std::filesystem::path &path) -> truth_table {
+  auto extension = path.extension();
+  if (extension == ".spec") {
+    return read_spec(path);
+  }
+  if (extension == ".pla") {
+    return read_pla(path);
+  }
+  if (extension == ".real") {
+    return read_real(path).output_tt();
+  }
+  if (extension == ".rsc") {
+    auto reader = binary_circuit_reader(path);
+    auto tt = truth_table(reader.bits_num());
+    reader.apply_back(tt);
+    return tt;
+  }
+  if (extension == ".tt") {
+    return read_raw_table(path);
+  }
+  throw std::invalid_argument("Unknown target format: " + path.string());
+}
+
+auto generate(const std::string &family, uint64_t bits) -> std::vector<named_function> {
+  auto n = std::to_string(bits);
+  if (family == "all") {
+    return standard_functions(bits);
+  }
+  auto functions = std::vector<named_function>();
+  if (family == "hwb") {
+    functions.push_back({"hwb" + n, hwb(bits)});
+  }
+  else if (family == "add") {
+    functions.push_back({"add" + n, modular_adder(bits, 1)});
+  }
+  else if (family == "mul") {
+    functions.push_back({"mul" + n, modular_multiplier(bits, 3)});
+  }
+  else if (family == "graycode") {
+    functions.push_back({"graycode" + n, graycode(bits)});
+  }
+  else if (family == "rotate") {
+    functions.push_back({"rotate" + n, rotation(bits, 1)});
+  }
+  else if (family == "rd") {
+    for (auto &f : standard_functions(bits)) {
+      if (f.name == "rd" + n) {
+        functions.push_back(std::move(f));
+      }
+    }
+  }
+  else {
+    throw std::invalid_argument("Unknown function family " + family);
+  }
+  return functions;
+}
+
+// Yields file targets first, then generated families one line count at a time, so only a few
+// tables are in memory ahead of the workers. A file that cannot be read fails as its own item.
+class target_source {
+  const options &opts_;
+  uint64_t next_index_ = 0;
+  uint64_t next_file_ = 0;
+  uint64_t next_spec_ = 0;
+  uint64_t next_bits_ = 0;
+  std::vector<named_function> pending_;
+
+public:
+  explicit target_source(const options &opts) : opts_(opts) {}
+
+  auto operator()() -> std::optional<batch_item> {
+    if (next_file_ < opts_.targets.size()) {
+      const auto &path = opts_.targets[next_file_++];
+      auto item = batch_item{next_index_++, path.stem().string(), truth_table(1), {}};
+      try {
+        item.target = read_target(path);
+      }
+      catch (const std::exception &e) {
+        item.error = e.what();
+      }
+      return item;
+    }
+    while (pending_.empty()) {
+      if (next_spec_ == opts_.generated.size()) {
+        return std::nullopt;
+      }
+      const auto &spec = opts_.generated[next_spec_];
+      next_bits_ = std::max(next_bits_, spec.min_bits);
+      pending_ = generate(spec.family, next_bits_);
+      if (++next_bits_ > spec.max_bits) {
+        next_spec_++;
+        next_bits_ = 0;
+      }
+    }
+    auto f = std::move(pending_.front());
+    pending_.erase(pending_.begin());
+    return batch_item{next_index_++, std::move(f.name), std::move(f.tt), {}};
+  }
+};
+
+// Serves until SIGINT or SIGTERM. The signals are blocked before any thread starts and taken
+// synchronously by a dedicated thread, which stops the server.
+auto serve(const options &opts, const synthesiser &synth) -> int {
+  auto signals = sigset_t();
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  auto server = synthesis_server(synth, opts.serve, opts.server);
+  auto waiter = std::thread([&]() {
+    auto signal = 0;
+    sigwait(&signals, &signal);
+    server.stop();
+  });
+  std::cerr << "serving " << synth.name() << " on " << opts.serve << "\n";
+  try {
+    server.run();
+  }
+  catch (...) {
+    pthread_kill(waiter.native_handle(), SIGTERM);
+    waiter.join();
+    throw;
+  }
+  waiter.join();
+  auto stats = server.stats();
+  std::cerr << stats.connections << " connections, " << stats.requests << " requests, "
+            << stats.failed << " failed, " << stats.batches << " batches, "
+            << stats.cache.memory_hits << " cache hits\n";
+  return 0;
+}
+
+auto write_circuit(const options &opts, const std::string &name, const circuit &circ) -> void {
+  auto path = opts.output_dir / (name + "." + opts.format);
+  if (opts.format == "rsc") {
+    write_binary(path, circ);
+  }
+  else if (opts.format == "hpp") {
+    // the namespace is the name with anything but letters, digits and _ replaced
+    auto identifier = name;
+    std::replace_if(
+        identifier.begin(), identifier.end(),
+        [](char c) { return std::isalnum(static_cast<unsigned char>(c)) == 0 && c != '_'; }, '_');
+    if (identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier[0])) != 0) {
+      identifier.insert(0, "circuit_");
+    }
+    auto out = std::ofstream(path);
+    write_header(out, circ, identifier);
+    if (!out) {
+      throw std::runtime_error("Cannot write " + path.string());
+    }
+  }
+  else {
+    write_real(path, circ);
+  }
+}
+
+} // namespace
+
+// Batch synthesis: targets are read, synthesised on all workers and written out as they
+// complete, e.g. sts --generate all:4-10 --threads 16 --output-dir out specs/*.spec
+auto main(int argc, char **argv) -> int {
+  auto opts = options();
+  try {
+    opts = parse_options(argc, argv);
+  }
+  catch (const std::exception &e) {
+    std::cerr << e.what() << "\n" << USAGE;
+    return 2;
+  }
+
+  auto synth = std::unique_ptr<synthesiser>();
+  if (opts.engine == "beam") {
+    synth = std::make_unique<mmd03_beam>(opts.beam);
+  }
+  else if (opts.engine == "symbolic") {
+    synth = std::make_unique<mmd03_symbolic>();
+  }
+  else if (opts.engine == "mixed") {
+    synth = std::make_unique<mmd03>(mmd03::synth_mode::mixed);
+  }
+  else {
+    synth = std::make_unique<mmd03>();
+  }
+
+  if (!opts.serve.empty()) {
+    try {
+      return serve(opts, *synth);
+    }
+    catch (const std::exception &e) {
+      std::cerr << e.what() << "\n";
+      return 1;
+    }
+  }
+
+  auto stats_file = std::ofstream();
+  if (!opts.stats.empty()) {
+    stats_file.open(opts.stats);
+    if (!stats_file) {
+      std::cerr << "Cannot write " << opts.stats << "\n";
+      return 1;
+    }
+  }
+  auto &stats_out = opts.stats.empty() ? std::cout : stats_file;
+  if (!opts.output_dir.empty()) {
+    std::filesystem::create_directories(opts.output_dir);
+  }
+
+  auto sink = [&](const batch_result &r) {
+    if (r.circ && !opts.output_dir.empty()) {
+      write_circuit(opts, r.name, *r.circ);
+    }
+    stats_out << "{\"index\": " << r.index << ", \"name\": " << json_string(r.name)
+              << ", \"bits\": " << r.bits_num << ", \"engine\": " << json_string(synth->name())
+              << ", \"time_ms\": " << std::chrono::duration<double, std::milli>(r.time).count();
+    if (r.circ) {
+      stats_out << ", \"gates\": " << r.circ->gates_num()
+                << ", \"controls\": " << r.circ->controls_num()
+                << ", \"quantum_cost\": " << r.circ->quantum_cost();
+    }
+    else {
+      stats_out << ", \"error\": " << json_string(r.error);
+    }
+    stats_out << "}" << std::endl;
+  };
+
+  try {
+    auto source = target_source(opts);
+    auto totals = run_batch(std::ref(source), *synth, sink, opts.batch);
+    std::cerr << totals.items << " targets, " << totals.failed << " failed, "
+              << std::chrono::duration<double>(totals.wall_time).count() << " s wall, "
+              << std::chrono::duration<double>(totals.synthesis_time).count()
+              << " s synthesis\n";
+    return totals.failed == 0 ? 0 : 1;
+  }
+  catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+}
@@ -0,0 +1,202 @@
+#include "memory.hpp"
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+
+namespace {
+
+thread_local std::pmr::memory_resource *thread_resource = std::pmr::new_delete_resource();
+std::atomic<table_policy> policy{table_policy::huge_pages};
+
+auto round_up(uint64_t value, uint64_t multiple) -> uint64_t {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+// Size of the pages MAP_HUGETLB maps without a MAP_HUGE_* size flag.
+auto default_huge_page_size() -> uint64_t {
+  auto meminfo = std::ifstream("/proc/meminfo");
+  for (auto line = std::string(); std::getline(meminfo, line);) {
+    if (line.starts_with("Hugepagesize:")) {
+      return std::stoull(line.substr(13)) << 10; // in kB
+    }
+  }
+  return HUGE_PAGE_SIZE;
+}
+
+} // namespace
+
+auto current_resource() noexcept -> std::pmr::memory_resource * { return thread_resource; }
+
+scoped_resource::scoped_resource(std::pmr::memory_resource *resource) noexcept
+    : previous_(thread_resource) {
+  thread_resource = resource;
+}
+
+scoped_resource::~scoped_resource() { thread_resource = previous_; }
+
+accounting_resource::accounting_resource(std::pmr::memory_resource *upstream)
+    : upstream_(upstream) {}
+
+auto accounting_resource::do_allocate(std::size_t bytes, std::size_t alignment) -> void * {
+  auto *p = upstream_->allocate(bytes, alignment);
+  bytes_allocated_.fetch_add(bytes, std::memory_order_relaxed);
+  allocations_.fetch_add(1, std::memory_order_relaxed);
+  auto in_use = bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  auto peak = peak_bytes_.load(std::memory_order_relaxed);
+  while (in_use > peak && !peak_bytes_.compare_exchange_weak(peak, in_use)) {
+  }
+  return p;
+}
+
+auto accounting_resource::do_deallocate(void *p, std::size_t bytes, std::size_t alignment)
+    -> void {
+  upstream_->deallocate(p, bytes, alignment);
+  bytes_in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+auto accounting_resource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+    -> bool {
+  return this == &other;
+}
+
+auto accounting_resource::bytes_allocated() const noexcept -> uint64_t {
+  return bytes_allocated_.load(std::memory_order_relaxed);
+}
+
+auto accounting_resource::bytes_in_use() const noexcept -> uint64_t {
+  return bytes_in_use_.load(std::memory_order_relaxed);
+}
+
+auto accounting_resource::peak_bytes() const noexcept -> uint64_t {
+  return peak_bytes_.load(std::memory_order_relaxed);
+}
+
+auto accounting_resource::allocations() const noexcept -> uint64_t {
+  return allocations_.load(std::memory_order_relaxed);
+}
+
+auto accounting_resource::reset_peak() noexcept -> void {
+  peak_bytes_.store(bytes_in_use(), std::memory_order_relaxed);
+}
+
+huge_page_resource::huge_page_resource(bool explicit_pages, std::pmr::memory_resource *upstream)
+    : upstream_(upstream), explicit_(explicit_pages),
+      explicit_page_size_(explicit_pages ? default_huge_page_size() : HUGE_PAGE_SIZE) {}
+
+auto huge_page_resource::do_allocate(std::size_t bytes, std::size_t alignment) -> void * {
+  if (bytes < HUGE_PAGE_SIZE || alignment > HUGE_PAGE_SIZE) {
+    return upstream_->allocate(bytes, std::max(alignment, TABLE_ALIGNMENT));
+  }
+  if (explicit_ && bytes >= explicit_page_size_) {
+    auto explicit_length = round_up(bytes, explicit_page_size_);
+    auto *p = ::mmap(nullptr, explicit_length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      {
+        auto lock = std::lock_guard(explicit_mutex_);
+        explicit_pointers_.insert(p);
+      }
+      mappings_.fetch_add(1, std::memory_order_relaxed);
+      explicit_mappings_.fetch_add(1, std::memory_order_relaxed);
+      mapped_bytes_.fetch_add(explicit_length, std::memory_order_relaxed);
+      return p;
+    }
+  }
+
+  auto length = round_up(bytes, HUGE_PAGE_SIZE);
+
+  // Over-map by one huge page and trim both ends, so the mapping starts on a huge page boundary
+  // and the kernel can back it with huge pages from the first byte.
+  auto *raw = ::mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (raw == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  auto begin = reinterpret_cast<uintptr_t>(raw);
+  auto aligned = round_up(begin, HUGE_PAGE_SIZE);
+  if (aligned > begin) {
+    ::munmap(raw, aligned - begin);
+  }
+  auto tail = HUGE_PAGE_SIZE - (aligned - begin);
+  if (tail > 0) {
+    ::munmap(reinterpret_cast<void *>(aligned + length), tail);
+  }
+  auto *p = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+  ::madvise(p, length, MADV_HUGEPAGE);
+#endif
+  mappings_.fetch_add(1, std::memory_order_relaxed);
+  mapped_bytes_.fetch_add(length, std::memory_order_relaxed);
+  return p;
+}
+
+auto huge_page_resource::do_deallocate(void *p, std::size_t bytes, std::size_t alignment)
+    -> void {
+  if (bytes < HUGE_PAGE_SIZE || alignment > HUGE_PAGE_SIZE) {
+    upstream_->deallocate(p, bytes, std::max(alignment, TABLE_ALIGNMENT));
+    return;
+  }
+  if (explicit_) {
+    auto lock = std::unique_lock(explicit_mutex_);
+    if (explicit_pointers_.erase(p) > 0) {
+      lock.unlock();
+      auto length = round_up(bytes, explicit_page_size_);
+      ::munmap(p, length);
+      mappings_.fetch_sub(1, std::memory_order_relaxed);
+      explicit_mappings_.fetch_sub(1, std::memory_order_relaxed);
+      mapped_bytes_.fetch_sub(length, std::memory_order_relaxed);
+      return;
+    }
+  }
+  auto length = round_up(bytes, HUGE_PAGE_SIZE);
+  ::munmap(p, length);
+  mappings_.fetch_sub(1, std::memory_order_relaxed);
+  mapped_bytes_.fetch_sub(length, std::memory_order_relaxed);
+}
+
+auto huge_page_resource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+    -> bool {
+  return this == &other;
+}
+
+auto huge_page_resource::mappings() const noexcept -> uint64_t {
+  return mappings_.load(std::memory_order_relaxed);
+}
+
+auto huge_page_resource::explicit_mappings() const noexcept -> uint64_t {
+  return explicit_mappings_.load(std::memory_order_relaxed);
+}
+
+auto huge_page_resource::mapped_bytes() const noexcept -> uint64_t {
+  return mapped_bytes_.load(std::memory_order_relaxed);
+}
+
+auto large_table_resource() -> huge_page_resource & {
+  static auto instance = huge_page_resource();
+  return instance;
+}
+
+auto current_table_policy() noexcept -> table_policy {
+  return policy.load(std::memory_order_relaxed);
+}
+
+auto set_table_policy(table_policy new_policy) noexcept -> void {
+  policy.store(new_policy, std::memory_order_relaxed);
+}
+
+auto table_policy_name(table_policy p) -> const char * {
+  return p == table_policy::heap ? "heap" : "huge_pages";
+}
+
+auto parallel_table(uint64_t rows) noexcept -> bool {
+  return rows >= LARGE_TABLE_ROWS && current_table_policy() == table_policy::huge_pages;
+}
+
+auto table_resource(uint64_t rows) noexcept -> std::pmr::memory_resource * {
+  if (parallel_table(rows) && thread_resource == std::pmr::new_delete_resource()) {
+    return &large_table_resource();
+  }
+  return thread_resource;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// truth_table and gate allocate their storage from the current resource of the thread that
+// constructs or copies them. It defaults to the global heap; scoped_resource swaps it for the
+// lifetime of a scope, so a whole synthesis can run out of an arena without threading an
+// allocator through every call. Worker threads start from the default resource.
+
+[[nodiscard]] auto current_resource() noexcept -> std::pmr::memory_resource *;
+
+class scoped_resource {
+  std::pmr::memory_resource *previous_;
+
+public:
+  explicit scoped_resource(std::pmr::memory_resource *resource) noexcept;
+  scoped_resource(const scoped_resource &) = delete;
+  auto operator=(const scoped_resource &) -> scoped_resource & = delete;
+  ~scoped_resource();
+};
+
+// Forwards to upstream and counts what passes through. Safe to share between threads.
+class accounting_resource : public std::pmr::memory_resource {
+  std::pmr::memory_resource *upstream_;
+  std::atomic<uint64_t> bytes_allocated_{0};
+  std::atomic<uint64_t> bytes_in_use_{0};
+  std::atomic<uint64_t> peak_bytes_{0};
+  std::atomic<uint64_t> allocations_{0};
+
+  auto do_allocate(std::size_t bytes, std::size_t alignment) -> void * override;
+  auto do_deallocate(void *p, std::size_t bytes, std::size_t alignment) -> void override;
+  [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource &other) const noexcept
+      -> bool override;
+
+public:
+  explicit accounting_resource(std::pmr::memory_resource *upstream = current_resource());
+
+  [[nodiscard]] auto bytes_allocated() const noexcept -> uint64_t;
+  [[nodiscard]] auto bytes_in_use() const noexcept -> uint64_t;
+  [[nodiscard]] auto peak_bytes() const noexcept -> uint64_t;
+  [[nodiscard]] auto allocations() const noexcept -> uint64_t;
+  // Starts a new peak measurement from the bytes currently in use.
+  auto reset_peak() noexcept -> void;
+};
+
+struct arena_stats {
+  uint64_t bytes_allocated; // requested by the objects built in the arena
+  uint64_t arena_bytes;     // taken from the upstream resource by the arena
+  uint64_t allocations;
+};
+
+// Runs f with a monotonic arena as the current resource and frees the arena in one go when f
+// returns. Nothing is released before that, which suits the short lived tables of a synthesis.
+// The result is copied out under the previous resource before the arena goes away.
+template <typename F>
+auto with_arena(F &&f, arena_stats *stats = nullptr) -> std::invoke_result_t<F> {
+  auto upstream = accounting_resource();
+  auto arena = std::pmr::monotonic_buffer_resource(&upstream);
+  auto objects = accounting_resource(&arena);
+  auto result = [&]() {
+    auto scope = scoped_resource(&objects);
+    return std::forward<F>(f)();
+  }();
+  auto copy = std::invoke_result_t<F>(result);
+  if (stats != nullptr) {
+    *stats = {objects.bytes_allocated(), upstream.peak_bytes(), objects.allocations()};
+  }
+  return copy;
+}
+
+// polymorphic_allocator that default-initialises instead of value-initialising, so a vector of
+// n rows leaves its storage untouched until the rows are written. Large tables rely on this to
+// have their pages first touched by the threads that fill them.
+template <typename T> class table_allocator : public std::pmr::polymorphic_allocator<T> {
+public:
+  using std::pmr::polymorphic_allocator<T>::polymorphic_allocator;
+  using std::pmr::polymorphic_allocator<T>::construct;
+  template <typename U> struct rebind {
+    using other = table_allocator<U>;
+  };
+
+  table_allocator() noexcept = default;
+  template <typename U>
+  table_allocator(const table_allocator<U> &other) noexcept
+      : std::pmr::polymorphic_allocator<T>(other.resource()) {}
+
+  template <typename U> auto construct(U *p) noexcept -> void {
+    ::new (static_cast<void *>(p)) U;
+  }
+  [[nodiscard]] auto select_on_container_copy_construction() const -> table_allocator {
+    return {};
+  }
+};
+
+using table_rows = std::vector<uint64_t, table_allocator<uint64_t>>;
+
+const auto TABLE_ALIGNMENT = 64UL;
+const auto HUGE_PAGE_SIZE = 2UL << 20;
+
+// Serves allocations of at least HUGE_PAGE_SIZE bytes from their own anonymous mappings, aligned
+// to HUGE_PAGE_SIZE and advised as transparent huge pages. With explicit set, allocations of at
+// least the system's default huge page size, read from /proc/meminfo, try a mapping from the
+// hugetlbfs pool first. Smaller allocations go to upstream, aligned to TABLE_ALIGNMENT.
+// Pages are left untouched, so they are placed on the node of the thread that first writes them.
+class huge_page_resource : public std::pmr::memory_resource {
+  std::pmr::memory_resource *upstream_;
+  bool explicit_;
+  uint64_t explicit_page_size_;
+  std::mutex explicit_mutex_;
+  std::unordered_set<void *> explicit_pointers_; // tells the pool mappings apart on deallocate
+  std::atomic<uint64_t> mappings_{0};
+  std::atomic<uint64_t> explicit_mappings_{0};
+  std::atomic<uint64_t> mapped_bytes_{0};
+
+  auto do_allocate(std::size_t bytes, std::size_t alignment) -> void * override;
+  auto do_deallocate(void *p, std::size_t bytes, std::size_t alignment) -> void override;
+  [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource &other) const noexcept
+      -> bool override;
+
+public:
+  explicit huge_page_resource(bool explicit_pages = false,
+                              std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+
+  // mappings currently held, how many of them come from the hugetlbfs pool and their size
+  [[nodiscard]] auto mappings() const noexcept -> uint64_t;
+  [[nodiscard]] auto explicit_mappings() const noexcept -> uint64_t;
+  [[nodiscard]] auto mapped_bytes() const noexcept -> uint64_t;
+};
+
+// How truth tables of at least LARGE_TABLE_ROWS rows are allocated while the current resource is
+// the default heap: from the heap and filled by one thread, or from large_table_resource() and
+// filled in parallel. Tables built under a scoped_resource always use that resource.
+enum class table_policy { heap, huge_pages };
+
+const auto LARGE_TABLE_ROWS = 1UL << 20;
+
+[[nodiscard]] auto large_table_resource() -> huge_page_resource &;
+[[nodiscard]] auto current_table_policy() noexcept -> table_policy;
+auto set_table_policy(table_policy policy) noexcept -> void;
+[[nodiscard]] auto table_policy_name(table_policy policy) -> const char *;
+// Resource and fill parallelism for a new table of rows rows on this thread.
+[[nodiscard]] auto table_resource(uint64_t rows) noexcept -> std::pmr::memory_resource *;
+[[nodiscard]] auto parallel_table(uint64_t rows) noexcept -> bool;
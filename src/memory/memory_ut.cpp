@@ -0,0 +1,140 @@
+#include "memory.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <bit>
+#include <random>
+#include <ranges>
+#include <thread>
+
+namespace memory_ut {
+const auto EPOCHS = 20;
+const auto max_bits = 8;
+std::mt19937_64 mrnd;
+} // namespace memory_ut
+
+using namespace memory_ut;
+
+TEST_CASE("scoped resources", "[memory]") {
+  auto *heap = current_resource();
+  auto outer = accounting_resource();
+  {
+    auto scope = scoped_resource(&outer);
+    REQUIRE(current_resource() == &outer);
+    {
+      auto inner = accounting_resource();
+      auto inner_scope = scoped_resource(&inner);
+      REQUIRE(current_resource() == &inner);
+      auto worker = std::thread([heap]() { REQUIRE(current_resource() == heap); });
+      worker.join();
+    }
+    REQUIRE(current_resource() == &outer);
+  }
+  REQUIRE(current_resource() == heap);
+}
+
+TEST_CASE("accounting truth tables and gates", "[memory]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  auto accounting = accounting_resource();
+  auto scope = scoped_resource(&accounting);
+  auto row_bytes = (1UL << bits) * sizeof(uint64_t);
+
+  {
+    auto tt = truth_table(bits);
+    REQUIRE(accounting.bytes_in_use() == row_bytes);
+    auto copy = tt;
+    REQUIRE(accounting.bytes_in_use() == 2 * row_bytes);
+    auto moved = std::move(copy);
+    REQUIRE(accounting.bytes_in_use() == 2 * row_bytes);
+
+    auto g = gate(bits, mrnd);
+    auto g_copy = g;
+    REQUIRE(accounting.allocations() == 2 + 2 * (g.controls_num() > 0 ? 1 : 0));
+  }
+  REQUIRE(accounting.bytes_in_use() == 0);
+  REQUIRE(accounting.peak_bytes() >= 2 * row_bytes);
+  accounting.reset_peak();
+  REQUIRE(accounting.peak_bytes() == 0);
+}
+
+TEST_CASE("synthesis in an arena", "[memory], [mmd03]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  auto target = truth_table(bits).shuffle(mrnd);
+  auto expected = mmd03().synthesize(target);
+
+  auto outer = accounting_resource();
+  auto scope = scoped_resource(&outer);
+  auto stats = arena_stats();
+  auto circ = with_arena([&]() { return mmd03().synthesize(target); }, &stats);
+
+  REQUIRE(circ == expected);
+  REQUIRE(stats.bytes_allocated >= (1UL << bits) * sizeof(uint64_t));
+  REQUIRE(stats.arena_bytes >= stats.bytes_allocated);
+  // only the copied out circuit is left once the arena is gone
+  auto result_bytes = outer.bytes_in_use();
+  REQUIRE(result_bytes > 0);
+  REQUIRE(result_bytes < outer.peak_bytes());
+}
+
+TEST_CASE("huge page resource", "[memory], [huge_pages]") {
+  auto upstream = accounting_resource();
+  auto resource = huge_page_resource(false, &upstream);
+
+  auto *small = resource.allocate(100, 8);
+  REQUIRE(reinterpret_cast<uintptr_t>(small) % TABLE_ALIGNMENT == 0);
+  REQUIRE(upstream.bytes_in_use() == 100);
+  REQUIRE(resource.mappings() == 0);
+
+  auto bytes = HUGE_PAGE_SIZE + 1 + mrnd() % HUGE_PAGE_SIZE;
+  auto *large = static_cast<uint8_t *>(resource.allocate(bytes, 8));
+  REQUIRE(reinterpret_cast<uintptr_t>(large) % HUGE_PAGE_SIZE == 0);
+  REQUIRE(resource.mappings() == 1);
+  REQUIRE(resource.mapped_bytes() == 2 * HUGE_PAGE_SIZE);
+  large[0] = 1;
+  large[bytes - 1] = 2;
+  REQUIRE(large[0] + large[bytes - 1] == 3);
+
+  resource.deallocate(large, bytes, 8);
+  resource.deallocate(small, 100, 8);
+  REQUIRE(resource.mappings() == 0);
+  REQUIRE(resource.mapped_bytes() == 0);
+  REQUIRE(upstream.bytes_in_use() == 0);
+
+  // served from the hugetlbfs pool where it has pages, by transparent huge pages otherwise
+  auto explicit_resource = huge_page_resource(true, &upstream);
+  auto *pooled = explicit_resource.allocate(4 * HUGE_PAGE_SIZE, 8);
+  REQUIRE(explicit_resource.mappings() == 1);
+  REQUIRE(explicit_resource.explicit_mappings() <= 1);
+  REQUIRE(explicit_resource.mapped_bytes() >= 4 * HUGE_PAGE_SIZE);
+  explicit_resource.deallocate(pooled, 4 * HUGE_PAGE_SIZE, 8);
+  REQUIRE(explicit_resource.mappings() == 0);
+  REQUIRE(explicit_resource.explicit_mappings() == 0);
+  REQUIRE(explicit_resource.mapped_bytes() == 0);
+}
+
+TEST_CASE("large truth tables", "[memory], [huge_pages]") {
+  const auto bits = static_cast<uint64_t>(std::countr_zero(LARGE_TABLE_ROWS));
+  auto *large_resource = static_cast<std::pmr::memory_resource *>(&large_table_resource());
+
+  for (auto policy : {table_policy::heap, table_policy::huge_pages}) {
+    set_table_policy(policy);
+    auto tt = truth_table(bits);
+    auto copy = tt;
+    auto small = truth_table(bits - 1);
+    REQUIRE(std::equal(tt.begin(), tt.end(), std::views::iota(0UL).begin()));
+    REQUIRE(copy == tt);
+    REQUIRE(small.data().get_allocator().resource() == current_resource());
+    auto expected = policy == table_policy::huge_pages ? large_resource : current_resource();
+    REQUIRE(tt.data().get_allocator().resource() == expected);
+    REQUIRE(copy.data().get_allocator().resource() == expected);
+
+    // tables built under a scoped resource stay there whatever the policy
+    auto accounting = accounting_resource();
+    auto scope = scoped_resource(&accounting);
+    auto scoped = truth_table(bits);
+    REQUIRE(scoped.data().get_allocator().resource() == &accounting);
+    REQUIRE(scoped == tt);
+  }
+  set_table_policy(table_policy::huge_pages);
+}
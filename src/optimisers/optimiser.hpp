@@ -0,0 +1,29 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "cost/cost.hpp"
+#include <cstdint>
+
+struct optimisation_report {
+  uint64_t gates_before = 0;
+  uint64_t gates_after = 0;
+  uint64_t controls_before = 0;
+  uint64_t controls_after = 0;
+  uint64_t passes = 0;
+  cost_vector cost_before;
+  cost_vector cost_after;
+
+  [[nodiscard]] auto gates_removed() const -> int64_t {
+    return static_cast<int64_t>(gates_before) - static_cast<int64_t>(gates_after);
+  }
+  [[nodiscard]] auto controls_removed() const -> int64_t {
+    return static_cast<int64_t>(controls_before) - static_cast<int64_t>(controls_after);
+  }
+};
+
+class optimiser {
+public:
+  optimiser() = default;
+  virtual ~optimiser() = default;
+  // Rewrites circ in place into an equivalent circuit.
+  virtual auto optimize(circuit &circ) const -> optimisation_report = 0;
+};
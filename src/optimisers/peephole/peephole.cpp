@@ -0,0 +1,190 @@
+#include "peephole.hpp"
+#include <array>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Control mask, polarity mask and targets of a self-inverse gate, which tell Toffoli and Fredkin
+// gates apart by the number of targets.
+using gate_key = std::array<uint64_t, 3>;
+
+struct gate_key_hash {
+  auto operator()(const gate_key &key) const noexcept -> std::size_t {
+    return (key[0] * 0x9E3779B97F4A7C15UL ^ key[1]) * 0xC2B2AE3D27D4EB4FUL ^ key[2];
+  }
+};
+
+auto written_lines(const gate &g) -> std::vector<uint64_t> {
+  if (g.kind() == gate_kind::toffoli) {
+    return {g.target()};
+  }
+  return {g.target(), g.second_target()};
+}
+
+auto is_positive_toffoli(const gate &g) -> bool {
+  return g.kind() == gate_kind::toffoli && g.polarity_mask() == g.control_mask();
+}
+
+// Positions of alive gates, newest last. Dead positions are dropped lazily when they surface.
+auto last_alive(std::vector<uint64_t> &positions, const std::vector<bool> &alive)
+    -> std::optional<uint64_t> {
+  while (!positions.empty() && !alive[positions.back()]) {
+    positions.pop_back();
+  }
+  if (positions.empty()) {
+    return std::nullopt;
+  }
+  return positions.back();
+}
+
+auto make_gate(uint64_t size, uint64_t control_mask, uint64_t target) -> gate {
+  return {size, state(size, control_mask).ones(), target};
+}
+
+// Two gate replacement of the g h g triple, if it matches one of the templates.
+auto match_template(const gate &g, const gate &h) -> std::optional<std::pair<gate, gate>> {
+  auto size = g.size();
+  if (g.target() == h.target()) {
+    return std::nullopt;
+  }
+  // g = T(C + a; t), h = T(D; a), t not in D
+  if ((g.control_mask() & h.target_mask()) != 0 && (h.control_mask() & g.target_mask()) == 0) {
+    auto merged = (g.control_mask() & ~h.target_mask()) | h.control_mask();
+    return std::pair{h, make_gate(size, merged, g.target())};
+  }
+  // g = T(C; a), h = T(D + a; t), t not in C
+  if ((h.control_mask() & g.target_mask()) != 0 && (g.control_mask() & h.target_mask()) == 0) {
+    auto merged = g.control_mask() | (h.control_mask() & ~g.target_mask());
+    return std::pair{make_gate(size, merged, h.target()), h};
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+peephole::peephole(uint64_t max_passes) : max_passes_(max_passes) {}
+
+auto peephole::commute(const gate &lhs, const gate &rhs) -> bool {
+  if (lhs.kind() == gate_kind::toffoli && rhs.kind() == gate_kind::toffoli) {
+    return (lhs.target_mask() & rhs.control_mask()) == 0 &&
+           (rhs.target_mask() & lhs.control_mask()) == 0;
+  }
+  // Fredkin and Peres gates also read their targets, and only xors of one target commute
+  auto lhs_writes = lhs.target_mask() | lhs.second_target_mask();
+  auto rhs_writes = rhs.target_mask() | rhs.second_target_mask();
+  return (lhs_writes & rhs.lines_mask()) == 0 && (rhs_writes & lhs.lines_mask()) == 0;
+}
+
+auto peephole::cancel_pass(const std::deque<gate> &gates) -> std::deque<gate> {
+  if (gates.empty()) {
+    return {};
+  }
+  auto size = gates.front().size();
+  auto kept = std::vector<gate>();
+  auto alive = std::vector<bool>();
+  auto by_target = std::vector<std::vector<uint64_t>>(size);
+  auto by_control = std::vector<std::vector<uint64_t>>(size);
+  auto identical = std::unordered_map<gate_key, std::vector<uint64_t>, gate_key_hash>();
+  auto no_twins = std::vector<uint64_t>();
+
+  for (const auto &g : gates) {
+    auto writes = written_lines(g);
+    auto key = gate_key{g.control_mask(), g.polarity_mask(),
+                        g.target_mask() | g.second_target_mask()};
+    // Peres gates are not self-inverse and never cancel
+    auto &twins = g.is_self_inverse() ? identical[key] : no_twins;
+    if (auto partner = last_alive(twins, alive)) {
+      // g meets its twin iff every later gate commutes with it: none of them targets a control
+      // of g, and none of them reads a target of g. Targets of Fredkin gates may not be written
+      // in between either.
+      auto blocked = [&](std::vector<uint64_t> &positions) {
+        auto last = last_alive(positions, alive);
+        return last.has_value() && *last > *partner;
+      };
+      auto is_blocked = false;
+      for (auto w : writes) {
+        is_blocked = is_blocked || blocked(by_control[w]);
+        is_blocked = is_blocked || (g.kind() != gate_kind::toffoli && blocked(by_target[w]));
+      }
+      for (auto c : g.controls()) {
+        is_blocked = is_blocked || blocked(by_target[c]);
+      }
+      if (!is_blocked) {
+        alive[*partner] = false;
+        continue;
+      }
+    }
+
+    auto position = kept.size();
+    kept.push_back(g);
+    alive.push_back(true);
+    if (g.is_self_inverse()) {
+      twins.push_back(position);
+    }
+    for (auto w : writes) {
+      by_target[w].push_back(position);
+      if (g.kind() != gate_kind::toffoli) {
+        by_control[w].push_back(position);
+      }
+    }
+    for (auto c : g.controls()) {
+      by_control[c].push_back(position);
+    }
+  }
+
+  auto result = std::deque<gate>();
+  for (auto i = 0UL; i < kept.size(); i++) {
+    if (alive[i]) {
+      result.push_back(kept[i]);
+    }
+  }
+  return result;
+}
+
+auto peephole::template_pass(const std::deque<gate> &gates) -> std::deque<gate> {
+  auto result = std::deque<gate>();
+  for (const auto &g : gates) {
+    result.push_back(g);
+    auto n = result.size();
+    if (n >= 2 && result[n - 2] == result[n - 1] && g.is_self_inverse()) {
+      result.pop_back();
+      result.pop_back();
+      continue;
+    }
+    if (n < 3 || result[n - 3] != result[n - 1] || !is_positive_toffoli(result[n - 1]) ||
+        !is_positive_toffoli(result[n - 2])) {
+      continue;
+    }
+    if (auto replacement = match_template(result[n - 1], result[n - 2])) {
+      result.erase(result.end() - 3, result.end());
+      result.push_back(replacement->first);
+      result.push_back(replacement->second);
+    }
+  }
+  return result;
+}
+
+auto peephole::optimize(circuit &circ) const -> optimisation_report {
+  auto report = optimisation_report();
+  report.gates_before = circ.gates_num();
+  report.controls_before = circ.controls_num();
+  report.cost_before = circ.cost();
+
+  auto gates = circ.gates();
+  for (; report.passes < max_passes_; report.passes++) {
+    auto before = gates.size();
+    gates = template_pass(cancel_pass(gates));
+    if (gates.size() == before) {
+      report.passes++;
+      break;
+    }
+  }
+
+  circ.replace_gates(std::move(gates));
+  report.gates_after = circ.gates_num();
+  report.controls_after = circ.controls_num();
+  report.cost_after = circ.cost();
+  return report;
+}
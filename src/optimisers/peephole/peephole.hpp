@@ -0,0 +1,23 @@
+#pragma once
+#include "optimisers/optimiser.hpp"
+#include <cstdint>
+
+// Peephole optimisation of Toffoli circuits. Every pass first cancels pairs of identical gates
+// which can be moved next to each other through commuting gates, then rewrites g h g triples
+// matching the reduction templates into two gates:
+//   T(C+a; t) T(D; a) T(C+a; t) = T(D; a) T(C+D; t)   when t not in D
+//   T(C; a) T(D+a; t) T(C; a)   = T(C+D; t) T(D+a; t) when t not in C
+// Gates with negative controls and Fredkin gates only cancel against their twins, Peres gates
+// are left as they are. Passes repeat until a fixed point or max_passes.
+class peephole : public optimiser {
+  uint64_t max_passes_;
+
+public:
+  explicit peephole(uint64_t max_passes = 16);
+
+  static auto commute(const gate &lhs, const gate &rhs) -> bool;
+  static auto cancel_pass(const std::deque<gate> &gates) -> std::deque<gate>;
+  static auto template_pass(const std::deque<gate> &gates) -> std::deque<gate>;
+
+  auto optimize(circuit &circ) const -> optimisation_report;
+};
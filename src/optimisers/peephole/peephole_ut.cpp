@@ -0,0 +1,110 @@
+#include "peephole.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <random>
+
+namespace peephole_ut {
+const auto EPOCHS = 1000;
+const auto max_bits = 10;
+std::mt19937_64 mrnd;
+
+// output_tt is kept by replace_gates, so rewrites are checked on a fresh simulation of the gates
+auto recomputed_tt(const circuit &circ) -> truth_table {
+  auto tt = truth_table(circ.bits_num());
+  for (const auto &g : circ.gates()) {
+    g.apply_back(tt);
+  }
+  return tt;
+}
+} // namespace peephole_ut
+
+using namespace peephole_ut;
+
+TEST_CASE("peephole keeps circuit function", "[peephole]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto tested = circuit(bits);
+  auto gates_num = 1 + mrnd() % 64;
+  for (auto i = 0UL; i < gates_num; i++) {
+    // few distinct small gates, so that cancellations and templates do occur
+    auto g = gate(bits, mrnd);
+    tested.push_back(g.controls_num() > 1 ? gate(bits, {}, g.target()) : g);
+  }
+  auto reference = tested;
+
+  auto report = peephole().optimize(tested);
+  REQUIRE(report.gates_before == reference.gates_num());
+  REQUIRE(report.gates_after == tested.gates_num());
+  REQUIRE(report.gates_removed() >= 0);
+  REQUIRE(recomputed_tt(tested) == reference.output_tt());
+}
+
+TEST_CASE("peephole rules", "[peephole]") {
+  const auto bits = 4UL;
+  auto circ = circuit(bits);
+
+  SECTION("cancellation through commuting gates") {
+    circ.push_back(gate(bits, {0, 1}, 2));
+    circ.push_back(gate(bits, {0}, 3));
+    circ.push_back(gate(bits, {1}, 2));
+    circ.push_back(gate(bits, {0, 1}, 2));
+    auto report = peephole().optimize(circ);
+    REQUIRE(circ.gates() == std::deque<gate>{gate(bits, {0}, 3), gate(bits, {1}, 2)});
+    REQUIRE(report.gates_removed() == 2);
+    REQUIRE(report.controls_removed() == 4);
+  }
+
+  SECTION("blocked cancellation") {
+    circ.push_back(gate(bits, {0, 1}, 2));
+    circ.push_back(gate(bits, {2}, 3));
+    circ.push_back(gate(bits, {0, 1}, 2));
+    auto report = peephole().optimize(circ);
+    REQUIRE(circ.gates_num() == 2);
+    REQUIRE(report.gates_removed() == 1);
+  }
+
+  SECTION("templates") {
+    circ.push_back(gate(bits, {1}, 0));
+    circ.push_back(gate(bits, {2}, 1));
+    circ.push_back(gate(bits, {1}, 0));
+    circ.push_back(gate(bits, {}, 3));
+    circ.push_back(gate(bits, {3}, 2));
+    circ.push_back(gate(bits, {}, 3));
+    auto reference = circ.output_tt();
+    auto report = peephole().optimize(circ);
+    REQUIRE(report.gates_removed() == 2);
+    REQUIRE(recomputed_tt(circ) == reference);
+  }
+
+  SECTION("mixed polarity, Fredkin and Peres gates") {
+    auto negative = gate(bits, {0, 1}, 2).with_polarity(1);
+    auto peres = gate::peres(bits, {0}, 1, 2);
+    circ.push_back(negative);
+    circ.push_back(gate::fredkin(bits, {}, 1, 3));
+    circ.push_back(gate::fredkin(bits, {}, 1, 3));
+    circ.push_back(gate(bits, {0, 1}, 2));
+    circ.push_back(negative);
+    circ.push_back(peres);
+    circ.push_back(peres);
+    auto reference = circ.output_tt();
+    auto report = peephole().optimize(circ);
+    REQUIRE(report.gates_removed() == 4);
+    REQUIRE(circ.gates() == std::deque<gate>{gate(bits, {0, 1}, 2), peres, peres});
+    REQUIRE(recomputed_tt(circ) == reference);
+
+    circ.push_back(peres.inverse());
+    circ.push_back(peres);
+    peephole().optimize(circ);
+    REQUIRE(recomputed_tt(circ) == reference);
+  }
+}
+
+TEST_CASE("peephole on mmd03 circuits", "[peephole], [mmd03]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(100, random(2, 6))));
+
+  auto target_tt = truth_table(bits).shuffle(mrnd);
+  auto circ = mmd03().synthesize(target_tt);
+  peephole().optimize(circ);
+  REQUIRE(recomputed_tt(circ) == target_tt);
+}
@@ -0,0 +1,204 @@
+#include "window.hpp"
+#include "parallel/parallel.hpp"
+#include <array>
+#include <bit>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+
+namespace {
+
+const auto NO_GATE = std::numeric_limits<uint8_t>::max();
+
+auto apply_local(const gate &g, std::vector<uint64_t> &permutation) -> void {
+  for (auto &row : permutation) {
+    row = g.apply(row);
+  }
+}
+
+auto permutation_rank(const std::vector<uint64_t> &permutation) -> uint64_t {
+  auto rank = 0UL;
+  for (auto i = 0UL; i < permutation.size(); i++) {
+    auto smaller_after = 0UL;
+    for (auto j = i + 1; j < permutation.size(); j++) {
+      smaller_after += permutation[j] < permutation[i] ? 1 : 0;
+    }
+    rank = rank * (permutation.size() - i) + smaller_after;
+  }
+  return rank;
+}
+
+// Last gate of an optimal circuit of every permutation of 2^lines rows, indexed by rank.
+struct optimal_table {
+  std::vector<gate> gates;
+  std::vector<uint8_t> last_gate;
+
+  explicit optimal_table(uint64_t lines) {
+    for (auto target = 0UL; target < lines; target++) {
+      auto others = ((1UL << lines) - 1) & ~(1UL << target);
+      for (auto controls = others;; controls = (controls - 1) & others) {
+        gates.emplace_back(lines, state(lines, controls).ones(), target);
+        if (controls == 0) {
+          break;
+        }
+      }
+    }
+
+    auto rows = 1UL << lines;
+    auto count = 1UL;
+    for (auto i = 2UL; i <= rows; i++) {
+      count *= i;
+    }
+    last_gate = std::vector<uint8_t>(count, NO_GATE);
+
+    auto identity = std::vector<uint64_t>(1UL << lines);
+    std::iota(identity.begin(), identity.end(), 0);
+    auto queue = std::queue<std::vector<uint64_t>>();
+    queue.push(identity);
+    while (!queue.empty()) {
+      auto current = std::move(queue.front());
+      queue.pop();
+      for (auto g = 0UL; g < gates.size(); g++) {
+        auto next = current;
+        apply_local(gates[g], next);
+        auto rank = permutation_rank(next);
+        if (last_gate[rank] == NO_GATE && next != identity) {
+          last_gate[rank] = static_cast<uint8_t>(g);
+          queue.push(std::move(next));
+        }
+      }
+    }
+  }
+};
+
+auto table(uint64_t lines) -> const optimal_table & {
+  static const auto tables = []() {
+    auto result = std::vector<optimal_table>();
+    for (auto l = 1UL; l <= window_resynthesis::MAX_WINDOW_LINES; l++) {
+      result.emplace_back(l);
+    }
+    return result;
+  }();
+  return tables[lines - 1];
+}
+
+struct window {
+  uint64_t begin;
+  uint64_t end;
+  uint64_t lines;
+};
+
+auto split_windows(const std::deque<gate> &gates, uint64_t max_lines) -> std::vector<window> {
+  auto windows = std::vector<window>();
+  for (auto i = 0UL; i < gates.size(); i++) {
+    auto mask = gates[i].lines_mask();
+    if (!windows.empty() && windows.back().end == i &&
+        static_cast<uint64_t>(std::popcount(windows.back().lines | mask)) <= max_lines) {
+      windows.back().end++;
+      windows.back().lines |= mask;
+    }
+    else {
+      windows.push_back({i, i + 1, mask});
+    }
+  }
+  return windows;
+}
+
+auto resynthesise(const std::deque<gate> &gates, const window &w) -> std::vector<gate> {
+  auto original = std::vector<gate>(gates.begin() + static_cast<std::ptrdiff_t>(w.begin),
+                                    gates.begin() + static_cast<std::ptrdiff_t>(w.end));
+  if (original.size() < 2) {
+    return original;
+  }
+
+  auto bits_num = original.front().size();
+  auto global_lines = state(bits_num, w.lines).ones();
+  auto local_lines = global_lines.size();
+  auto to_global = [&](uint64_t local_row) {
+    auto row = 0UL;
+    for (auto l = 0UL; l < local_lines; l++) {
+      row |= ((local_row >> l) & 1UL) << global_lines[l];
+    }
+    return row;
+  };
+  auto to_local = [&](uint64_t row) {
+    auto local_row = 0UL;
+    for (auto l = 0UL; l < local_lines; l++) {
+      local_row |= ((row >> global_lines[l]) & 1UL) << l;
+    }
+    return local_row;
+  };
+
+  auto permutation = std::vector<uint64_t>(1UL << local_lines);
+  for (auto local_row = 0UL; local_row < permutation.size(); local_row++) {
+    auto row = to_global(local_row);
+    for (const auto &g : original) {
+      row = g.apply(row);
+    }
+    permutation[local_row] = to_local(row);
+  }
+
+  auto replacement = std::vector<gate>();
+  for (const auto &g : window_resynthesis::optimal_circuit(local_lines, permutation)) {
+    auto controls = std::vector<uint64_t>();
+    for (auto c : g.controls()) {
+      controls.push_back(global_lines[c]);
+    }
+    replacement.emplace_back(bits_num, controls, global_lines[g.target()]);
+  }
+  return gates_cost(replacement) < gates_cost(original) ? replacement : original;
+}
+
+} // namespace
+
+window_resynthesis::window_resynthesis(uint64_t max_lines, uint64_t threads_num)
+    : max_lines_(max_lines), threads_num_(threads_num) {
+  if (max_lines == 0 || max_lines > MAX_WINDOW_LINES) {
+    throw std::invalid_argument("Window has to span between 1 and MAX_WINDOW_LINES lines");
+  }
+}
+
+auto window_resynthesis::optimal_circuit(uint64_t lines, const std::vector<uint64_t> &permutation)
+    -> std::vector<gate> {
+  if (lines == 0 || lines > MAX_WINDOW_LINES || permutation.size() != 1UL << lines) {
+    throw std::invalid_argument("No optimal table for permutation of this size");
+  }
+  const auto &optimal = table(lines);
+  auto current = permutation;
+  auto reversed = std::vector<gate>();
+  for (auto g = optimal.last_gate[permutation_rank(current)]; g != NO_GATE;
+       g = optimal.last_gate[permutation_rank(current)]) {
+    reversed.push_back(optimal.gates[g]);
+    apply_local(optimal.gates[g], current);
+  }
+  return {reversed.rbegin(), reversed.rend()};
+}
+
+auto window_resynthesis::optimize(circuit &circ) const -> optimisation_report {
+  auto report = optimisation_report();
+  report.gates_before = circ.gates_num();
+  report.controls_before = circ.controls_num();
+  report.cost_before = circ.cost();
+
+  auto gates = circ.gates();
+  for (auto improved = true; improved; report.passes++) {
+    auto windows = split_windows(gates, max_lines_);
+    auto replacements = std::vector<std::vector<gate>>(windows.size());
+    parallel_for(0UL, windows.size(), threads_num_,
+                 [&](auto w) { replacements[w] = resynthesise(gates, windows[w]); });
+
+    auto next = std::deque<gate>();
+    for (const auto &replacement : replacements) {
+      next.insert(next.end(), replacement.begin(), replacement.end());
+    }
+    improved = next.size() < gates.size();
+    gates = std::move(next);
+  }
+
+  circ.replace_gates(std::move(gates));
+  report.gates_after = circ.gates_num();
+  report.controls_after = circ.controls_num();
+  report.cost_after = circ.cost();
+  return report;
+}
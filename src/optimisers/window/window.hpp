@@ -0,0 +1,23 @@
+#pragma once
+#include "optimisers/optimiser.hpp"
+#include <cstdint>
+
+// Resynthesis of windows: maximal runs of consecutive gates acting on at most max_lines lines
+// are replaced with a gate-count optimal circuit of the same local permutation. Optimal circuits
+// of up to MAX_WINDOW_LINES lines are found once by breadth-first search over all Toffoli gates
+// on those lines. Windows are independent and resynthesised in parallel.
+class window_resynthesis : public optimiser {
+  uint64_t max_lines_;
+  uint64_t threads_num_;
+
+public:
+  static const auto MAX_WINDOW_LINES = 3UL;
+
+  explicit window_resynthesis(uint64_t max_lines = MAX_WINDOW_LINES, uint64_t threads_num = 0);
+
+  // Optimal gate sequence of a permutation of 2^lines rows acting on lines 0..lines-1.
+  static auto optimal_circuit(uint64_t lines, const std::vector<uint64_t> &permutation)
+      -> std::vector<gate>;
+
+  auto optimize(circuit &circ) const -> optimisation_report;
+};
@@ -0,0 +1,82 @@
+#include "window.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <random>
+
+namespace window_ut {
+const auto EPOCHS = 1000;
+const auto max_bits = 10;
+std::mt19937_64 mrnd;
+
+auto recomputed_tt(const circuit &circ) -> truth_table {
+  auto tt = truth_table(circ.bits_num());
+  for (const auto &g : circ.gates()) {
+    g.apply_back(tt);
+  }
+  return tt;
+}
+} // namespace window_ut
+
+using namespace window_ut;
+
+TEST_CASE("optimal 3 bit circuits", "[window], [paper]") {
+  // Shende et al., optimal NCT circuits of all 3 bit reversible functions
+  auto expected_gc_histogram =
+      std::vector<uint64_t>{1, 12, 102, 625, 2780, 8921, 17049, 10253, 577};
+  auto gc_histogram = std::vector<uint64_t>(expected_gc_histogram.size(), 0);
+  auto target_tt = truth_table(3);
+  do {
+    auto gates = window_resynthesis::optimal_circuit(
+        3, std::vector<uint64_t>(target_tt.data().begin(), target_tt.data().end()));
+    REQUIRE(gates.size() < gc_histogram.size());
+    gc_histogram[gates.size()]++;
+
+    auto tt = truth_table(3);
+    for (const auto &g : gates) {
+      g.apply_back(tt);
+    }
+    REQUIRE(tt == target_tt);
+  } while (target_tt.next_permutation());
+  REQUIRE(gc_histogram == expected_gc_histogram);
+}
+
+TEST_CASE("window resynthesis keeps circuit function", "[window]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  const auto lines = static_cast<uint64_t>(GENERATE(1, 2, 3));
+
+  // random gates on few lines, so that windows are long
+  auto tested = circuit(bits);
+  auto used_lines = std::min(bits, lines + mrnd() % 2);
+  for (auto i = 0UL, gates_num = 1 + mrnd() % 64; i < gates_num; i++) {
+    auto g = gate(used_lines, mrnd);
+    tested.push_back(gate(bits, g.controls(), g.target()));
+  }
+  auto reference = tested;
+
+  auto report = window_resynthesis(lines, 1 + mrnd() % 4).optimize(tested);
+  REQUIRE(report.gates_removed() >= 0);
+  REQUIRE(report.gates_after == tested.gates_num());
+  REQUIRE(recomputed_tt(tested) == reference.output_tt());
+  if (used_lines <= lines) {
+    REQUIRE(tested.gates_num() <= 8);
+  }
+}
+
+TEST_CASE("window resynthesis of mmd03 circuits", "[window], [mmd03]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(100, random(2, 6))));
+
+  auto target_tt = truth_table(bits).shuffle(mrnd);
+  auto circ = mmd03().synthesize(target_tt);
+  auto report = window_resynthesis().optimize(circ);
+  REQUIRE(recomputed_tt(circ) == target_tt);
+  if (bits <= 3) {
+    REQUIRE(report.gates_after <= 8);
+  }
+}
+
+TEST_CASE("window resynthesis rejects large windows", "[window]") {
+  REQUIRE_THROWS_AS(window_resynthesis(window_resynthesis::MAX_WINDOW_LINES + 1),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(window_resynthesis(0), std::invalid_argument);
+}
@@ -0,0 +1,133 @@
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace {
+thread_local auto is_worker = false;
+} // namespace
+
+auto threads_num(uint64_t requested) -> uint64_t {
+  if (requested != 0) {
+    return requested;
+  }
+  return std::max(1UL, static_cast<uint64_t>(std::thread::hardware_concurrency()));
+}
+
+thread_pool::thread_pool(uint64_t workers_num) {
+  workers_.reserve(workers_num);
+  for (auto i = 0UL; i < workers_num; i++) {
+    workers_.emplace_back([this]() { work(); });
+  }
+}
+
+thread_pool::~thread_pool() {
+  {
+    auto lock = std::lock_guard(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &w : workers_) {
+    w.join();
+  }
+}
+
+auto thread_pool::work() -> void {
+  is_worker = true;
+  while (true) {
+    auto task = std::function<void()>();
+    {
+      auto lock = std::unique_lock(mutex_);
+      wake_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+auto thread_pool::workers_num() const noexcept -> uint64_t { return workers_.size(); }
+
+auto thread_pool::submit(std::function<void()> task) -> void {
+  {
+    auto lock = std::lock_guard(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  wake_.notify_one();
+}
+
+auto thread_pool::on_worker() noexcept -> bool { return is_worker; }
+
+auto default_pool() -> thread_pool & {
+  // Never destroyed: workers may still run thread_local destructors of other modules at exit.
+  static auto &instance = *new thread_pool(std::max(1UL, threads_num() - 1));
+  return instance;
+}
+
+auto parallel_for(uint64_t begin, uint64_t end, uint64_t threads,
+                  const std::function<void(uint64_t)> &body) -> void {
+  if (begin >= end) {
+    return;
+  }
+  auto helpers_num = 0UL;
+  if (!thread_pool::on_worker()) {
+    auto &pool = default_pool();
+    helpers_num = std::min(std::min(threads_num(threads), end - begin) - 1, pool.workers_num());
+  }
+  if (helpers_num == 0) {
+    for (auto i = begin; i < end; i++) {
+      body(i);
+    }
+    return;
+  }
+
+  auto next = std::atomic<uint64_t>(begin);
+  auto error = std::exception_ptr();
+  auto mutex = std::mutex();
+  auto finished = std::condition_variable();
+  auto running = helpers_num;
+  auto worker = [&]() {
+    for (auto i = next++; i < end; i = next++) {
+      try {
+        body(i);
+      }
+      catch (...) {
+        auto lock = std::lock_guard(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+  };
+
+  for (auto i = 0UL; i < helpers_num; i++) {
+    default_pool().submit([&]() {
+      worker();
+      auto lock = std::lock_guard(mutex);
+      running--;
+      finished.notify_one();
+    });
+  }
+  worker();
+  {
+    auto lock = std::unique_lock(mutex);
+    finished.wait(lock, [&running]() { return running == 0; });
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+auto parallel_for_chunks(uint64_t begin, uint64_t end, uint64_t chunk, uint64_t threads,
+                         const std::function<void(uint64_t, uint64_t)> &body) -> void {
+  if (begin >= end) {
+    return;
+  }
+  parallel_for(0, (end - begin + chunk - 1) / chunk, threads, [&](uint64_t i) {
+    auto chunk_begin = begin + i * chunk;
+    body(chunk_begin, std::min(chunk_begin + chunk, end));
+  });
+}
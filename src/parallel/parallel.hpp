@@ -0,0 +1,45 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+auto threads_num(uint64_t requested = 0) -> uint64_t;
+
+// Fixed set of worker threads running submitted tasks in FIFO order.
+class thread_pool {
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+
+  auto work() -> void;
+
+public:
+  explicit thread_pool(uint64_t workers_num);
+  thread_pool(const thread_pool &) = delete;
+  auto operator=(const thread_pool &) -> thread_pool & = delete;
+  ~thread_pool();
+
+  [[nodiscard]] auto workers_num() const noexcept -> uint64_t;
+  auto submit(std::function<void()> task) -> void;
+  // Whether the calling thread is a worker of any pool.
+  [[nodiscard]] static auto on_worker() noexcept -> bool;
+};
+
+// Pool shared by parallel_for, with threads_num() - 1 workers as the caller takes part too.
+auto default_pool() -> thread_pool &;
+
+// Runs body over [begin, end) on the calling thread and up to threads - 1 workers of the default
+// pool, and rethrows the first exception thrown by body. Calls made from a pool worker run on
+// that worker alone, so nested loops cannot wait on tasks queued behind them.
+auto parallel_for(uint64_t begin, uint64_t end, uint64_t threads,
+                  const std::function<void(uint64_t)> &body) -> void;
+
+// parallel_for over consecutive ranges of at most chunk indices, body(chunk_begin, chunk_end).
+auto parallel_for_chunks(uint64_t begin, uint64_t end, uint64_t chunk, uint64_t threads,
+                         const std::function<void(uint64_t, uint64_t)> &body) -> void;
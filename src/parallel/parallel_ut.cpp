@@ -0,0 +1,83 @@
+#include "parallel.hpp"
+#include <atomic>
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace parallel_ut {
+const auto EPOCHS = 100;
+const auto max_threads = 8;
+} // namespace parallel_ut
+
+using namespace parallel_ut;
+
+TEST_CASE("parallel_for visits every index once", "[parallel]") {
+  const auto threads = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_threads))));
+  const auto length = 1000UL;
+
+  auto visits = std::vector<std::atomic<uint64_t>>(length);
+  parallel_for(0UL, length, threads, [&](auto i) { visits[i]++; });
+  for (auto &v : visits) {
+    REQUIRE(v == 1UL);
+  }
+}
+
+TEST_CASE("parallel_for rethrows worker exceptions", "[parallel]") {
+  auto body = [](auto i) {
+    if (i == 7UL) {
+      throw std::invalid_argument("failed");
+    }
+  };
+  REQUIRE_THROWS_AS(parallel_for(0UL, 16UL, 4UL, body), std::invalid_argument);
+}
+
+TEST_CASE("parallel_for nested in pool workers", "[parallel]") {
+  const auto length = 64UL;
+  auto visits = std::vector<std::atomic<uint64_t>>(length * length);
+  parallel_for(0UL, length, 0, [&](auto i) {
+    parallel_for(0UL, length, 0, [&](auto j) { visits[i * length + j]++; });
+  });
+  for (auto &v : visits) {
+    REQUIRE(v == 1UL);
+  }
+}
+
+TEST_CASE("parallel_for_chunks covers the range", "[parallel]") {
+  const auto threads = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_threads))));
+  const auto begin = 5UL;
+  const auto end = 1000UL;
+  const auto chunk = static_cast<uint64_t>(GENERATE(take(1, random(1, 300))));
+
+  auto visits = std::vector<std::atomic<uint64_t>>(end);
+  auto oversized = std::atomic<uint64_t>(0);
+  parallel_for_chunks(begin, end, chunk, threads, [&](auto chunk_begin, auto chunk_end) {
+    if (chunk_end - chunk_begin > chunk) {
+      oversized++;
+    }
+    for (auto i = chunk_begin; i < chunk_end; i++) {
+      visits[i]++;
+    }
+  });
+  REQUIRE(oversized == 0);
+  for (auto i = 0UL; i < end; i++) {
+    REQUIRE(visits[i] == (i < begin ? 0UL : 1UL));
+  }
+}
+
+TEST_CASE("thread pool runs submitted tasks", "[parallel]") {
+  auto done = std::atomic<uint64_t>(0);
+  {
+    auto pool = thread_pool(3);
+    REQUIRE(pool.workers_num() == 3);
+    REQUIRE_FALSE(thread_pool::on_worker());
+    for (auto i = 0; i < 100; i++) {
+      pool.submit([&done]() {
+        if (thread_pool::on_worker()) {
+          done++;
+        }
+      });
+    }
+  }
+  REQUIRE(done == 100);
+}
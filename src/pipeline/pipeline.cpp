@@ -0,0 +1,108 @@
+#include "pipeline.hpp"
+#include "parallel/parallel.hpp"
+#include <exception>
+#include <thread>
+#include <vector>
+
+auto run_batch(const std::function<std::optional<batch_item>()> &source, const synthesiser &synth,
+               const std::function<void(const batch_result &)> &sink, batch_options opts)
+    -> batch_stats {
+  using clock = std::chrono::steady_clock;
+  auto workers_num = threads_num(opts.threads_num);
+  auto queue_size = opts.queue_size == 0 ? 2 * workers_num : opts.queue_size;
+  auto items = bounded_queue<batch_item>(queue_size);
+  auto results = bounded_queue<batch_result>(queue_size);
+  auto start = clock::now();
+
+  auto error = std::exception_ptr();
+  auto error_mutex = std::mutex();
+  auto fail = [&]() {
+    {
+      auto lock = std::lock_guard(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+    items.close();
+    results.close();
+  };
+
+  auto reader = std::thread([&]() {
+    try {
+      while (auto item = source()) {
+        if (!items.push(std::move(*item))) {
+          break;
+        }
+      }
+    }
+    catch (...) {
+      fail();
+    }
+    items.close();
+  });
+
+  auto workers_left = workers_num;
+  auto workers_mutex = std::mutex();
+  auto workers = std::vector<std::thread>();
+  workers.reserve(workers_num);
+  for (auto i = 0UL; i < workers_num; i++) {
+    workers.emplace_back([&]() {
+      while (auto item = items.pop()) {
+        auto result = batch_result{item->index, std::move(item->name), item->target.size(),
+                                   std::nullopt, std::move(item->error), {}};
+        if (!result.error.empty()) {
+          result.bits_num = 0;
+          if (!results.push(std::move(result))) {
+            break;
+          }
+          continue;
+        }
+        auto item_start = clock::now();
+        try {
+          auto ctx = synth_context();
+          if (opts.item_timeout != std::chrono::milliseconds::max()) {
+            ctx.deadline = item_start + opts.item_timeout;
+          }
+          result.circ = synth.synthesize(std::move(item->target), ctx);
+        }
+        catch (const std::exception &e) {
+          result.error = e.what();
+        }
+        catch (...) {
+          result.error = "Unknown error";
+        }
+        result.time = clock::now() - item_start;
+        if (!results.push(std::move(result))) {
+          break;
+        }
+      }
+      auto lock = std::lock_guard(workers_mutex);
+      if (--workers_left == 0) {
+        results.close();
+      }
+    });
+  }
+
+  auto stats = batch_stats();
+  try {
+    while (auto result = results.pop()) {
+      stats.items++;
+      stats.failed += result->circ ? 0 : 1;
+      stats.synthesis_time += result->time;
+      sink(*result);
+    }
+  }
+  catch (...) {
+    fail();
+  }
+
+  reader.join();
+  for (auto &w : workers) {
+    w.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  stats.wall_time = clock::now() - start;
+  return stats;
+}
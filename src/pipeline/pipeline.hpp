@@ -0,0 +1,113 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "synthesisers/synthesiser.hpp"
+#include "truth_table/truth_table.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Fixed capacity queue between pipeline stages. push blocks while the queue is full and pop while
+// it is empty. After close, push refuses new items and pop drains what is left, then returns
+// nullopt.
+template <typename T> class bounded_queue {
+  uint64_t capacity_;
+  std::deque<T> items_;
+  bool closed_ = false;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+
+public:
+  explicit bounded_queue(uint64_t capacity) : capacity_(capacity == 0 ? 1 : capacity) {}
+
+  auto push(T item) -> bool {
+    auto lock = std::unique_lock(mutex_);
+    not_full_.wait(lock, [this]() { return closed_ || items_.size() < capacity_; });
+    if (closed_) {
+      return false;
+    }
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  auto pop() -> std::optional<T> {
+    auto lock = std::unique_lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+    if (items_.empty()) {
+      return std::nullopt;
+    }
+    auto item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return item;
+  }
+
+  // Waits like pop, then takes up to max_items, and no more than a fair share of the queued items
+  // among consumers, so that one consumer does not take work the others sit idle for. Empty once
+  // closed and drained.
+  auto pop_batch(uint64_t max_items, uint64_t consumers = 1) -> std::vector<T> {
+    auto lock = std::unique_lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+    consumers = std::max(consumers, uint64_t(1));
+    auto share = (items_.size() + consumers - 1) / consumers;
+    auto batch = std::vector<T>();
+    while (!items_.empty() && batch.size() < std::min(max_items, share)) {
+      batch.push_back(std::move(items_.front()));
+      items_.pop_front();
+    }
+    not_full_.notify_all();
+    return batch;
+  }
+
+  auto close() -> void {
+    auto lock = std::lock_guard(mutex_);
+    closed_ = true;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+};
+
+struct batch_item {
+  uint64_t index;
+  std::string name;
+  truth_table target;
+  std::string error; // the target could not be read, the item fails without synthesis
+};
+
+struct batch_result {
+  uint64_t index;
+  std::string name;
+  uint64_t bits_num;
+  std::optional<circuit> circ; // empty when synthesis failed
+  std::string error;
+  std::chrono::nanoseconds time;
+};
+
+struct batch_options {
+  uint64_t threads_num = 0; // synthesis workers, 0 - use all hardware threads
+  uint64_t queue_size = 0;  // capacity of both queues, 0 - twice the workers
+  std::chrono::milliseconds item_timeout = std::chrono::milliseconds::max();
+};
+
+struct batch_stats {
+  uint64_t items = 0;
+  uint64_t failed = 0;
+  std::chrono::nanoseconds synthesis_time{0};
+  std::chrono::nanoseconds wall_time{0};
+};
+
+// Reads items from source on a reader thread until it returns nullopt, synthesises them on
+// threads_num workers and hands the results to sink on the calling thread in completion order.
+// Synthesis errors and items carrying an error are reported per item; an exception from source or
+// sink stops the pipeline and is rethrown once every thread has finished.
+auto run_batch(const std::function<std::optional<batch_item>()> &source, const synthesiser &synth,
+               const std::function<void(const batch_result &)> &sink, batch_options opts = {})
+    -> batch_stats;
@@ -0,0 +1,173 @@
+#include "pipeline.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace pipeline_ut {
+const auto EPOCHS = 20;
+const auto max_bits = 8;
+const auto max_threads = 8;
+std::mt19937_64 mrnd;
+
+// Fails every target on the given number of lines.
+class failing_synthesiser : public synthesiser {
+  uint64_t failing_bits_;
+  bool unknown_error_;
+
+public:
+  explicit failing_synthesiser(uint64_t failing_bits, bool unknown_error = false)
+      : failing_bits_(failing_bits), unknown_error_(unknown_error) {}
+  [[nodiscard]] auto name() const -> std::string { return "failing"; }
+  using synthesiser::synthesize;
+  auto synthesize(truth_table target_tt) const -> circuit {
+    if (target_tt.size() == failing_bits_) {
+      if (unknown_error_) {
+        throw failing_bits_; // not a std::exception
+      }
+      throw std::invalid_argument("failed");
+    }
+    return mmd03().synthesize(std::move(target_tt));
+  }
+};
+} // namespace pipeline_ut
+
+using namespace pipeline_ut;
+
+TEST_CASE("bounded queue", "[pipeline]") {
+  auto queue = bounded_queue<uint64_t>(4);
+  const auto items = 1000UL;
+  auto producer = std::thread([&]() {
+    for (auto i = 0UL; i < items; i++) {
+      queue.push(i);
+    }
+    queue.close();
+  });
+  for (auto i = 0UL; i < items; i++) {
+    REQUIRE(queue.pop() == i);
+  }
+  REQUIRE_FALSE(queue.pop().has_value());
+  producer.join();
+  REQUIRE_FALSE(queue.push(0));
+}
+
+TEST_CASE("bounded queue batches", "[pipeline]") {
+  auto queue = bounded_queue<uint64_t>(8);
+  for (auto i = 0UL; i < 5; i++) {
+    queue.push(i);
+  }
+  REQUIRE(queue.pop_batch(3) == std::vector<uint64_t>{0, 1, 2});
+  REQUIRE(queue.pop_batch(3) == std::vector<uint64_t>{3, 4});
+  for (auto i = 0UL; i < 7; i++) {
+    queue.push(i);
+  }
+  // a fair share among 3 consumers
+  REQUIRE(queue.pop_batch(8, 3) == std::vector<uint64_t>{0, 1, 2});
+  REQUIRE(queue.pop_batch(8, 3) == std::vector<uint64_t>{3, 4});
+  REQUIRE(queue.pop_batch(8, 3) == std::vector<uint64_t>{5});
+  REQUIRE(queue.pop_batch(8, 3) == std::vector<uint64_t>{6});
+  queue.close();
+  REQUIRE(queue.pop_batch(3).empty());
+}
+
+TEST_CASE("batch synthesis", "[pipeline], [mmd03]") {
+  const auto threads = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_threads))));
+  const auto items = 1 + mrnd() % 40;
+
+  auto targets = std::vector<truth_table>();
+  for (auto i = 0UL; i < items; i++) {
+    targets.push_back(truth_table(1 + mrnd() % max_bits).shuffle(mrnd));
+  }
+  auto next = 0UL;
+  auto source = [&]() -> std::optional<batch_item> {
+    if (next == targets.size()) {
+      return std::nullopt;
+    }
+    auto index = next++;
+    return batch_item{index, std::string("t").append(std::to_string(index)), targets[index], {}};
+  };
+  auto seen = std::set<uint64_t>();
+  auto sink = [&](const batch_result &r) {
+    REQUIRE(r.circ.has_value());
+    REQUIRE(r.name == std::string("t").append(std::to_string(r.index)));
+    REQUIRE(r.bits_num == targets[r.index].size());
+    REQUIRE(r.circ->output_tt() == targets[r.index]);
+    seen.insert(r.index);
+  };
+
+  auto stats = run_batch(source, mmd03(), sink, {threads, 1 + mrnd() % 4});
+  REQUIRE(stats.items == items);
+  REQUIRE(stats.failed == 0);
+  REQUIRE(seen.size() == items);
+}
+
+TEST_CASE("batch synthesis errors", "[pipeline]") {
+  auto next = 0UL;
+  auto source = [&]() -> std::optional<batch_item> {
+    if (next == 10) {
+      return std::nullopt;
+    }
+    auto bits = 2 + next % 2;
+    return batch_item{next++, "t", truth_table(bits).shuffle(mrnd), {}};
+  };
+  auto failed = 0UL;
+  auto stats = run_batch(
+      source, failing_synthesiser(3),
+      [&](const batch_result &r) {
+        if (!r.circ) {
+          REQUIRE(r.error == "failed");
+          failed++;
+        }
+      },
+      {4, 2});
+  REQUIRE(stats.items == 10);
+  REQUIRE(stats.failed == 5);
+  REQUIRE(failed == 5);
+
+  next = 0;
+  stats = run_batch(
+      source, failing_synthesiser(3, true),
+      [&](const batch_result &r) { REQUIRE((r.circ || r.error == "Unknown error")); }, {4, 2});
+  REQUIRE(stats.failed == 5);
+
+  // items that could not be read fail on their own
+  next = 0;
+  auto unreadable = [&]() -> std::optional<batch_item> {
+    if (next == 10) {
+      return std::nullopt;
+    }
+    auto index = next++;
+    return index % 2 == 0 ? batch_item{index, "t", truth_table(3), "not a permutation"}
+                          : batch_item{index, "t", truth_table(3).shuffle(mrnd), {}};
+  };
+  failed = 0;
+  stats = run_batch(
+      unreadable, mmd03(),
+      [&](const batch_result &r) {
+        REQUIRE(r.circ.has_value() == (r.index % 2 == 1));
+        if (!r.circ) {
+          REQUIRE(r.error == "not a permutation");
+          REQUIRE(r.bits_num == 0);
+          failed++;
+        }
+      },
+      {4, 2});
+  REQUIRE(stats.failed == 5);
+  REQUIRE(failed == 5);
+
+  // errors of the reading and writing stages stop the whole batch
+  auto endless = [&]() -> std::optional<batch_item> {
+    return batch_item{0, "t", truth_table(3), {}};
+  };
+  auto throwing_sink = [](const batch_result &) { throw std::runtime_error("disk full"); };
+  REQUIRE_THROWS_AS(run_batch(endless, mmd03(), throwing_sink, {4, 2}), std::runtime_error);
+  auto throwing_source = []() -> std::optional<batch_item> {
+    throw std::runtime_error("bad file");
+  };
+  REQUIRE_THROWS_AS(run_batch(throwing_source, mmd03(), [](const batch_result &) {}),
+                    std::runtime_error);
+}
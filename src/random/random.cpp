@@ -0,0 +1,124 @@
+#include "random.hpp"
+#include "parallel/parallel.hpp"
+#include <memory>
+
+namespace {
+
+const auto JUMP = std::array<uint64_t, 4>{0x180ec6d33cfd0abaUL, 0xd5a61266f0c9392cUL,
+                                          0xa9582618e03fc9aaUL, 0x39abdc4529b1661cUL};
+const auto LONG_JUMP = std::array<uint64_t, 4>{0x76e15d3efefdcbbfUL, 0xc5004e441c522fb3UL,
+                                               0x77710069854ee241UL, 0x39109bb02acbe635UL};
+
+// Bucket of a value from the top byte of its draw.
+const auto BUCKET_SHIFT = 56;
+
+} // namespace
+
+auto splitmix64(uint64_t &state) noexcept -> uint64_t {
+  auto z = (state += 0x9e3779b97f4a7c15UL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+  return z ^ (z >> 31);
+}
+
+xoshiro256ss::xoshiro256ss(uint64_t seed) noexcept {
+  for (auto &word : s_) {
+    word = splitmix64(seed);
+  }
+}
+
+xoshiro256ss::xoshiro256ss(uint64_t seed, uint64_t index) noexcept {
+  // seeds of different streams are decorrelated by a round of splitmix64 over the index
+  auto mixer = seed;
+  auto stream_seed = splitmix64(mixer) ^ index;
+  for (auto &word : s_) {
+    word = splitmix64(stream_seed);
+  }
+}
+
+xoshiro256ss::xoshiro256ss(const std::array<uint64_t, 4> &state) : s_(state) {
+  if (state == std::array<uint64_t, 4>{}) {
+    throw std::invalid_argument("xoshiro256ss state cannot be all zeroes");
+  }
+}
+
+auto xoshiro256ss::jump_by(const std::array<uint64_t, 4> &polynomial) noexcept -> void {
+  auto jumped = std::array<uint64_t, 4>{};
+  for (auto word : polynomial) {
+    for (auto bit = 0; bit < 64; bit++) {
+      if ((word >> bit & 1UL) != 0) {
+        for (auto i = 0UL; i < jumped.size(); i++) {
+          jumped[i] ^= s_[i];
+        }
+      }
+      (*this)();
+    }
+  }
+  s_ = jumped;
+}
+
+auto xoshiro256ss::jump() noexcept -> void { jump_by(JUMP); }
+
+auto xoshiro256ss::long_jump() noexcept -> void { jump_by(LONG_JUMP); }
+
+auto xoshiro256ss::split() noexcept -> xoshiro256ss {
+  auto child = *this;
+  jump();
+  return child;
+}
+
+auto parallel_shuffle(std::span<uint64_t> values, xoshiro256ss &rng, uint64_t threads) -> void {
+  const auto length = values.size();
+  if (length < PARALLEL_SHUFFLE_ROWS) {
+    fisher_yates(values, rng);
+    return;
+  }
+  const auto scatter_seed = rng();
+  const auto bucket_seed = rng();
+  const auto chunks_num = (length + SHUFFLE_CHUNK_ROWS - 1) / SHUFFLE_CHUNK_ROWS;
+
+  // tag every value with its bucket and count the bucket sizes per chunk
+  auto tags = std::make_unique_for_overwrite<uint8_t[]>(length);
+  auto offsets = std::vector<uint64_t>(chunks_num * SHUFFLE_BUCKETS);
+  parallel_for(0, chunks_num, threads, [&](uint64_t chunk) {
+    auto stream = xoshiro256ss(scatter_seed, chunk);
+    auto *counts = offsets.data() + chunk * SHUFFLE_BUCKETS;
+    const auto end = std::min(length, (chunk + 1) * SHUFFLE_CHUNK_ROWS);
+    for (auto i = chunk * SHUFFLE_CHUNK_ROWS; i < end; i++) {
+      tags[i] = static_cast<uint8_t>(stream() >> BUCKET_SHIFT);
+      counts[tags[i]]++;
+    }
+  });
+
+  // bucket major, chunk minor offsets: a chunk writes its part of every bucket in place
+  auto bucket_begins = std::vector<uint64_t>(SHUFFLE_BUCKETS + 1);
+  auto position = 0UL;
+  for (auto bucket = 0UL; bucket < SHUFFLE_BUCKETS; bucket++) {
+    bucket_begins[bucket] = position;
+    for (auto chunk = 0UL; chunk < chunks_num; chunk++) {
+      auto &slot = offsets[chunk * SHUFFLE_BUCKETS + bucket];
+      auto count = slot;
+      slot = position;
+      position += count;
+    }
+  }
+  bucket_begins[SHUFFLE_BUCKETS] = position;
+
+  auto scattered = std::make_unique_for_overwrite<uint64_t[]>(length);
+  parallel_for(0, chunks_num, threads, [&](uint64_t chunk) {
+    auto *next = offsets.data() + chunk * SHUFFLE_BUCKETS;
+    const auto end = std::min(length, (chunk + 1) * SHUFFLE_CHUNK_ROWS);
+    for (auto i = chunk * SHUFFLE_CHUNK_ROWS; i < end; i++) {
+      scattered[next[tags[i]]++] = values[i];
+    }
+  });
+
+  parallel_for(0, SHUFFLE_BUCKETS, threads, [&](uint64_t bucket) {
+    auto stream = xoshiro256ss(bucket_seed, bucket);
+    auto begin = bucket_begins[bucket];
+    auto end = bucket_begins[bucket + 1];
+    auto bucket_values = std::span(scattered.get() + begin, end - begin);
+    fisher_yates(bucket_values, stream);
+    std::copy(bucket_values.begin(), bucket_values.end(), values.subspan(begin).begin());
+  });
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+// xoshiro256** by Blackman and Vigna: 32 bytes of state, a few cycles per value and a period of
+// 2^256 - 1. Pass it by reference; copies repeat the same values.
+class xoshiro256ss {
+  std::array<uint64_t, 4> s_;
+
+  auto jump_by(const std::array<uint64_t, 4> &polynomial) noexcept -> void;
+
+public:
+  using result_type = uint64_t;
+
+  // The state is expanded from seed with splitmix64.
+  explicit xoshiro256ss(uint64_t seed = 0) noexcept;
+  // Independent stream number index of seed, e.g. one per chunk of work, so results do not depend
+  // on which thread draws from which stream.
+  xoshiro256ss(uint64_t seed, uint64_t index) noexcept;
+  // Raw state, which must not be all zeroes.
+  explicit xoshiro256ss(const std::array<uint64_t, 4> &state);
+
+  static constexpr auto min() noexcept -> result_type { return 0; }
+  static constexpr auto max() noexcept -> result_type {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  auto operator()() noexcept -> result_type {
+    const auto result = rotl(s_[1] * 5, 7) * 9;
+    const auto t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = rotl(s_[3], 45);
+    return result;
+  }
+
+  // Advance by 2^128 and 2^192 values: up to 2^128 non-overlapping sequences of 2^128 values.
+  auto jump() noexcept -> void;
+  auto long_jump() noexcept -> void;
+  // Returns a generator continuing from the current state and jumps this one past it.
+  auto split() noexcept -> xoshiro256ss;
+
+  auto operator==(const xoshiro256ss &) const -> bool = default;
+
+  static constexpr auto rotl(uint64_t x, int k) noexcept -> uint64_t {
+    return (x << k) | (x >> (64 - k));
+  }
+};
+
+auto splitmix64(uint64_t &state) noexcept -> uint64_t;
+
+// Uniform value in [0, bound) for bound > 0 without division in the common case (Lemire).
+template <typename Rng> auto uniform_below(Rng &rng, uint64_t bound) -> uint64_t {
+  static_assert(Rng::min() == 0 && Rng::max() == std::numeric_limits<uint64_t>::max());
+  __extension__ using uint128 = unsigned __int128;
+  auto product = static_cast<uint128>(rng()) * bound;
+  auto low = static_cast<uint64_t>(product);
+  if (low < bound) {
+    const auto threshold = (0 - bound) % bound;
+    while (low < threshold) {
+      product = static_cast<uint128>(rng()) * bound;
+      low = static_cast<uint64_t>(product);
+    }
+  }
+  return static_cast<uint64_t>(product >> 64);
+}
+
+template <typename Rng, typename T> auto fisher_yates(std::span<T> values, Rng &rng) -> void {
+  for (auto i = values.size(); i > 1; i--) {
+    std::swap(values[i - 1], values[uniform_below(rng, i)]);
+  }
+}
+
+// Samples of up to SAMPLE_SCAN_MAX values from a range wider than 64 are checked for repeats by a
+// linear scan instead of a hash set.
+const auto SAMPLE_SCAN_MAX = 64UL;
+
+// k distinct values of [0, range) in uniformly random order, in O(k) time and memory (Floyd's
+// sampling followed by a shuffle of the sample).
+template <typename Rng>
+auto sample_unique(uint64_t k, uint64_t range, Rng &rng) -> std::vector<uint64_t> {
+  if (k > range) {
+    throw std::invalid_argument("Cannot sample more values than the range holds");
+  }
+  auto result = std::vector<uint64_t>();
+  result.reserve(k);
+  if (range <= 64) {
+    auto taken = 0UL;
+    for (auto j = range - k; j < range; j++) {
+      auto value = uniform_below(rng, j + 1);
+      value = (taken >> value & 1UL) != 0 ? j : value;
+      taken |= 1UL << value;
+      result.push_back(value);
+    }
+  }
+  else if (k <= SAMPLE_SCAN_MAX) {
+    for (auto j = range - k; j < range; j++) {
+      auto value = uniform_below(rng, j + 1);
+      value = std::find(result.begin(), result.end(), value) != result.end() ? j : value;
+      result.push_back(value);
+    }
+  }
+  else {
+    auto taken = std::unordered_set<uint64_t>(k);
+    for (auto j = range - k; j < range; j++) {
+      auto value = uniform_below(rng, j + 1);
+      if (!taken.insert(value).second) {
+        value = j;
+        taken.insert(j);
+      }
+      result.push_back(value);
+    }
+  }
+  fisher_yates(std::span(result), rng);
+  return result;
+}
+
+// Tables of at least PARALLEL_SHUFFLE_ROWS values are shuffled by parallel_shuffle in chunks of
+// SHUFFLE_CHUNK_ROWS values scattered over SHUFFLE_BUCKETS buckets.
+const auto PARALLEL_SHUFFLE_ROWS = 1UL << 20;
+const auto SHUFFLE_CHUNK_ROWS = 1UL << 16;
+const auto SHUFFLE_BUCKETS = 256UL;
+
+// Uniform random permutation of values. Large inputs are scattered into random buckets which are
+// then shuffled one per task, every chunk and bucket drawing from its own stream of a seed taken
+// from rng: the result depends on rng only, never on threads (0 - hardware default).
+auto parallel_shuffle(std::span<uint64_t> values, xoshiro256ss &rng, uint64_t threads = 0)
+    -> void;
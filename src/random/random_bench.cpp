@@ -0,0 +1,41 @@
+#include "bench/bench.hpp"
+#include "random.hpp"
+#include "truth_table/truth_table.hpp"
+#include "utils/utils.hpp"
+#include <random>
+
+namespace random_bench {
+std::mt19937_64 mrnd;
+xoshiro256ss rng;
+} // namespace random_bench
+
+using namespace random_bench;
+
+REVSYNTH_BENCH("random/mt19937_64", 10, 10) {
+  state.run(1, [&]() { do_not_optimize(mrnd()); });
+}
+
+REVSYNTH_BENCH("random/xoshiro256ss", 10, 10) {
+  state.run(1, [&]() { do_not_optimize(rng()); });
+}
+
+REVSYNTH_BENCH("random/sample_unique", 3, 24) {
+  auto range = 1UL << state.bits_num();
+  state.run(8, [&]() { do_not_optimize(sample_unique(8, range, rng)); });
+}
+
+REVSYNTH_BENCH("random/shuffle/mt19937_64", 3, 24) {
+  auto tt = truth_table(state.bits_num());
+  state.run(tt.length(), [&]() {
+    tt.shuffle(mrnd);
+    do_not_optimize(tt);
+  });
+}
+
+REVSYNTH_BENCH("random/shuffle/xoshiro256ss", 3, 24) {
+  auto tt = truth_table(state.bits_num());
+  state.run(tt.length(), [&]() {
+    tt.shuffle(rng);
+    do_not_optimize(tt);
+  });
+}
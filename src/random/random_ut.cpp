@@ -0,0 +1,138 @@
+#include "random.hpp"
+#include "circuit/circuit.hpp"
+#include "functions/functions.hpp"
+#include "truth_table/truth_table.hpp"
+#include "utils/utils.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <numeric>
+#include <set>
+
+namespace random_ut {
+const auto EPOCHS = 1000;
+xoshiro256ss rng(2024);
+} // namespace random_ut
+
+using namespace random_ut;
+
+TEST_CASE("xoshiro256ss reference values", "[random]") {
+  auto seeded = xoshiro256ss(0);
+  auto copy = seeded;
+  REQUIRE(seeded() == copy());
+  REQUIRE(seeded == copy);
+
+  // first outputs of the reference implementation for the state {1, 2, 3, 4}
+  auto reference = xoshiro256ss(std::array<uint64_t, 4>{1, 2, 3, 4});
+  REQUIRE(reference() == 11520UL);
+  REQUIRE(reference() == 0UL);
+  REQUIRE(reference() == 1509978240UL);
+  REQUIRE_THROWS_AS(xoshiro256ss(std::array<uint64_t, 4>{}), std::invalid_argument);
+}
+
+TEST_CASE("xoshiro256ss streams and jumps", "[random]") {
+  auto a = xoshiro256ss(7, 0);
+  auto b = xoshiro256ss(7, 1);
+  REQUIRE(a != b);
+  REQUIRE(xoshiro256ss(7, 1) == b);
+
+  auto parent = xoshiro256ss(7);
+  auto child = parent.split();
+  REQUIRE(child == xoshiro256ss(7));
+  auto jumped = xoshiro256ss(7);
+  jumped.jump();
+  REQUIRE(parent == jumped);
+  auto long_jumped = xoshiro256ss(7);
+  long_jumped.long_jump();
+  REQUIRE(long_jumped != jumped);
+
+  auto draws = std::set<uint64_t>();
+  for (auto i = 0UL; i < 1000; i++) {
+    draws.insert(parent());
+    draws.insert(child());
+  }
+  REQUIRE(draws.size() == 2000);
+}
+
+TEST_CASE("uniform_below stays below its bound", "[random]") {
+  const auto bound = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, 100))));
+  auto hits = std::vector<uint64_t>(bound);
+  for (auto i = 0UL; i < 20 * bound; i++) {
+    auto value = uniform_below(rng, bound);
+    REQUIRE(value < bound);
+    hits[value]++;
+  }
+  REQUIRE(uniform_below(rng, 1) == 0);
+  if (bound <= 4) {
+    REQUIRE(std::find(hits.begin(), hits.end(), 0UL) == hits.end());
+  }
+}
+
+TEST_CASE("sample_unique draws distinct values", "[random]") {
+  const auto range = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, 200))));
+  const auto k = uniform_below(rng, range + 1);
+
+  auto sample = sample_unique(k, range, rng);
+  REQUIRE(sample.size() == k);
+  auto distinct = std::set<uint64_t>(sample.begin(), sample.end());
+  REQUIRE(distinct.size() == k);
+  if (k > 0) {
+    REQUIRE(*distinct.rbegin() < range);
+  }
+  REQUIRE_THROWS_AS(sample_unique(range + 1, range, rng), std::invalid_argument);
+}
+
+TEST_CASE("sample_unique order is uniform", "[random]") {
+  // every value of a full sample of 3 should come last about a third of the time
+  auto last = std::array<uint64_t, 3>{};
+  for (auto i = 0; i < 30000; i++) {
+    last[random_unique_vector(3, 3, rng).back()]++;
+  }
+  for (auto count : last) {
+    REQUIRE(count > 9000);
+    REQUIRE(count < 11000);
+  }
+}
+
+TEST_CASE("random gates taken by reference differ", "[random], [gate]") {
+  auto mrnd = std::mt19937_64(3);
+  auto circ = circuit(8, 64, mrnd);
+  auto xcirc = circuit(8, 64, rng);
+  auto distinct = std::set<std::pair<uint64_t, uint64_t>>();
+  auto xdistinct = std::set<std::pair<uint64_t, uint64_t>>();
+  for (auto i = 0UL; i < 64; i++) {
+    distinct.emplace(circ.gates()[i].control_mask(), circ.gates()[i].target());
+    xdistinct.emplace(xcirc.gates()[i].control_mask(), xcirc.gates()[i].target());
+  }
+  REQUIRE(distinct.size() > 1);
+  REQUIRE(xdistinct.size() > 1);
+}
+
+TEST_CASE("parallel shuffle is a reproducible permutation", "[random], [truth_table]") {
+  const auto bits = GENERATE(10UL, 21UL);
+
+  auto results = std::vector<truth_table>();
+  for (auto threads : {1UL, 3UL, 8UL}) {
+    auto seeded = xoshiro256ss(99);
+    results.push_back(truth_table(bits).shuffle(seeded, threads));
+    REQUIRE(seeded() != xoshiro256ss(99)());
+  }
+  REQUIRE(results[0] == results[1]);
+  REQUIRE(results[0] == results[2]);
+  REQUIRE(results[0] != truth_table(bits));
+
+  auto sorted = results[0];
+  std::sort(sorted.begin(), sorted.end());
+  REQUIRE(sorted == truth_table(bits));
+}
+
+TEST_CASE("random function batches do not depend on threads", "[random], [functions]") {
+  auto serial = random_functions(6, 20, 5, 1);
+  auto parallel = random_functions(6, 20, 5, 4);
+  REQUIRE(serial.size() == 20);
+  REQUIRE(serial[3].name == "rand6_3");
+  for (auto i = 0UL; i < serial.size(); i++) {
+    REQUIRE(serial[i].tt == parallel[i].tt);
+  }
+  REQUIRE(serial[0].tt != serial[1].tt);
+}
@@ -0,0 +1,469 @@
+#include "server.hpp"
+#include "parallel/parallel.hpp"
+#include "utils/utils.hpp"
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const auto FRAME_HEADER_SIZE = sizeof(uint32_t);
+const auto MAX_VARINT_SIZE = 10UL; // 64 bits in 7 bit groups
+const auto STATUS_OK = uint8_t(0);
+const auto STATUS_ERROR = uint8_t(1);
+
+auto io_error(const std::string &what) -> std::runtime_error {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+auto socket_address(const std::filesystem::path &path) -> sockaddr_un {
+  auto address = sockaddr_un{};
+  address.sun_family = AF_UNIX;
+  if (path.native().size() >= sizeof(address.sun_path)) {
+    throw std::invalid_argument("Socket path too long: " + path.string());
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.native().size() + 1);
+  return address;
+}
+
+auto write_all(int fd, const uint8_t *data, uint64_t size) -> void {
+  while (size > 0) {
+    auto written = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw io_error("Cannot write to socket");
+    }
+    data += written;
+    size -= static_cast<uint64_t>(written);
+  }
+}
+
+// Returns the number of bytes read, short only at the end of the stream.
+auto read_all(int fd, uint8_t *data, uint64_t size) -> uint64_t {
+  auto done = 0UL;
+  while (done < size) {
+    auto got = ::recv(fd, data + done, size - done, 0);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw io_error("Cannot read from socket");
+    }
+    if (got == 0) {
+      break;
+    }
+    done += static_cast<uint64_t>(got);
+  }
+  return done;
+}
+
+auto append_frame(std::vector<uint8_t> &buffer, const std::vector<uint8_t> &payload) -> void {
+  auto size = static_cast<uint32_t>(payload.size());
+  auto header = reinterpret_cast<const uint8_t *>(&size);
+  buffer.insert(buffer.end(), header, header + FRAME_HEADER_SIZE);
+  buffer.insert(buffer.end(), payload.begin(), payload.end());
+}
+
+auto error_response(uint64_t id, const std::string &error) -> std::vector<uint8_t> {
+  return encode_response({id, std::nullopt, error});
+}
+
+// Removes a socket left behind by a server that is gone, i.e. that refuses connections.
+auto remove_stale_socket(const std::filesystem::path &path, const sockaddr_un &address) -> void {
+  auto status = std::filesystem::symlink_status(path);
+  if (!std::filesystem::exists(status)) {
+    return;
+  }
+  if (!std::filesystem::is_socket(status)) {
+    throw std::runtime_error("Not a socket: " + path.string());
+  }
+  auto probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (probe < 0) {
+    throw io_error("Cannot create socket");
+  }
+  auto connected = ::connect(probe, reinterpret_cast<const sockaddr *>(&address),
+                             sizeof(address)) == 0;
+  auto refused = !connected && errno == ECONNREFUSED;
+  ::close(probe);
+  if (connected) {
+    throw std::runtime_error("Another server listens on " + path.string());
+  }
+  if (refused) {
+    std::filesystem::remove(path);
+  }
+}
+
+} // namespace
+
+auto encode_request(const synthesis_request &request) -> std::vector<uint8_t> {
+  auto payload = std::vector<uint8_t>();
+  write_varint(payload, request.id);
+  write_varint(payload, request.target.size());
+  for (auto row : request.target.data()) {
+    write_varint(payload, row);
+  }
+  return payload;
+}
+
+auto decode_request(const std::vector<uint8_t> &payload, uint64_t max_bits)
+    -> synthesis_request {
+  const auto *position = payload.data();
+  const auto *end = payload.data() + payload.size();
+  auto id = read_varint(position, end);
+  auto bits_num = read_varint(position, end);
+  if (bits_num == 0 || bits_num > max_bits) {
+    throw std::invalid_argument("Target has " + std::to_string(bits_num) +
+                                " lines, the server accepts 1 to " + std::to_string(max_bits));
+  }
+  auto tt = truth_table(bits_num);
+  auto seen = std::vector<bool>(tt.length());
+  for (auto row = 0UL; row < tt.length(); row++) {
+    auto value = read_varint(position, end);
+    if (value >= tt.length() || seen[value]) {
+      throw std::invalid_argument("Target is not a permutation");
+    }
+    seen[value] = true;
+    tt[row] = value;
+  }
+  if (position != end) {
+    throw std::invalid_argument("Trailing bytes in request");
+  }
+  return {id, std::move(tt)};
+}
+
+auto encode_response(const synthesis_response &response) -> std::vector<uint8_t> {
+  auto payload = std::vector<uint8_t>();
+  write_varint(payload, response.id);
+  if (!response.circ) {
+    payload.push_back(STATUS_ERROR);
+    payload.insert(payload.end(), response.error.begin(), response.error.end());
+    return payload;
+  }
+  payload.push_back(STATUS_OK);
+  write_varint(payload, response.circ->bits_num());
+  write_varint(payload, response.circ->gates_num());
+  for (const auto &g : response.circ->gates()) {
+    write_gate(payload, g);
+  }
+  return payload;
+}
+
+auto decode_response(const std::vector<uint8_t> &payload) -> synthesis_response {
+  const auto *position = payload.data();
+  const auto *end = payload.data() + payload.size();
+  auto id = read_varint(position, end);
+  if (position == end) {
+    throw std::invalid_argument("Truncated response");
+  }
+  if (*position++ != STATUS_OK) {
+    return {id, std::nullopt, std::string(position, end)};
+  }
+  auto bits_num = read_varint(position, end);
+  auto gates_num = read_varint(position, end);
+  auto gates = std::deque<gate>();
+  for (auto i = 0UL; i < gates_num; i++) {
+    gates.push_back(read_gate(position, end, bits_num));
+  }
+  return {id, circuit(bits_num, std::move(gates)), {}};
+}
+
+auto write_frame(int fd, const std::vector<uint8_t> &payload) -> void {
+  auto buffer = std::vector<uint8_t>();
+  append_frame(buffer, payload);
+  write_all(fd, buffer.data(), buffer.size());
+}
+
+auto max_request_size(uint64_t max_bits) -> uint64_t {
+  const auto header_size = 2 * MAX_VARINT_SIZE;
+  const auto max_rows = (MAX_FRAME_SIZE - header_size) / sizeof(uint64_t);
+  if (max_bits >= static_cast<uint64_t>(std::bit_width(max_rows))) {
+    return MAX_FRAME_SIZE;
+  }
+  return header_size + (sizeof(uint64_t) << max_bits);
+}
+
+auto read_frame(int fd, std::vector<uint8_t> &payload, uint64_t max_size) -> bool {
+  auto size = uint32_t();
+  auto got = read_all(fd, reinterpret_cast<uint8_t *>(&size), FRAME_HEADER_SIZE);
+  if (got == 0) {
+    return false;
+  }
+  if (got != FRAME_HEADER_SIZE || size > max_size) {
+    throw std::invalid_argument("Malformed frame");
+  }
+  payload.resize(size);
+  if (read_all(fd, payload.data(), size) != size) {
+    throw std::invalid_argument("Truncated frame");
+  }
+  return true;
+}
+
+// Answers wait in outbox for the writer thread. pending counts requests handed to the workers and
+// not answered yet; the writer ends once reading is done and every answer is sent.
+struct synthesis_server::connection {
+  int fd;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<uint8_t> outbox;
+  uint64_t pending = 0;
+  bool reading_done = false;
+  bool broken = false;
+
+  explicit connection(int socket_fd) : fd(socket_fd) {}
+  connection(const connection &) = delete;
+  auto operator=(const connection &) -> connection & = delete;
+  ~connection() { ::close(fd); }
+};
+
+synthesis_server::synthesis_server(const synthesiser &synth,
+                                   const std::filesystem::path &socket_path, server_options opts)
+    : synth_(synth), opts_(opts), socket_path_(socket_path),
+      listen_fd_(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)), jobs_(opts.queue_size) {
+  if (listen_fd_ < 0) {
+    throw io_error("Cannot create socket");
+  }
+  if (opts_.cache_capacity > 0) {
+    cache_ = std::make_unique<cached_synthesiser>(synth_, opts_.cache_capacity);
+  }
+  try {
+    auto address = socket_address(socket_path_);
+    remove_stale_socket(socket_path_, address);
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+      throw io_error("Cannot bind " + socket_path_.string());
+    }
+    if (::listen(listen_fd_, SOMAXCONN) != 0) {
+      throw io_error("Cannot listen on " + socket_path_.string());
+    }
+  }
+  catch (...) {
+    ::close(listen_fd_);
+    throw;
+  }
+  auto workers_num = threads_num(opts_.threads_num);
+  workers_.reserve(workers_num);
+  for (auto i = 0UL; i < workers_num; i++) {
+    workers_.emplace_back([this]() { work(); });
+  }
+}
+
+synthesis_server::~synthesis_server() {
+  stop();
+  {
+    auto lock = std::unique_lock(connections_mutex_);
+    for (auto &weak : connections_) {
+      if (auto conn = weak.lock()) {
+        ::shutdown(conn->fd, SHUT_RDWR);
+      }
+    }
+    io_threads_done_.wait(lock, [this]() { return io_threads_running_ == 0; });
+  }
+  jobs_.close();
+  for (auto &w : workers_) {
+    w.join();
+  }
+  ::close(listen_fd_);
+  std::error_code ignored;
+  std::filesystem::remove(socket_path_, ignored);
+}
+
+auto synthesis_server::run() -> void {
+  while (!stopping_) {
+    auto fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (stopping_) {
+        break;
+      }
+      throw io_error("Cannot accept connection");
+    }
+    auto conn = std::make_shared<connection>(fd);
+    connections_num_++;
+    auto lock = std::lock_guard(connections_mutex_);
+    connections_.remove_if([](const auto &weak) { return weak.expired(); });
+    connections_.push_back(conn);
+    start_io_thread(conn, &synthesis_server::read_connection);
+    start_io_thread(conn, &synthesis_server::write_connection);
+  }
+}
+
+// Called with connections_mutex_ held.
+auto synthesis_server::start_io_thread(
+    const std::shared_ptr<connection> &conn,
+    void (synthesis_server::*io)(const std::shared_ptr<connection> &)) -> void {
+  io_threads_running_++;
+  std::thread([this, conn, io]() {
+    (this->*io)(conn);
+    auto done_lock = std::lock_guard(connections_mutex_);
+    io_threads_running_--;
+    io_threads_done_.notify_all();
+  }).detach();
+}
+
+auto synthesis_server::stop() -> void {
+  if (!stopping_.exchange(true)) {
+    // wakes the accept call of run
+    ::shutdown(listen_fd_, SHUT_RDWR);
+  }
+}
+
+auto synthesis_server::read_connection(const std::shared_ptr<connection> &conn) -> void {
+  auto payload = std::vector<uint8_t>();
+  try {
+    while (!stopping_ && read_frame(conn->fd, payload, max_request_size(opts_.max_bits))) {
+      {
+        auto lock = std::unique_lock(conn->mutex);
+        conn->changed.wait(
+            lock, [&conn]() { return conn->outbox.size() < MAX_OUTBOX_SIZE || conn->broken; });
+        if (conn->broken) {
+          break;
+        }
+        conn->pending++;
+      }
+      if (!jobs_.push({conn, payload})) {
+        auto lock = std::lock_guard(conn->mutex);
+        conn->pending--;
+        break;
+      }
+    }
+  }
+  catch (const std::exception &) {
+    // a broken stream cannot be resynchronised, the client sees the connection close
+  }
+  ::shutdown(conn->fd, SHUT_RD);
+  auto lock = std::lock_guard(conn->mutex);
+  conn->reading_done = true;
+  conn->changed.notify_all();
+}
+
+auto synthesis_server::write_connection(const std::shared_ptr<connection> &conn) -> void {
+  auto buffer = std::vector<uint8_t>();
+  auto lock = std::unique_lock(conn->mutex);
+  while (true) {
+    conn->changed.wait(lock, [&conn]() {
+      return !conn->outbox.empty() || conn->broken || (conn->reading_done && conn->pending == 0);
+    });
+    if (conn->outbox.empty() || conn->broken) {
+      return;
+    }
+    buffer.clear();
+    std::swap(buffer, conn->outbox);
+    // room for the reader again
+    conn->changed.notify_all();
+    lock.unlock();
+    try {
+      write_all(conn->fd, buffer.data(), buffer.size());
+    }
+    catch (const std::exception &) {
+      // the client went away, answers still to come are dropped
+      ::shutdown(conn->fd, SHUT_RDWR);
+      lock.lock();
+      conn->broken = true;
+      conn->outbox.clear();
+      conn->changed.notify_all();
+      return;
+    }
+    lock.lock();
+  }
+}
+
+auto synthesis_server::answer(const job &j) -> std::vector<uint8_t> {
+  auto id = 0UL;
+  try {
+    // the id first, so that requests failing validation are answered with theirs
+    const auto *position = j.payload.data();
+    id = read_varint(position, j.payload.data() + j.payload.size());
+    auto request = decode_request(j.payload, opts_.max_bits);
+    const auto &engine = cache_ ? static_cast<const synthesiser &>(*cache_) : synth_;
+    auto circ = engine.synthesize(std::move(request.target));
+    return encode_response({id, std::move(circ), {}});
+  }
+  catch (const std::exception &e) {
+    failed_++;
+    return error_response(id, e.what());
+  }
+}
+
+auto synthesis_server::work() -> void {
+  const auto workers_num = threads_num(opts_.threads_num);
+  for (auto batch = jobs_.pop_batch(opts_.batch_size, workers_num); !batch.empty();
+       batch = jobs_.pop_batch(opts_.batch_size, workers_num)) {
+    batches_++;
+    requests_ += batch.size();
+    // one hand-over per connection for the whole batch
+    auto replies = std::map<connection *, std::pair<std::shared_ptr<connection>,
+                                                    std::vector<uint8_t>>>();
+    auto answered = std::map<connection *, uint64_t>();
+    for (const auto &j : batch) {
+      auto &[conn, buffer] = replies[j.conn.get()];
+      conn = j.conn;
+      append_frame(buffer, answer(j));
+      answered[j.conn.get()]++;
+    }
+    for (auto &[key, reply] : replies) {
+      auto &[conn, buffer] = reply;
+      auto lock = std::lock_guard(conn->mutex);
+      if (!conn->broken) {
+        conn->outbox.insert(conn->outbox.end(), buffer.begin(), buffer.end());
+      }
+      conn->pending -= answered[key];
+      conn->changed.notify_all();
+    }
+  }
+}
+
+auto synthesis_server::stats() const -> server_stats {
+  auto result = server_stats{connections_num_, requests_, failed_, batches_, {}};
+  if (cache_) {
+    result.cache = cache_->stats();
+  }
+  return result;
+}
+
+synthesis_client::synthesis_client(const std::filesystem::path &socket_path)
+    : fd_(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) {
+  if (fd_ < 0) {
+    throw io_error("Cannot create socket");
+  }
+  try {
+    auto address = socket_address(socket_path);
+    if (::connect(fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+      throw io_error("Cannot connect to " + socket_path.string());
+    }
+  }
+  catch (...) {
+    ::close(fd_);
+    throw;
+  }
+}
+
+synthesis_client::~synthesis_client() { ::close(fd_); }
+
+auto synthesis_client::send(const synthesis_request &request) -> void {
+  write_frame(fd_, encode_request(request));
+}
+
+auto synthesis_client::receive() -> synthesis_response {
+  auto payload = std::vector<uint8_t>();
+  if (!read_frame(fd_, payload)) {
+    throw std::runtime_error("Server closed the connection");
+  }
+  return decode_response(payload);
+}
+
+auto synthesis_client::synthesize(const truth_table &target) -> circuit {
+  send({0, target});
+  auto response = receive();
+  if (!response.circ) {
+    throw std::runtime_error(response.error);
+  }
+  return std::move(*response.circ);
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include "cache/cache.hpp"
+#include "circuit/circuit.hpp"
+#include "pipeline/pipeline.hpp"
+#include "synthesisers/synthesiser.hpp"
+#include "truth_table/truth_table.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Synthesis over a Unix stream socket. Every message is framed as a little endian uint32 payload
+// size followed by the payload:
+//   request   varint id, varint bits_num, 2^bits_num varint rows
+//   response  varint id, status byte, then for status 0 varint bits_num, varint gates_num and
+//             every gate as written by write_gate; otherwise the error message
+// A connection may have any number of requests in flight, responses carry the request id and
+// come in completion order.
+
+const auto MAX_FRAME_SIZE = 64UL << 20;
+const auto MAX_OUTBOX_SIZE = 64UL << 20;
+
+// Largest request frame for targets of up to max_bits lines: two header varints and at most 8
+// bytes per row, as rows of up to 56 bits fit 8 varint bytes.
+auto max_request_size(uint64_t max_bits) -> uint64_t;
+
+struct synthesis_request {
+  uint64_t id;
+  truth_table target;
+};
+
+struct synthesis_response {
+  uint64_t id;
+  std::optional<circuit> circ; // empty when synthesis failed
+  std::string error;
+};
+
+auto encode_request(const synthesis_request &request) -> std::vector<uint8_t>;
+auto decode_request(const std::vector<uint8_t> &payload, uint64_t max_bits) -> synthesis_request;
+auto encode_response(const synthesis_response &response) -> std::vector<uint8_t>;
+auto decode_response(const std::vector<uint8_t> &payload) -> synthesis_response;
+
+// Blocking frame IO on a socket. read_frame returns false on a clean end of stream and throws for
+// frames over max_size before reading their payload.
+auto write_frame(int fd, const std::vector<uint8_t> &payload) -> void;
+auto read_frame(int fd, std::vector<uint8_t> &payload, uint64_t max_size = MAX_FRAME_SIZE) -> bool;
+
+struct server_options {
+  uint64_t threads_num = 0;          // synthesis workers, 0 - use all hardware threads
+  uint64_t batch_size = 32;          // most requests a worker takes at once, at most its share
+  uint64_t queue_size = 4096;        // requests waiting for a worker
+  uint64_t cache_capacity = 1 << 16; // circuits kept warm in memory, 0 - no cache
+  uint64_t max_bits = 16;            // larger targets are refused
+};
+
+struct server_stats {
+  uint64_t connections = 0;
+  uint64_t requests = 0;
+  uint64_t failed = 0;
+  uint64_t batches = 0;
+  cache_stats cache;
+};
+
+// Long running synthesis service. Connections are read by one thread each, which only frames
+// requests; a shared pool of workers takes queued requests in batches, synthesises them through
+// an in-memory cache and hands the answers to a writer thread of each connection, so a client
+// that stops reading stalls only its own connection. Once its unsent answers pass
+// MAX_OUTBOX_SIZE, its requests are no longer read either.
+class synthesis_server {
+  struct connection;
+  struct job {
+    std::shared_ptr<connection> conn;
+    std::vector<uint8_t> payload;
+  };
+
+  const synthesiser &synth_;
+  std::unique_ptr<cached_synthesiser> cache_;
+  server_options opts_;
+  std::filesystem::path socket_path_;
+  int listen_fd_;
+
+  bounded_queue<job> jobs_;
+  std::atomic<bool> stopping_{false};
+  std::mutex connections_mutex_;
+  std::list<std::weak_ptr<connection>> connections_;
+  uint64_t io_threads_running_ = 0;
+  std::condition_variable io_threads_done_;
+  std::vector<std::thread> workers_;
+
+  std::atomic<uint64_t> connections_num_{0};
+  std::atomic<uint64_t> requests_{0};
+  std::atomic<uint64_t> failed_{0};
+  std::atomic<uint64_t> batches_{0};
+
+  auto read_connection(const std::shared_ptr<connection> &conn) -> void;
+  auto write_connection(const std::shared_ptr<connection> &conn) -> void;
+  auto start_io_thread(const std::shared_ptr<connection> &conn,
+                       void (synthesis_server::*io)(const std::shared_ptr<connection> &)) -> void;
+  auto work() -> void;
+  auto answer(const job &j) -> std::vector<uint8_t>;
+
+public:
+  // Binds and listens on socket_path, replacing a socket no server listens on. Throws
+  // std::runtime_error if another server does, or the path is not a socket.
+  synthesis_server(const synthesiser &synth, const std::filesystem::path &socket_path,
+                   server_options opts = {});
+  synthesis_server(const synthesis_server &) = delete;
+  auto operator=(const synthesis_server &) -> synthesis_server & = delete;
+  ~synthesis_server();
+
+  // Accepts connections until stop is called. Has to have returned before destruction.
+  auto run() -> void;
+  // Safe to call from any thread or more than once.
+  auto stop() -> void;
+  [[nodiscard]] auto stats() const -> server_stats;
+};
+
+class synthesis_client {
+  int fd_;
+
+public:
+  explicit synthesis_client(const std::filesystem::path &socket_path);
+  synthesis_client(const synthesis_client &) = delete;
+  auto operator=(const synthesis_client &) -> synthesis_client & = delete;
+  ~synthesis_client();
+
+  auto send(const synthesis_request &request) -> void;
+  auto receive() -> synthesis_response;
+  // One request in flight; throws std::runtime_error with the server message on failure.
+  auto synthesize(const truth_table &target) -> circuit;
+};
@@ -0,0 +1,179 @@
+#include "server.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <future>
+#include <random>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace server_ut {
+const auto EPOCHS = 100;
+const auto max_bits = 8;
+std::mt19937_64 mrnd;
+
+auto socket_path() -> std::filesystem::path {
+  return std::filesystem::temp_directory_path() /
+         ("revsynth_server_ut_" + std::to_string(::getpid()) + ".sock");
+}
+} // namespace server_ut
+
+using namespace server_ut;
+
+TEST_CASE("server message encoding", "[server]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  auto tt = truth_table(bits).shuffle(mrnd);
+  auto id = mrnd();
+
+  auto request = decode_request(encode_request({id, tt}), max_bits);
+  REQUIRE(request.id == id);
+  REQUIRE(request.target == tt);
+  REQUIRE_THROWS_AS(decode_request(encode_request({id, tt}), bits - 1), std::invalid_argument);
+  auto broken = tt;
+  broken[0] = broken[tt.length() - 1];
+  REQUIRE_THROWS_AS(decode_request(encode_request({id, broken}), max_bits),
+                    std::invalid_argument);
+
+  auto circ = mmd03().synthesize(tt);
+  auto response = decode_response(encode_response({id, circ, {}}));
+  REQUIRE(response.id == id);
+  REQUIRE(response.circ == circ);
+  auto failure = decode_response(encode_response({id, std::nullopt, "failed"}));
+  REQUIRE_FALSE(failure.circ.has_value());
+  REQUIRE(failure.error == "failed");
+}
+
+TEST_CASE("synthesis server", "[server], [mmd03]") {
+  auto synth = mmd03();
+  auto server = synthesis_server(synth, socket_path(), {2, 8, 64, 1024, max_bits});
+  auto accepting = std::thread([&server]() { server.run(); });
+
+  const auto clients_num = 4UL;
+  const auto requests_num = 50UL;
+  auto targets = std::vector<truth_table>();
+  for (auto i = 0UL; i < requests_num; i++) {
+    targets.push_back(truth_table(1 + mrnd() % max_bits).shuffle(mrnd));
+  }
+  auto mismatches = std::atomic<uint64_t>(0);
+  auto clients = std::vector<std::thread>();
+  for (auto c = 0UL; c < clients_num; c++) {
+    clients.emplace_back([&]() {
+      auto client = synthesis_client(socket_path());
+      // every request in flight at once, answers may come back in any order
+      for (auto i = 0UL; i < requests_num; i++) {
+        client.send({i, targets[i]});
+      }
+      for (auto i = 0UL; i < requests_num; i++) {
+        auto response = client.receive();
+        if (!response.circ || response.circ->output_tt() != targets[response.id]) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto &c : clients) {
+    c.join();
+  }
+  REQUIRE(mismatches == 0);
+
+  auto client = synthesis_client(socket_path());
+  REQUIRE_THROWS_AS(client.synthesize(truth_table(max_bits + 1)), std::runtime_error);
+  REQUIRE(client.synthesize(targets[0]).output_tt() == targets[0]);
+
+  server.stop();
+  accepting.join();
+  auto stats = server.stats();
+  REQUIRE(stats.connections == clients_num + 1);
+  REQUIRE(stats.requests == clients_num * requests_num + 2);
+  REQUIRE(stats.failed == 1);
+  REQUIRE(stats.batches <= stats.requests);
+  // concurrent requests for the same target may all miss, the last one is a warm hit
+  REQUIRE(stats.cache.memory_hits + stats.cache.misses == clients_num * requests_num + 1);
+  REQUIRE(stats.cache.memory_hits > 0);
+}
+
+TEST_CASE("synthesis server errors", "[server]") {
+  auto synth = mmd03();
+
+  SECTION("failed requests are answered with their id") {
+    auto server = synthesis_server(synth, socket_path(), {1, 8, 64, 0, max_bits});
+    auto accepting = std::thread([&server]() { server.run(); });
+    auto client = synthesis_client(socket_path());
+    client.send({42, truth_table(max_bits + 1)});
+    auto response = client.receive();
+    REQUIRE(response.id == 42);
+    REQUIRE_FALSE(response.circ.has_value());
+    server.stop();
+    accepting.join();
+  }
+
+  SECTION("frames over the request size limit close the connection") {
+    auto largest = truth_table(max_bits).shuffle(mrnd);
+    REQUIRE(encode_request({~0UL, largest}).size() <= max_request_size(max_bits));
+    REQUIRE(max_request_size(64) == MAX_FRAME_SIZE);
+
+    auto server = synthesis_server(synth, socket_path(), {1, 8, 64, 0, max_bits});
+    auto accepting = std::thread([&server]() { server.run(); });
+    auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    socket_path().native().copy(address.sun_path, sizeof(address.sun_path) - 1);
+    REQUIRE(::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0);
+    auto size = static_cast<uint32_t>(max_request_size(max_bits) + 1);
+    REQUIRE(::write(fd, &size, sizeof(size)) == sizeof(size));
+    auto payload = std::vector<uint8_t>();
+    REQUIRE_FALSE(read_frame(fd, payload));
+    ::close(fd);
+    server.stop();
+    accepting.join();
+  }
+
+  SECTION("only sockets no server listens on are replaced") {
+    std::filesystem::remove(socket_path());
+    std::ofstream(socket_path()) << "not a socket";
+    REQUIRE_THROWS_AS(synthesis_server(synth, socket_path()), std::runtime_error);
+    REQUIRE(std::filesystem::is_regular_file(socket_path()));
+    std::filesystem::remove(socket_path());
+
+    // a socket bound and closed without unlinking, as a crashed server leaves it
+    auto stale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    socket_path().native().copy(address.sun_path, sizeof(address.sun_path) - 1);
+    REQUIRE(::bind(stale, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0);
+    ::close(stale);
+
+    auto server = synthesis_server(synth, socket_path(), {1, 8, 64, 0, max_bits});
+    auto accepting = std::thread([&server]() { server.run(); });
+    REQUIRE_THROWS_AS(synthesis_server(synth, socket_path()), std::runtime_error);
+    auto tt = truth_table(3).shuffle(mrnd);
+    REQUIRE(synthesis_client(socket_path()).synthesize(tt).output_tt() == tt);
+    server.stop();
+    accepting.join();
+  }
+}
+
+TEST_CASE("synthesis server with a client that stops reading", "[server], [mmd03]") {
+  auto synth = mmd03();
+  auto server = synthesis_server(synth, socket_path(), {1, 8, 4096, 16, max_bits});
+  auto accepting = std::thread([&server]() { server.run(); });
+
+  // far more answers than the socket buffers hold
+  auto stalled = synthesis_client(socket_path());
+  auto tt = truth_table(max_bits).shuffle(mrnd);
+  for (auto i = 0UL; i < 2000; i++) {
+    stalled.send({i, tt});
+  }
+  auto answered = std::async(std::launch::async, [&tt]() {
+    return synthesis_client(socket_path()).synthesize(tt).output_tt() == tt;
+  });
+  REQUIRE(answered.wait_for(std::chrono::seconds(30)) == std::future_status::ready);
+  REQUIRE(answered.get());
+
+  server.stop();
+  accepting.join();
+}
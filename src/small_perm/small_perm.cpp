@@ -0,0 +1,83 @@
+#include "small_perm.hpp"
+#include <bit>
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+
+namespace {
+
+// nibble i of word -> byte i
+auto unpack(uint64_t word) -> __m128i {
+  auto packed = _mm_cvtsi64_si128(static_cast<long long>(word));
+  auto low = _mm_and_si128(packed, _mm_set1_epi8(0x0F));
+  auto high = _mm_and_si128(_mm_srli_epi16(packed, 4), _mm_set1_epi8(0x0F));
+  return _mm_unpacklo_epi8(low, high);
+}
+
+// byte i (< 16) -> nibble i
+auto pack(__m128i bytes) -> uint64_t {
+  auto pairs = _mm_maddubs_epi16(bytes, _mm_set1_epi16(0x1001));
+  return static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_packus_epi16(pairs, pairs)));
+}
+
+} // namespace
+#endif
+
+auto small_perm::from_table(const truth_table &tt) -> small_perm {
+  auto perm = small_perm(tt.size());
+  for (auto row = 0UL; row < tt.length(); row++) {
+    perm.set_row(row, tt[row]);
+  }
+  return perm;
+}
+
+auto small_perm::to_table() const -> truth_table {
+  auto tt = truth_table(bits_num_);
+  for (auto row = 0UL; row < length(); row++) {
+    tt[row] = (*this)[row];
+  }
+  return tt;
+}
+
+auto small_perm::operator+(const small_perm &rhs) const -> small_perm {
+  if (bits_num_ != rhs.bits_num_) {
+    throw std::invalid_argument("Cannot compose permutations of different sizes");
+  }
+  auto result = small_perm(*this);
+#ifdef __SSSE3__
+  // Unused rows hold 0, which picks rhs[0]; they are cleared again below.
+  result.word_ = pack(_mm_shuffle_epi8(unpack(rhs.word_), unpack(word_)));
+  if (bits_num_ < MAX_BITS) {
+    result.word_ &= (1UL << (4 * length())) - 1;
+  }
+#else
+  result.word_ = 0;
+  for (auto row = 0UL; row < length(); row++) {
+    result.word_ |= rhs[(*this)[row]] << (4 * row);
+  }
+#endif
+  return result;
+}
+
+auto small_perm::inverse() const noexcept -> small_perm {
+  auto result = *this;
+  result.word_ = 0;
+  for (auto row = 0UL; row < length(); row++) {
+    result.word_ |= row << (4 * (*this)[row]);
+  }
+  return result;
+}
+
+auto small_perm::rank() const noexcept -> uint64_t {
+  // Lehmer code; the set of still unused values is a 16-bit mask, so the digit of each row is
+  // the number of smaller unused values.
+  auto unused = static_cast<uint64_t>((1UL << length()) - 1);
+  auto result = 0UL;
+  for (auto row = 0UL; row < length(); row++) {
+    auto value = (*this)[row];
+    auto smaller = static_cast<uint64_t>(std::popcount(unused & ((1UL << value) - 1)));
+    result = result * (length() - row) + smaller;
+    unused &= ~(1UL << value);
+  }
+  return result;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "truth_table/truth_table.hpp"
+#include <cstdint>
+#include <stdexcept>
+
+// Toffoli gate on at most 4 lines, as stored by allocation free small circuits.
+struct small_gate {
+  uint8_t control_mask;
+  uint8_t target;
+
+  auto operator==(const small_gate &rhs) const -> bool = default;
+};
+
+// Permutation of at most 4 lines packed into one word, row x in nibble x. Gates are applied
+// with SWAR nibble arithmetic, composition is a nibble shuffle (pshufb when built for SSSE3).
+class small_perm {
+  uint64_t bits_num_;
+  uint64_t word_;
+
+  static constexpr auto LOW_BITS = 0x1111111111111111UL;
+
+  // Low bit of every used nibble whose value matches polarity_mask on the bits of control_mask.
+  [[nodiscard]] static constexpr auto matching_lanes(uint64_t word, uint64_t control_mask,
+                                                     uint64_t polarity_mask,
+                                                     uint64_t lanes) noexcept -> uint64_t {
+    auto differs = (word & (control_mask * LOW_BITS)) ^ (polarity_mask * LOW_BITS);
+    differs |= differs >> 1;
+    differs |= differs >> 2;
+    return ~differs & lanes;
+  }
+
+  [[nodiscard]] constexpr auto lanes() const noexcept -> uint64_t {
+    return bits_num_ == MAX_BITS ? LOW_BITS : LOW_BITS & ((1UL << (4 * length())) - 1);
+  }
+
+public:
+  static constexpr auto MAX_BITS = 4UL;
+
+  constexpr explicit small_perm(uint64_t bits_num) : bits_num_(bits_num), word_(0) {
+    if (bits_num == 0 || bits_num > MAX_BITS) {
+      throw std::invalid_argument("small_perm holds 1 to 4 lines");
+    }
+    for (auto row = 0UL; row < length(); row++) {
+      word_ |= row << (4 * row);
+    }
+  }
+
+  static auto from_table(const truth_table &tt) -> small_perm;
+  [[nodiscard]] auto to_table() const -> truth_table;
+
+  [[nodiscard]] constexpr auto bits_num() const noexcept -> uint64_t { return bits_num_; }
+  [[nodiscard]] constexpr auto length() const noexcept -> uint64_t { return 1UL << bits_num_; }
+  [[nodiscard]] constexpr auto word() const noexcept -> uint64_t { return word_; }
+
+  [[nodiscard]] constexpr auto operator[](uint64_t row) const noexcept -> uint64_t {
+    return (word_ >> (4 * row)) & 0xF;
+  }
+  constexpr auto set_row(uint64_t row, uint64_t value) noexcept -> small_perm & {
+    word_ = (word_ & ~(0xFUL << (4 * row))) | (value << (4 * row));
+    return *this;
+  }
+
+  // Same as gate::apply_back of a Toffoli gate: every value v becomes g(v).
+  constexpr auto apply_back(uint64_t control_mask, uint64_t target,
+                            uint64_t polarity_mask) noexcept -> small_perm & {
+    word_ ^= matching_lanes(word_, control_mask, polarity_mask, lanes()) << target;
+    return *this;
+  }
+  constexpr auto apply_back(uint64_t control_mask, uint64_t target) noexcept -> small_perm & {
+    return apply_back(control_mask, target, control_mask);
+  }
+
+  // Same as gate::apply_front of a Toffoli gate: row x takes the value of row g(x). Swaps the
+  // nibbles of every matching row pair with a single delta swap.
+  constexpr auto apply_front(uint64_t control_mask, uint64_t target,
+                             uint64_t polarity_mask) noexcept -> small_perm & {
+    auto identity = small_perm(bits_num_).word_;
+    auto target_clear = matching_lanes(identity, 1UL << target, 0, lanes());
+    auto rows = matching_lanes(identity, control_mask, polarity_mask, lanes()) & target_clear;
+    auto shift = 4 * (1UL << target);
+    auto delta = ((word_ >> shift) ^ word_) & (rows * 0xF);
+    word_ ^= delta | (delta << shift);
+    return *this;
+  }
+  constexpr auto apply_front(uint64_t control_mask, uint64_t target) noexcept -> small_perm & {
+    return apply_front(control_mask, target, control_mask);
+  }
+
+  // (lhs + rhs)[x] = rhs[lhs[x]], as truth_table::operator+.
+  [[nodiscard]] auto operator+(const small_perm &rhs) const -> small_perm;
+  [[nodiscard]] auto inverse() const noexcept -> small_perm;
+  // Lexicographic index among all permutations of length() rows.
+  [[nodiscard]] auto rank() const noexcept -> uint64_t;
+
+  constexpr auto operator==(const small_perm &rhs) const noexcept -> bool = default;
+};
@@ -0,0 +1,29 @@
+#include "bench/bench.hpp"
+#include "small_perm.hpp"
+#include <random>
+
+namespace small_perm_bench {
+std::mt19937_64 mrnd;
+} // namespace small_perm_bench
+
+using namespace small_perm_bench;
+
+REVSYNTH_BENCH("small_perm/compose", 1, 4) {
+  auto bits = state.bits_num();
+  auto lhs = small_perm::from_table(truth_table(bits).shuffle(mrnd));
+  auto rhs = small_perm::from_table(truth_table(bits).shuffle(mrnd));
+  state.run(lhs.length(), [&]() {
+    lhs = lhs + rhs;
+    do_not_optimize(lhs);
+  });
+}
+
+REVSYNTH_BENCH("small_perm/apply_back", 1, 4) {
+  auto bits = state.bits_num();
+  auto perm = small_perm::from_table(truth_table(bits).shuffle(mrnd));
+  auto control_mask = mrnd() & ((1UL << bits) - 1) & ~1UL;
+  state.run(perm.length(), [&]() {
+    perm.apply_back(control_mask, 0);
+    do_not_optimize(perm);
+  });
+}
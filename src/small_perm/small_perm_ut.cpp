@@ -0,0 +1,105 @@
+#include "small_perm.hpp"
+#include "circuit/circuit.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <set>
+
+namespace small_perm_ut {
+const auto EPOCHS = 10000;
+const auto max_bits = static_cast<int>(small_perm::MAX_BITS);
+std::mt19937_64 mrnd;
+} // namespace small_perm_ut
+
+using namespace small_perm_ut;
+
+TEST_CASE("small_perm conversions", "[small_perm], [ctors]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  REQUIRE(small_perm(bits).to_table() == truth_table(bits));
+  auto tt = truth_table(bits).shuffle(mrnd);
+  auto perm = small_perm::from_table(tt);
+  REQUIRE(perm.bits_num() == bits);
+  REQUIRE(perm.length() == tt.length());
+  REQUIRE(perm.to_table() == tt);
+  REQUIRE_THROWS_AS(small_perm(0), std::invalid_argument);
+  REQUIRE_THROWS_AS(small_perm(small_perm::MAX_BITS + 1), std::invalid_argument);
+}
+
+TEST_CASE("small_perm gate applications", "[small_perm], [apply]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto tt = truth_table(bits).shuffle(mrnd);
+  auto perm = small_perm::from_table(tt);
+  auto g = gate(bits, mrnd);
+
+  auto back_tt = tt;
+  g.apply_back(back_tt);
+  REQUIRE(small_perm(perm).apply_back(g.control_mask(), g.target()).to_table() == back_tt);
+
+  auto front_tt = tt;
+  g.apply_front(front_tt);
+  REQUIRE(small_perm(perm).apply_front(g.control_mask(), g.target()).to_table() == front_tt);
+}
+
+TEST_CASE("small_perm composition and inverse", "[small_perm], [compose]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto lhs_tt = truth_table(bits).shuffle(mrnd);
+  auto rhs_tt = truth_table(bits).shuffle(mrnd);
+  auto lhs = small_perm::from_table(lhs_tt);
+  auto rhs = small_perm::from_table(rhs_tt);
+
+  REQUIRE((lhs + rhs).to_table() == lhs_tt + rhs_tt);
+  REQUIRE((lhs + lhs.inverse()) == small_perm(bits));
+  REQUIRE((lhs.inverse() + lhs) == small_perm(bits));
+  REQUIRE(lhs.inverse().to_table() == lhs_tt.inverse());
+  REQUIRE_THROWS_AS(lhs + small_perm(bits == 1 ? 2 : 1), std::invalid_argument);
+}
+
+TEST_CASE("small_perm rank", "[small_perm], [rank]") {
+  REQUIRE(small_perm(small_perm::MAX_BITS).rank() == 0);
+
+  auto tt = truth_table(3);
+  auto ranks = std::set<uint64_t>();
+  do {
+    ranks.insert(small_perm::from_table(tt).rank());
+  } while (std::next_permutation(tt.begin(), tt.end()));
+  REQUIRE(ranks.size() == 40320);
+  REQUIRE(*ranks.rbegin() == 40319);
+}
+
+TEST_CASE("small circuits built in bulk", "[small_perm], [circuit]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits + 2))));
+
+  const auto gates_num = mrnd() % 32;
+  auto pushed = circuit(bits);
+  auto gates = std::deque<gate>();
+  for (auto i = 0UL; i < gates_num; i++) {
+    auto g = gate(bits, mrnd);
+    pushed.push_back(g);
+    gates.push_back(g);
+  }
+  REQUIRE(circuit(bits, gates) == pushed);
+}
+
+TEST_CASE("mmd03 on small_perm", "[small_perm], [mmd03]") {
+  const auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto tt = truth_table(bits).shuffle(mrnd);
+  auto circ = mmd03().synthesize(tt);
+  REQUIRE(circ.output_tt() == tt);
+
+  auto gates = std::array<small_gate, MMD03_SMALL_GATES_MAX>();
+  auto gates_num = mmd03_small(small_perm::from_table(tt), gates);
+  REQUIRE(gates_num == circ.gates_num());
+  auto perm = small_perm(bits);
+  for (auto i = 0UL; i < gates_num; i++) {
+    REQUIRE(gates[i].control_mask == circ.gates()[i].control_mask());
+    REQUIRE(gates[i].target == circ.gates()[i].target());
+    perm.apply_back(gates[i].control_mask, gates[i].target);
+  }
+  REQUIRE(perm.to_table() == tt);
+}
@@ -31,9 +31,12 @@ auto state::check_value(uint64_t value) noexcept(false) -> uint64_t {
 state::state(uint64_t size, uint64_t value)
     : _size(check_size(size)), _mask(mask(size)), _value(check_value(value)) {}
 
-state::state(uint64_t size, std::mt19937_64 mrnd)
+state::state(uint64_t size, std::mt19937_64 &mrnd)
     : _size(check_size(size)), _mask(mask(size)), _value(mrnd() & _mask) {}
 
+state::state(uint64_t size, xoshiro256ss &rng)
+    : _size(check_size(size)), _mask(mask(size)), _value(rng() & _mask) {}
+
 auto state::size() const noexcept -> uint64_t { return _size; }
 
 auto state::mask() const noexcept -> uint64_t { return _mask; }
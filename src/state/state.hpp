@@ -1,4 +1,5 @@
 #pragma once
+#include "random/random.hpp"
 #include <cstdint>
 #include <limits>
 #include <random>
@@ -18,7 +19,8 @@ public:
   auto check_value(uint64_t value) noexcept(false) -> uint64_t;
 
   state(uint64_t size, uint64_t value);
-  state(uint64_t size, std::mt19937_64 mrnd);
+  state(uint64_t size, std::mt19937_64 &mrnd);
+  state(uint64_t size, xoshiro256ss &rng);
 
   [[nodiscard]] auto size() const noexcept -> uint64_t;
   [[nodiscard]] auto mask() const noexcept -> uint64_t;
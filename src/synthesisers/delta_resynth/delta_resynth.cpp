@@ -0,0 +1,110 @@
+#include "delta_resynth.hpp"
+#include "instrument/instrument.hpp"
+#include "state/state.hpp"
+#include <bit>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+auto lowest(uint64_t mask) -> uint64_t { return mask & (~mask + 1); }
+
+// Gate with every other line as a control, taking row to row ^ lines and back: a Toffoli gate for
+// a single line, a Fredkin gate for two lines of different values in row.
+auto step_gate(uint64_t bits_num, uint64_t row, uint64_t lines) -> gate {
+  auto control_mask = state::mask(bits_num) & ~lines;
+  auto controls = state(bits_num, control_mask).ones();
+  auto first = static_cast<uint64_t>(std::countr_zero(lines));
+  auto last = static_cast<uint64_t>(63 - std::countl_zero(lines));
+  auto g = first == last ? gate(bits_num, controls, first)
+                         : gate::fredkin(bits_num, controls, first, last);
+  return g.with_polarity(row & control_mask);
+}
+
+// Swaps rows a and b and no other: steps from a to b through rows differing in the lines not
+// flipped yet, then back to a without the last step, which restores the rows in between.
+auto push_transposition(uint64_t bits_num, uint64_t a, uint64_t b, std::deque<gate> &gates)
+    -> void {
+  auto path = std::vector<gate>();
+  auto up = b & ~a;
+  auto down = a & ~b;
+  for (auto row = a; row != b;) {
+    auto lines = up != 0 && down != 0 ? lowest(up) | lowest(down) : lowest(up | down);
+    path.push_back(step_gate(bits_num, row, lines));
+    row ^= lines;
+    up &= ~lines;
+    down &= ~lines;
+  }
+  gates.insert(gates.end(), path.begin(), path.end());
+  gates.insert(gates.end(), path.rbegin() + 1, path.rend());
+}
+
+} // namespace
+
+auto transposition_gates(const truth_table &residual, const synth_context &ctx)
+    -> std::deque<gate> {
+  REVSYNTH_SCOPE("delta_resynth/transposition_gates");
+  auto bits_num = residual.size();
+  auto rows_num = residual.length();
+  auto moved = std::vector<uint64_t>();
+  for (auto row = 0UL; row < rows_num; row++) {
+    if (residual[row] != row) {
+      moved.push_back(row);
+    }
+  }
+
+  auto gates = std::deque<gate>();
+  auto rows_fixed = rows_num - moved.size();
+  auto done = std::unordered_set<uint64_t>(moved.size());
+  auto cycle = std::vector<uint64_t>();
+  for (auto first : moved) {
+    if (done.contains(first)) {
+      continue;
+    }
+    ctx.throw_if_cancelled();
+    cycle.clear();
+    for (auto row = first; cycle.empty() || row != first; row = residual[row]) {
+      cycle.push_back(row);
+      done.insert(row);
+    }
+    // the cycle c0 -> c1 -> ... is (c0 c1)(c1 c2)...(ck-2 ck-1), the last transposition first
+    for (auto i = cycle.size() - 1; i > 0; i--) {
+      push_transposition(bits_num, cycle[i - 1], cycle[i], gates);
+    }
+    rows_fixed += cycle.size();
+    REVSYNTH_COUNT(rows_processed, cycle.size());
+    ctx.report({rows_fixed, rows_num, gates.size()});
+  }
+  ctx.report({rows_num, rows_num, gates.size()});
+  return gates;
+}
+
+delta_resynth::delta_resynth(circuit base) : base_(std::move(base)) {}
+
+auto delta_resynth::name() const -> std::string { return "delta"; }
+
+auto delta_resynth::base() const -> const circuit & { return base_; }
+
+auto delta_resynth::synthesize(truth_table target_tt) const -> circuit {
+  return synthesize(std::move(target_tt), synth_context());
+}
+
+auto delta_resynth::synthesize(truth_table target_tt, const synth_context &ctx) const
+    -> circuit {
+  auto circ = base_;
+  circ.push_back(patch(target_tt, ctx));
+  return circ;
+}
+
+auto delta_resynth::patch(const truth_table &target_tt, const synth_context &ctx) const
+    -> circuit {
+  REVSYNTH_SCOPE("delta_resynth/patch");
+  if (target_tt.size() != base_.bits_num()) {
+    throw std::invalid_argument("Target and base circuit differ in lines");
+  }
+  auto residual = base_.output_tt();
+  residual.inverse() += target_tt;
+  auto gates = transposition_gates(residual, ctx);
+  return {base_.bits_num(), std::move(gates), std::move(residual)};
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "synthesisers/synthesiser.hpp"
+#include <deque>
+#include <string>
+
+// Synthesis of targets that differ from the function f of a known circuit in a few rows. The
+// circuit is kept and followed by a patch for the residual permutation inverse(f) + target, which
+// moves only the rows where the two differ. Every cycle of the residual is split into
+// transpositions of consecutive rows, each one swapped along a path of fully controlled gates
+// that touch no other row: a Fredkin gate for each pair of bits going 0 to 1 and 1 to 0, a
+// mixed-polarity Toffoli gate for every other differing bit, and the path back. Apart from two
+// passes over the tables, the work and the patch grow with the moved rows times bits_num.
+//
+// The patch is not minimal and the circuit only grows with every edit, so a full synthesis once
+// in a while keeps circuits short.
+class delta_resynth : public synthesiser {
+  circuit base_;
+
+public:
+  explicit delta_resynth(circuit base);
+
+  [[nodiscard]] auto name() const -> std::string;
+  [[nodiscard]] auto base() const -> const circuit &;
+
+  using synthesiser::synthesize;
+  // base followed by the patch.
+  auto synthesize(truth_table target_tt) const -> circuit;
+  auto synthesize(truth_table target_tt, const synth_context &ctx) const -> circuit;
+  // The patch alone: gates taking the function of base to target_tt.
+  auto patch(const truth_table &target_tt, const synth_context &ctx = {}) const -> circuit;
+};
+
+// Gates realising residual in circuit order, as described above.
+auto transposition_gates(const truth_table &residual, const synth_context &ctx = {})
+    -> std::deque<gate>;
@@ -0,0 +1,31 @@
+#include "bench/bench.hpp"
+#include "delta_resynth.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <random>
+
+namespace delta_resynth_bench {
+std::mt19937_64 mrnd;
+
+// Target of a random circuit with four swapped pairs of rows.
+auto edited(const circuit &base) -> truth_table {
+  auto target_tt = base.output_tt();
+  for (auto i = 0; i < 4; i++) {
+    target_tt.swap(mrnd() % target_tt.length(), mrnd() % target_tt.length());
+  }
+  return target_tt;
+}
+} // namespace delta_resynth_bench
+
+using namespace delta_resynth_bench;
+
+REVSYNTH_BENCH("delta_resynth/synthesize", 4, 14) {
+  auto synth = delta_resynth(mmd03().synthesize(truth_table(state.bits_num()).shuffle(mrnd)));
+  auto target_tt = edited(synth.base());
+  state.run(target_tt.length(), [&]() { do_not_optimize(synth.synthesize(target_tt)); });
+}
+
+// Full synthesis of the same edited target, for comparison.
+REVSYNTH_BENCH("delta_resynth/full", 4, 14) {
+  auto target_tt = edited(mmd03().synthesize(truth_table(state.bits_num()).shuffle(mrnd)));
+  state.run(target_tt.length(), [&]() { do_not_optimize(mmd03().synthesize(target_tt)); });
+}
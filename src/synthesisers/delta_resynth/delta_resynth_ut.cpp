@@ -0,0 +1,96 @@
+#include "delta_resynth.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <bit>
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <random>
+
+namespace delta_resynth_ut {
+const auto EPOCHS = 100;
+const auto max_bits = 10;
+std::mt19937_64 mrnd;
+} // namespace delta_resynth_ut
+
+using namespace delta_resynth_ut;
+
+TEST_CASE("delta_resynth patches edited targets", "[delta_resynth]") {
+  auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto base = mmd03().synthesize(truth_table(bits).shuffle(mrnd));
+  auto target_tt = base.output_tt();
+  for (auto edits = mrnd() % 4; edits > 0; edits--) {
+    target_tt.swap(mrnd() % target_tt.length(), mrnd() % target_tt.length());
+  }
+  auto moved = 0UL;
+  for (auto row = 0UL; row < target_tt.length(); row++) {
+    moved += target_tt[row] != base.output_tt()[row] ? 1 : 0;
+  }
+
+  auto synth = delta_resynth(base);
+  auto circ = synth.synthesize(target_tt);
+  REQUIRE(circ.output_tt() == target_tt);
+  REQUIRE(std::equal(base.gates().begin(), base.gates().end(), circ.gates().begin()));
+  // at most a transposition per moved row, of at most 2 * bits - 1 gates
+  REQUIRE(circ.gates_num() - base.gates_num() <= moved * (2 * bits - 1));
+
+  auto patch = synth.patch(target_tt);
+  REQUIRE(patch == circuit(bits, patch.gates()));
+  REQUIRE(synth.patch(base.output_tt()).gates_num() == 0);
+  REQUIRE_THROWS_AS(synth.patch(truth_table(bits + 1)), std::invalid_argument);
+}
+
+TEST_CASE("transposition gates", "[delta_resynth]") {
+  auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  SECTION("a single transposition touches no other row") {
+    auto residual = truth_table(bits);
+    auto a = mrnd() % residual.length();
+    auto b = (a + 1 + mrnd() % (residual.length() - 1)) % residual.length();
+    if (bits == 1) {
+      b = a ^ 1;
+    }
+    residual.swap(a, b);
+    auto gates = transposition_gates(residual);
+    REQUIRE(circuit(bits, gates).output_tt() == residual);
+    auto up = static_cast<uint64_t>(std::popcount(b & ~a));
+    auto down = static_cast<uint64_t>(std::popcount(a & ~b));
+    REQUIRE(gates.size() == 2 * std::max(up, down) - 1);
+    for (const auto &g : gates) {
+      REQUIRE(g.controls_num() + (g.kind() == gate_kind::fredkin ? 2 : 1) == bits);
+    }
+  }
+
+  SECTION("cycles") {
+    auto residual = truth_table(bits);
+    auto rows = std::vector<uint64_t>();
+    for (auto i = 0UL; i < std::min(6UL, residual.length()); i++) {
+      rows.push_back(mrnd() % residual.length());
+    }
+    for (auto i = 1UL; i < rows.size(); i++) {
+      residual.swap(rows[i - 1], rows[i]);
+    }
+    REQUIRE(circuit(bits, transposition_gates(residual)).output_tt() == residual);
+  }
+}
+
+TEST_CASE("delta_resynth with synthesis context", "[delta_resynth], [context]") {
+  const auto bits = 8UL;
+  auto base = mmd03().synthesize(truth_table(bits).shuffle(mrnd));
+  auto target_tt = base.output_tt();
+  target_tt.swap(3, 200);
+  target_tt.swap(7, 100);
+
+  auto reports = std::vector<synth_progress>();
+  auto ctx = synth_context{.on_progress = [&](auto &p) { reports.push_back(p); }};
+  auto circ = delta_resynth(base).synthesize(target_tt, ctx);
+  REQUIRE(circ.output_tt() == target_tt);
+  REQUIRE(reports.size() == 3);
+  REQUIRE(reports[0].rows_fixed == target_tt.length() - 2);
+  REQUIRE(reports.back().rows_fixed == target_tt.length());
+  REQUIRE(reports.back().gates_num == circ.gates_num() - base.gates_num());
+
+  auto source = std::stop_source();
+  source.request_stop();
+  auto cancelled = synth_context{.stop_token = source.get_token()};
+  REQUIRE_THROWS_AS(delta_resynth(base).synthesize(target_tt, cancelled), synthesis_cancelled);
+}
@@ -1,59 +1,68 @@
 #include "mmd03.hpp"
+#include "instrument/instrument.hpp"
+#include "synthesisers/delta_resynth/delta_resynth.hpp"
 #include <algorithm>
 #include <bit>
 
 mmd03::mmd03(synth_mode sm) : sm_(sm) {}
 
-auto synthesize_first_row(truth_table &target_tt) -> circuit {
+auto mmd03::name() const -> std::string {
+  switch (sm_) {
+  case synth_mode::reduce_cl:
+    return "mmd03/reduce_cl";
+  case synth_mode::mixed:
+    return "mmd03/mixed";
+  default:
+    return "mmd03/naive";
+  }
+}
+
+auto synthesize_first_row(truth_table &target_tt, const gate_sink &emit) -> void {
   auto bits_num = target_tt.bits_num();
-  auto circ = circuit(bits_num);
 
   // f(0) = 0
   auto r0_state = state(bits_num, target_tt[0]);
   auto ones = r0_state.ones();
 
+  REVSYNTH_COUNT(gates_first_row, ones.size());
   for (auto one : ones) {
     auto new_gate = gate(bits_num, {}, one);
     new_gate.apply_back(target_tt);
-    circ.push_front(new_gate);
+    emit(new_gate);
   }
-  return circ;
 }
 
-auto synthesize_01_naive(truth_table &target_tt, uint64_t i) -> circuit {
+auto synthesize_01_naive(truth_table &target_tt, uint64_t i, const gate_sink &emit) -> void {
   auto bits_num = target_tt.bits_num();
-  auto circ = circuit(bits_num);
   auto row_i = target_tt[i];
   auto zero_to_one_mask = ~row_i & i;
   auto controls = state(bits_num, row_i).ones();
   auto zero_to_one_ids = state(bits_num, zero_to_one_mask).ones();
+  REVSYNTH_COUNT(gates_01, zero_to_one_ids.size());
   for (auto id : zero_to_one_ids) {
     auto new_gate = gate(bits_num, controls, id);
     new_gate.apply_back(target_tt);
-    circ.push_front(new_gate);
+    emit(new_gate);
   }
-  return circ;
 }
 
-auto synthesize_10_naive(truth_table &target_tt, uint64_t i) -> circuit {
+auto synthesize_10_naive(truth_table &target_tt, uint64_t i, const gate_sink &emit) -> void {
   auto bits_num = target_tt.bits_num();
-  auto circ = circuit(bits_num);
   auto row_i = target_tt[i];
   auto one_to_zero_mask = row_i & ~i;
   auto one_to_zero_ids = state(bits_num, one_to_zero_mask).ones();
   auto correct_ones_mask = row_i & i;
   auto correct_ones_ids = state(bits_num, correct_ones_mask).ones();
+  REVSYNTH_COUNT(gates_10, one_to_zero_ids.size());
   for (auto id : one_to_zero_ids) {
     auto new_gate = gate(bits_num, correct_ones_ids, id);
     new_gate.apply_back(target_tt);
-    circ.push_front(new_gate);
+    emit(new_gate);
   }
-  return circ;
 }
 
-auto synthesize_01_reduce_cl(truth_table &target_tt, uint64_t i) -> circuit {
+auto synthesize_01_reduce_cl(truth_table &target_tt, uint64_t i, const gate_sink &emit) -> void {
   auto bits_num = target_tt.bits_num();
-  auto circ = circuit(bits_num);
   auto row_i = target_tt[i];
   auto zero_to_one_mask = ~row_i & i;
   auto zero_to_one_ids = state(bits_num, zero_to_one_mask).ones();
@@ -68,24 +77,257 @@ auto synthesize_01_reduce_cl(truth_table &target_tt, uint64_t i) -> circuit {
     }
   }
   auto controls = state(bits_num, smallest_mask).ones();
+  REVSYNTH_COUNT(gates_01, zero_to_one_ids.size());
 
   for (auto id : zero_to_one_ids) {
     auto new_gate = gate(bits_num, controls, id);
     new_gate.apply_back(target_tt);
-    circ.push_front(new_gate);
+    emit(new_gate);
+  }
+}
+
+namespace {
+
+// Row loop of the naive steps on a packed permutation, taking the same decisions as the table
+// based functions above. emit receives (control_mask, target) pairs, after_row the next row.
+template <typename Emit, typename AfterRow>
+auto synthesize_rows_small(small_perm &perm, Emit &&emit, AfterRow &&after_row) -> void {
+  auto emit_ones = [&](uint64_t control_mask, uint64_t ones) {
+    for (; ones != 0; ones &= ones - 1) {
+      auto target = static_cast<uint64_t>(std::countr_zero(ones));
+      perm.apply_back(control_mask, target);
+      emit(control_mask, target);
+    }
+  };
+
+  REVSYNTH_COUNT(gates_first_row, static_cast<uint64_t>(std::popcount(perm[0])));
+  emit_ones(0, perm[0]);
+  REVSYNTH_COUNT(rows_processed, 1);
+  after_row(1UL);
+  for (auto i = 1UL; i < perm.length(); i++) {
+    auto row_i = perm[i];
+    REVSYNTH_COUNT(gates_01, static_cast<uint64_t>(std::popcount(~row_i & i)));
+    emit_ones(row_i, ~row_i & i);
+    row_i = perm[i];
+    REVSYNTH_COUNT(gates_10, static_cast<uint64_t>(std::popcount(row_i & ~i)));
+    emit_ones(row_i & i, row_i & ~i);
+    REVSYNTH_COUNT(rows_processed, 1);
+    after_row(i + 1);
+  }
+}
+
+auto mask_lines(uint64_t mask) -> std::vector<uint64_t> {
+  auto lines = std::vector<uint64_t>();
+  for (; mask != 0; mask &= mask - 1) {
+    lines.push_back(static_cast<uint64_t>(std::countr_zero(mask)));
+  }
+  return lines;
+}
+
+// Lines to flip, in order, taking value from down to the bottom value to of an open range that
+// ends at the top of an aligned block of rows, without leaving it: the ones below the highest
+// differing line are cleared first and the missing ones set while that line keeps the value above
+// to, which is cleared last. Values on the way stay below to | highest, inside the block.
+auto path_down(uint64_t from, uint64_t to) -> std::vector<uint64_t> {
+  auto lines = std::vector<uint64_t>();
+  if (from == to) {
+    return lines;
+  }
+  auto highest = std::bit_floor(from ^ to);
+  auto add = [&lines](uint64_t mask) {
+    for (; mask != 0; mask &= mask - 1) {
+      lines.push_back(static_cast<uint64_t>(std::countr_zero(mask)));
+    }
+  };
+  add(from & ~to & ~highest);
+  add(~from & to);
+  add(highest);
+  return lines;
+}
+
+// Mixed polarity Toffoli gate flipping line of value whose controls select no row outside
+// [lo, hi]: starting from every other line, controls are dropped from the lowest line up while
+// the smallest selected row, the positive controls alone, stays at least lo and the largest one,
+// every free line set, at most hi.
+auto range_gate(uint64_t bits_num, uint64_t value, uint64_t line, uint64_t lo, uint64_t hi)
+    -> gate {
+  auto lines = state::mask(bits_num);
+  auto control_mask = lines & ~(1UL << line);
+  for (auto l = 0UL; l < bits_num; l++) {
+    auto dropped = control_mask & ~(1UL << l);
+    auto polarity = value & dropped;
+    if (dropped != control_mask && polarity >= lo && (polarity | (lines & ~dropped)) <= hi) {
+      control_mask = dropped;
+    }
+  }
+  return gate(bits_num, mask_lines(control_mask), line).with_polarity(value & control_mask);
+}
+
+// Past the deadline the rows still open are fixed by transpositions, which apply no gate to the
+// table. The gates realise what is left of target_tt and, being self-inverse, are emitted last
+// first like the ones decided before them.
+auto finish_by_transpositions(const truth_table &target_tt, const gate_sink &emit,
+                              const synth_context &ctx, uint64_t gates_num) -> void {
+  auto patch = transposition_gates(target_tt, synth_context{.stop_token = ctx.stop_token});
+  for (auto it = patch.rbegin(); it != patch.rend(); it++) {
+    emit(*it);
+  }
+  ctx.report({target_tt.length(), target_tt.length(), gates_num + patch.size()});
+}
+
+} // namespace
+
+auto synthesize_rows_mixed(truth_table &target_tt, const gate_sink &emit,
+                           const synth_context &ctx) -> void {
+  REVSYNTH_SCOPE("mmd03/synthesize_rows_mixed");
+  auto bits_num = target_tt.size();
+  auto lines = state::mask(bits_num);
+  auto rows_num = target_tt.length();
+  auto gates_num = 0UL;
+  auto flip = [&](const gate &g, uint64_t value) {
+    if ((value & g.target_mask()) == 0) {
+      REVSYNTH_COUNT(gates_01, 1);
+    }
+    else {
+      REVSYNTH_COUNT(gates_10, 1);
+    }
+    g.apply_back(target_tt);
+    gates_num++;
+    emit(g);
+  };
+
+  // Rows below lo and above hi are fixed. The open range is kept so that hi is the top of the
+  // smallest aligned block of rows holding it, which keeps the path of every value down to lo
+  // inside the range, or lo is the bottom of that block, which does the same for hi as the bottom
+  // of the complemented range. Both ends are open when the range is a whole block, and the one
+  // whose row needs fewer gates is fixed; the upper one takes negative controls to spare the rows
+  // above hi.
+  auto lo = 0UL;
+  auto hi = rows_num - 1;
+  for (auto rows_fixed = 0UL; rows_fixed < rows_num;) {
+    ctx.throw_if_cancelled();
+    if (bits_num > small_perm::MAX_BITS && ctx.expired()) {
+      finish_by_transpositions(target_tt, emit, ctx, gates_num);
+      return;
+    }
+    auto block = std::bit_ceil((lo ^ hi) + 1);
+    auto bottom = lo & ~(block - 1);
+    auto low_open = hi == bottom + block - 1;
+    auto high_open = lo == bottom;
+    auto fix_low = low_open && (!high_open || std::popcount(target_tt[lo] ^ lo) <=
+                                                  std::popcount(target_tt[hi] ^ hi));
+    auto row = fix_low ? lo : hi;
+    auto value = target_tt[row];
+    auto path = fix_low ? path_down(value, lo) : path_down(~value & lines, ~hi & lines);
+    for (auto line : path) {
+      flip(range_gate(bits_num, value, line, lo, hi), value);
+      value ^= 1UL << line;
+    }
+
+    rows_fixed++;
+    if (fix_low) {
+      lo++;
+    }
+    else {
+      hi--;
+    }
+    REVSYNTH_COUNT(rows_processed, 1);
+    ctx.report({rows_fixed, rows_num, gates_num});
+  }
+}
+
+auto mmd03_small(small_perm target, std::array<small_gate, MMD03_SMALL_GATES_MAX> &gates)
+    -> uint64_t {
+  auto gates_num = 0UL;
+  auto emit = [&](uint64_t control_mask, uint64_t target_line) {
+    gates[gates_num++] = {static_cast<uint8_t>(control_mask), static_cast<uint8_t>(target_line)};
+  };
+  synthesize_rows_small(target, emit, [](uint64_t) {});
+  std::reverse(gates.begin(), gates.begin() + static_cast<std::ptrdiff_t>(gates_num));
+  return gates_num;
+}
+
+auto synthesize_rows(truth_table &target_tt, const gate_sink &emit, const synth_context &ctx)
+    -> void {
+  REVSYNTH_SCOPE("mmd03/synthesize_rows");
+  if (target_tt.size() <= small_perm::MAX_BITS) {
+    auto bits_num = target_tt.size();
+    auto perm = small_perm::from_table(target_tt);
+    auto gates_num = 0UL;
+    ctx.throw_if_cancelled();
+    synthesize_rows_small(
+        perm,
+        [&](uint64_t control_mask, uint64_t target) {
+          gates_num++;
+          emit(gate(bits_num, mask_lines(control_mask), target));
+        },
+        [&](uint64_t rows_fixed) {
+          ctx.report({rows_fixed, perm.length(), gates_num});
+          if (rows_fixed < perm.length()) {
+            ctx.throw_if_cancelled();
+          }
+        });
+    return;
+  }
+
+  auto rows_num = target_tt.length();
+  auto gates_num = 0UL;
+  auto counted_emit = [&](const gate &g) {
+    gates_num++;
+    emit(g);
+  };
+  ctx.throw_if_cancelled();
+  if (ctx.expired()) {
+    finish_by_transpositions(target_tt, emit, ctx, gates_num);
+    return;
+  }
+  synthesize_first_row(target_tt, counted_emit);
+  REVSYNTH_COUNT(rows_processed, 1);
+  ctx.report({1, rows_num, gates_num});
+  for (auto i = 1UL; i < rows_num; i++) {
+    ctx.throw_if_cancelled();
+    if (ctx.expired()) {
+      finish_by_transpositions(target_tt, emit, ctx, gates_num);
+      return;
+    }
+    synthesize_01_naive(target_tt, i, counted_emit);
+    synthesize_10_naive(target_tt, i, counted_emit);
+    REVSYNTH_COUNT(rows_processed, 1);
+    ctx.report({i + 1, rows_num, gates_num});
   }
-  return circ;
 }
 
 auto mmd03::synthesize(truth_table target_tt) const -> circuit {
-  auto circ = synthesize_first_row(target_tt);
-  for (auto i = 1UL; i < target_tt.size(); i++) {
-    auto pre_circ_01 = synthesize_01_naive(target_tt, i);
-    auto pre_circ_10 = synthesize_10_naive(target_tt, i);
-    circ.push_front(pre_circ_01);
-    circ.push_front(pre_circ_10);
-  }
-  return circ;
+  return synthesize(std::move(target_tt), synth_context());
+}
+
+auto mmd03::synthesize(truth_table target_tt, const synth_context &ctx) const -> circuit {
+  REVSYNTH_SCOPE("mmd03/synthesize");
+  auto bits_num = target_tt.size();
+  auto gates = std::deque<gate>();
+  auto emit = [&gates](const gate &g) { gates.push_front(g); };
+  if (sm_ == synth_mode::mixed) {
+    synthesize_rows_mixed(target_tt, emit, ctx);
+  }
+  else {
+    synthesize_rows(target_tt, emit, ctx);
+  }
+  return {bits_num, std::move(gates)};
+}
+
+auto mmd03::stream(truth_table target_tt, const gate_sink &sink, const synth_context &ctx) const
+    -> void {
+  // Gates are decided from the output side, so the first gate decided is the last one of the
+  // circuit. Synthesising the inverse function and emitting in decision order yields the gates
+  // of the target circuit front to back, as every gate is self-inverse.
+  REVSYNTH_SCOPE("mmd03/stream");
+  target_tt.inverse();
+  if (sm_ == synth_mode::mixed) {
+    synthesize_rows_mixed(target_tt, sink, ctx);
+  }
+  else {
+    synthesize_rows(target_tt, sink, ctx);
+  }
 }
 
 // auto mmd03::synthesize2(truth_table target_tt) -> circuit {
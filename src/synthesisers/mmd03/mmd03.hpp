@@ -1,13 +1,39 @@
 #pragma once
 #include "circuit/circuit.hpp"
+#include "small_perm/small_perm.hpp"
 #include "synthesisers/synthesiser.hpp"
+#include <array>
 
+// Past the deadline of the synthesis context the rows still open are fixed by the transpositions
+// of delta_resynth, which skip the table pass of every gate but give longer circuits. Tables of up
+// to small_perm::MAX_BITS lines always finish as usual.
 class mmd03 : public synthesiser {
-  enum class synth_mode { naive, reduce_cl };
+public:
+  // mixed fixes rows from both ends of the table, the cheaper one whenever the open range is a
+  // whole aligned block of rows. Rows above the open range are protected by negative controls, and
+  // every control the range can do without is dropped, which gives shorter circuits with fewer
+  // controls than naive.
+  enum class synth_mode { naive, reduce_cl, mixed };
+
+private:
   synth_mode sm_;
 
 public:
   mmd03(synth_mode sm = synth_mode::naive);
 
+  [[nodiscard]] auto name() const -> std::string;
+
+  using synthesiser::synthesize;
   auto synthesize(truth_table target_tt) const -> circuit;
+  auto synthesize(truth_table target_tt, const synth_context &ctx) const -> circuit;
+  using synthesiser::stream;
+  auto stream(truth_table target_tt, const gate_sink &sink, const synth_context &ctx) const
+      -> void;
 };
+
+// Naive mmd03 on at most small_perm::MAX_BITS lines without allocating: writes the gates in
+// circuit order and returns their number. Tables of up to 4 lines passed to mmd03 take the same
+// path internally.
+const auto MMD03_SMALL_GATES_MAX = small_perm::MAX_BITS << small_perm::MAX_BITS;
+auto mmd03_small(small_perm target, std::array<small_gate, MMD03_SMALL_GATES_MAX> &gates)
+    -> uint64_t;
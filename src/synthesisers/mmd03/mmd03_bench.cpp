@@ -0,0 +1,42 @@
+#include "bench/bench.hpp"
+#include "memory/memory.hpp"
+#include "mmd03.hpp"
+#include <random>
+
+namespace mmd03_bench {
+std::mt19937_64 mrnd;
+} // namespace mmd03_bench
+
+using namespace mmd03_bench;
+
+REVSYNTH_BENCH("mmd03/synthesize", 3, 16) {
+  auto bits = state.bits_num();
+  auto synth = mmd03();
+  auto target = truth_table(bits).shuffle(mrnd);
+  state.run(target.length(), [&]() { do_not_optimize(synth.synthesize(target)); });
+}
+
+REVSYNTH_BENCH("mmd03/synthesize_mixed", 3, 16) {
+  auto bits = state.bits_num();
+  auto synth = mmd03(mmd03::synth_mode::mixed);
+  auto target = truth_table(bits).shuffle(mrnd);
+  state.run(target.length(), [&]() { do_not_optimize(synth.synthesize(target)); });
+}
+
+REVSYNTH_BENCH("mmd03/synthesize_arena", 3, 16) {
+  auto bits = state.bits_num();
+  auto synth = mmd03();
+  auto target = truth_table(bits).shuffle(mrnd);
+  auto stats = arena_stats();
+  state.run(target.length(), [&]() {
+    do_not_optimize(with_arena([&]() { return synth.synthesize(target); }, &stats));
+  });
+  state.set_counter("arena_bytes", static_cast<double>(stats.arena_bytes));
+}
+
+REVSYNTH_BENCH("mmd03/small", 1, 4) {
+  auto bits = state.bits_num();
+  auto target = small_perm::from_table(truth_table(bits).shuffle(mrnd));
+  auto gates = std::array<small_gate, MMD03_SMALL_GATES_MAX>();
+  state.run(target.length(), [&]() { do_not_optimize(mmd03_small(target, gates)); });
+}
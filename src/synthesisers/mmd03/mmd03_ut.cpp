@@ -1,4 +1,5 @@
 #include "mmd03.hpp"
+#include "synthesisers/delta_resynth/delta_resynth.hpp"
 #include <catch2/catch_all.hpp>
 #include <catch2/catch_message.hpp>
 #include <random>
@@ -23,6 +24,87 @@ TEST_CASE("mmd03", "[mmd03]") {
   REQUIRE(synth.output_tt() == target_tt);
 }
 
+TEST_CASE("mmd03 with synthesis context", "[mmd03], [context]") {
+  auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto target_tt = truth_table(bits);
+  target_tt.shuffle(mrnd);
+  auto tested = mmd03();
+
+  SECTION("progress") {
+    auto reports = std::vector<synth_progress>();
+    auto ctx = synth_context{.on_progress = [&](auto &p) { reports.push_back(p); }};
+    auto synth = tested.synthesize(target_tt, ctx);
+    REQUIRE(synth.output_tt() == target_tt);
+    REQUIRE(reports.size() == target_tt.length());
+    for (auto i = 0UL; i < reports.size(); i++) {
+      REQUIRE(reports[i].rows_fixed == i + 1);
+      REQUIRE(reports[i].rows_num == target_tt.length());
+    }
+    REQUIRE(reports.back().gates_num == synth.gates_num());
+  }
+
+  SECTION("cancellation") {
+    auto source = std::stop_source();
+    auto ctx = synth_context{.stop_token = source.get_token(),
+                             .on_progress = [&](auto &) { source.request_stop(); }};
+    REQUIRE_THROWS_AS(tested.synthesize(target_tt, ctx), synthesis_cancelled);
+  }
+
+  SECTION("expired deadline") {
+    auto mode = GENERATE(mmd03::synth_mode::naive, mmd03::synth_mode::mixed);
+    auto ctx = synth_context{.deadline = synth_context::clock::now()};
+    auto synth = mmd03(mode).synthesize(target_tt, ctx);
+    REQUIRE(synth.output_tt() == target_tt);
+    if (bits <= small_perm::MAX_BITS) {
+      REQUIRE(synth == mmd03(mode).synthesize(target_tt));
+    }
+    else {
+      // every row finished by transpositions of fully controlled gates
+      REQUIRE(synth.gates() == transposition_gates(target_tt));
+    }
+
+    auto streamed = circuit(bits);
+    mmd03(mode).stream(target_tt, [&](const gate &g) { streamed.push_back(g); }, ctx);
+    REQUIRE(streamed.output_tt() == target_tt);
+  }
+
+  SECTION("deadline passing midway") {
+    auto mode = GENERATE(mmd03::synth_mode::naive, mmd03::synth_mode::mixed);
+    auto ctx = synth_context{};
+    ctx.on_progress = [&](const synth_progress &p) {
+      if (p.rows_fixed == p.rows_num / 2) {
+        ctx.deadline = synth_context::clock::now();
+      }
+    };
+    auto synth = mmd03(mode).synthesize(target_tt, ctx);
+    REQUIRE(synth.output_tt() == target_tt);
+  }
+}
+
+TEST_CASE("mmd03 streaming", "[mmd03], [stream]") {
+  auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto target_tt = truth_table(bits);
+  target_tt.shuffle(mrnd);
+  auto tested = mmd03();
+
+  auto streamed = circuit(bits);
+  auto rows_fixed = 0UL;
+  auto rows_fixed_at_first_gate = target_tt.length();
+  auto sink = [&](const gate &g) {
+    rows_fixed_at_first_gate = std::min(rows_fixed_at_first_gate, rows_fixed);
+    streamed.push_back(g);
+  };
+  auto ctx = synth_context{.on_progress = [&](auto &p) { rows_fixed = p.rows_fixed; }};
+  tested.stream(target_tt, sink, ctx);
+  REQUIRE(streamed.output_tt() == target_tt);
+  REQUIRE(streamed.gates_num() == tested.synthesize(target_tt.inverse()).gates_num());
+  if (streamed.gates_num() > 0) {
+    REQUIRE(rows_fixed_at_first_gate < target_tt.length() - 1);
+  }
+}
+
 TEST_CASE("paper experimental results for base algorithm", "[mmd03], [paper]") {
   auto bits = 3UL;
   auto target_tt = truth_table(bits);
@@ -40,6 +122,44 @@ TEST_CASE("paper experimental results for base algorithm", "[mmd03], [paper]") {
   REQUIRE(gc_histogram == expected_gc_histogram);
 }
 
+TEST_CASE("mmd03 mixed polarity mode", "[mmd03], [polarity]") {
+  auto tested = mmd03(mmd03::synth_mode::mixed);
+  REQUIRE(tested.name() == "mmd03/mixed");
+
+  SECTION("every function on 3 lines") {
+    auto target_tt = truth_table(3);
+    auto naive = cost_vector();
+    auto mixed = cost_vector();
+    do {
+      auto circ = tested.synthesize(target_tt);
+      REQUIRE(circ.output_tt() == target_tt);
+      mixed += circ.cost();
+      naive += mmd03().synthesize(target_tt).cost();
+    } while (target_tt.next_permutation());
+    WARN("naive " << naive.gates << " gates, " << naive.controls << " controls, mixed "
+                  << mixed.gates << " gates, " << mixed.controls << " controls");
+    REQUIRE(mixed.gates < naive.gates);
+    REQUIRE(mixed.controls < naive.controls);
+  }
+
+  SECTION("random functions") {
+    auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+    auto target_tt = truth_table(bits);
+    target_tt.shuffle(mrnd);
+
+    auto reports = std::vector<synth_progress>();
+    auto ctx = synth_context{.on_progress = [&](auto &p) { reports.push_back(p); }};
+    auto circ = tested.synthesize(target_tt, ctx);
+    REQUIRE(circ.output_tt() == target_tt);
+    REQUIRE(reports.size() == target_tt.length());
+    REQUIRE(reports.back().gates_num == circ.gates_num());
+
+    auto streamed = circuit(bits);
+    tested.stream(target_tt, [&](const gate &g) { streamed.push_back(g); }, {});
+    REQUIRE(streamed.output_tt() == target_tt);
+  }
+}
+
 // auto circ_nums =
 //     std::accumulate(gc_histogram.begin(), gc_histogram.end(), 0.0);
 // auto average_gc = static_cast<double>(gc_sum) / circ_nums;
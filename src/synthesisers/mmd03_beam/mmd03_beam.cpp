@@ -0,0 +1,215 @@
+#include "mmd03_beam.hpp"
+#include "parallel/parallel.hpp"
+#include <algorithm>
+#include <bit>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Persistent singly linked list of gates, newest first. Children of a beam node share the
+// whole history of their parent and only prepend the gates of the row they fix.
+struct gate_node {
+  gate value;
+  std::shared_ptr<const gate_node> next;
+};
+using gate_list = std::shared_ptr<const gate_node>;
+
+enum class side { output, input };
+
+struct beam_node {
+  // Copy-on-write working table: children that emit no gates keep the parent table.
+  std::shared_ptr<const truth_table> tt;
+  gate_list input_gates;
+  gate_list output_gates;
+  uint64_t gates_num = 0;
+  uint64_t controls_num = 0;
+  uint64_t bound = 0;
+
+  [[nodiscard]] auto score() const -> uint64_t { return gates_num + bound; }
+};
+
+auto is_better(const beam_node &lhs, const beam_node &rhs) -> bool {
+  if (lhs.score() != rhs.score()) {
+    return lhs.score() < rhs.score();
+  }
+  return lhs.controls_num < rhs.controls_num;
+}
+
+// Smallest greedy submask of candidate that is still not smaller than i, so the gate never
+// touches rows 0..i-1 which are already fixed.
+auto reduced_controls(uint64_t candidate, uint64_t i) -> uint64_t {
+  auto controls = candidate;
+  for (auto bit = 1UL; bit != 0 && bit <= candidate; bit <<= 1) {
+    if ((controls & bit) != 0 && (controls & ~bit) >= i) {
+      controls &= ~bit;
+    }
+  }
+  return controls;
+}
+
+auto mask_to_lines(uint64_t mask) -> std::vector<uint64_t> {
+  auto lines = std::vector<uint64_t>();
+  for (; mask != 0; mask &= mask - 1) {
+    lines.push_back(static_cast<uint64_t>(std::countr_zero(mask)));
+  }
+  return lines;
+}
+
+auto find_row(const truth_table &tt, uint64_t value, uint64_t from) -> uint64_t {
+  for (auto index = from; index < tt.length(); index++) {
+    if (tt[index] == value) {
+      return index;
+    }
+  }
+  return from;
+}
+
+// Gates which move value i to row i. On the output side the value stored in row i is
+// transformed into i, on the input side the row index holding value i is.
+auto row_gates(const truth_table &tt, uint64_t i, side s, bool reduce) -> std::vector<gate> {
+  auto bits_num = tt.size();
+  auto current = s == side::output ? tt[i] : find_row(tt, i, i);
+  auto gates = std::vector<gate>();
+
+  auto zero_to_one_mask = ~current & i;
+  auto naive_controls = current;
+  for (auto id : mask_to_lines(zero_to_one_mask)) {
+    auto controls = reduce ? reduced_controls(current, i) : naive_controls;
+    gates.emplace_back(bits_num, mask_to_lines(controls), id);
+    current |= 1UL << id;
+  }
+
+  auto one_to_zero_mask = current & ~i;
+  auto correct_ones_mask = current & i;
+  for (auto id : mask_to_lines(one_to_zero_mask)) {
+    auto target_mask = 1UL << id;
+    auto controls = reduce ? reduced_controls(current & ~target_mask, i) : correct_ones_mask;
+    gates.emplace_back(bits_num, mask_to_lines(controls), id);
+    current &= ~target_mask;
+  }
+  return gates;
+}
+
+// Cheap lower bound on gates needed for the next row.
+auto next_row_bound(const truth_table &tt, uint64_t i) -> uint64_t {
+  auto next = i + 1;
+  if (next >= tt.length()) {
+    return 0;
+  }
+  auto output_distance = std::popcount(tt[next] ^ next);
+  auto input_distance = std::popcount(find_row(tt, next, next) ^ next);
+  return static_cast<uint64_t>(std::min(output_distance, input_distance));
+}
+
+auto expand(const beam_node &parent, uint64_t i) -> std::vector<beam_node> {
+  auto children = std::vector<beam_node>();
+  auto emitted = std::vector<std::vector<gate>>();
+
+  for (auto s : {side::output, side::input}) {
+    for (auto reduce : {false, true}) {
+      auto gates = row_gates(*parent.tt, i, s, reduce);
+      if (std::find(emitted.begin(), emitted.end(), gates) != emitted.end()) {
+        continue;
+      }
+      emitted.push_back(gates);
+
+      auto child = parent;
+      if (!gates.empty()) {
+        auto tt = std::make_shared<truth_table>(*parent.tt);
+        auto &list = s == side::output ? child.output_gates : child.input_gates;
+        for (auto &g : gates) {
+          if (s == side::output) {
+            g.apply_back(*tt);
+          }
+          else {
+            g.apply_front(*tt);
+          }
+          list = std::make_shared<const gate_node>(gate_node{g, list});
+          child.controls_num += g.controls_num();
+        }
+        child.gates_num += gates.size();
+        child.tt = std::move(tt);
+      }
+      child.bound = next_row_bound(*child.tt, i);
+      children.push_back(std::move(child));
+
+      if (gates.empty()) {
+        return children; // row already fixed, other variants are identical
+      }
+    }
+  }
+  return children;
+}
+
+auto to_circuit(const beam_node &node, uint64_t bits_num) -> circuit {
+  auto gates = std::deque<gate>();
+  for (auto it = node.output_gates; it != nullptr; it = it->next) {
+    gates.push_back(it->value);
+  }
+  for (auto it = node.input_gates; it != nullptr; it = it->next) {
+    gates.push_front(it->value);
+  }
+  return {bits_num, std::move(gates)};
+}
+
+} // namespace
+
+mmd03_beam::mmd03_beam() : opts_() {}
+
+mmd03_beam::mmd03_beam(beam_options opts) : opts_(opts) {}
+
+auto mmd03_beam::options() const -> const beam_options & { return opts_; }
+
+auto mmd03_beam::name() const -> std::string {
+  auto name = std::string("mmd03_beam/").append(std::to_string(opts_.beam_width));
+  if (opts_.time_budget != std::chrono::milliseconds::max()) {
+    name.append("/").append(std::to_string(opts_.time_budget.count())).append("ms");
+  }
+  return name;
+}
+
+auto mmd03_beam::synthesize(truth_table target_tt) const -> circuit {
+  return synthesize(std::move(target_tt), synth_context());
+}
+
+auto mmd03_beam::synthesize(truth_table target_tt, const synth_context &ctx) const -> circuit {
+  using clock = std::chrono::steady_clock;
+  auto start = clock::now();
+  auto budget_left = [&]() {
+    return !ctx.expired() && std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 clock::now() - start) < opts_.time_budget;
+  };
+
+  auto bits_num = target_tt.size();
+  auto rows_num = target_tt.length();
+  auto beam = std::vector<beam_node>(1);
+  beam.front().tt = std::make_shared<const truth_table>(std::move(target_tt));
+
+  for (auto i = 0UL; i < rows_num; i++) {
+    ctx.throw_if_cancelled();
+    auto width = budget_left() ? std::max(1UL, opts_.beam_width) : 1UL;
+    if (beam.size() > width) {
+      beam.resize(width);
+    }
+
+    auto expansions = std::vector<std::vector<beam_node>>(beam.size());
+    parallel_for(0UL, beam.size(), opts_.threads_num,
+                 [&](auto b) { expansions[b] = expand(beam[b], i); });
+
+    auto next_beam = std::vector<beam_node>();
+    for (auto &children : expansions) {
+      std::move(children.begin(), children.end(), std::back_inserter(next_beam));
+    }
+    auto kept = std::min(width, next_beam.size());
+    std::partial_sort(next_beam.begin(), next_beam.begin() + static_cast<std::ptrdiff_t>(kept),
+                      next_beam.end(), is_better);
+    next_beam.resize(kept);
+    beam = std::move(next_beam);
+    ctx.report({i + 1, rows_num, beam.front().gates_num});
+  }
+
+  auto best = std::min_element(beam.begin(), beam.end(), is_better);
+  return to_circuit(*best, bits_num);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "synthesisers/synthesiser.hpp"
+#include <chrono>
+#include <cstdint>
+
+struct beam_options {
+  uint64_t beam_width = 8;
+  std::chrono::milliseconds time_budget = std::chrono::milliseconds::max();
+  uint64_t threads_num = 0; // 0 - use all hardware threads
+};
+
+// Beam search over the row-by-row MMD transformation. Every row is fixed either on the output
+// side or on the input side of the working table, with full or reduced controls, and the
+// beam_width cheapest partial results are kept. After time_budget the beam collapses to the
+// single best partial result, which is then finished greedily. The same happens when the
+// deadline of the synthesis context passes.
+class mmd03_beam : public synthesiser {
+  beam_options opts_;
+
+public:
+  mmd03_beam();
+  explicit mmd03_beam(beam_options opts);
+
+  [[nodiscard]] auto options() const -> const beam_options &;
+  [[nodiscard]] auto name() const -> std::string;
+
+  using synthesiser::synthesize;
+  auto synthesize(truth_table target_tt) const -> circuit;
+  auto synthesize(truth_table target_tt, const synth_context &ctx) const -> circuit;
+};
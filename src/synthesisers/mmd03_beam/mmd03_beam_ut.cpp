@@ -0,0 +1,77 @@
+#include "mmd03_beam.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <random>
+
+namespace mmd03_beam_ut {
+const auto EPOCHS = 100;
+const auto max_bits = 8;
+const auto max_width = 16;
+std::mt19937_64 mrnd;
+} // namespace mmd03_beam_ut
+
+using namespace mmd03_beam_ut;
+
+TEST_CASE("mmd03_beam", "[mmd03_beam]") {
+  auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+  auto width = static_cast<uint64_t>(GENERATE(take(1, random(1, max_width))));
+
+  auto target_tt = truth_table(bits);
+  target_tt.shuffle(mrnd);
+  auto tested = mmd03_beam({.beam_width = width, .threads_num = 1 + mrnd() % 4});
+  auto synth = tested.synthesize(target_tt);
+  REQUIRE(synth.output_tt() == target_tt);
+}
+
+TEST_CASE("mmd03_beam with exhausted time budget", "[mmd03_beam]") {
+  auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto target_tt = truth_table(bits);
+  target_tt.shuffle(mrnd);
+  auto tested = mmd03_beam({.time_budget = std::chrono::milliseconds(0)});
+  auto synth = tested.synthesize(target_tt);
+  REQUIRE(synth.output_tt() == target_tt);
+  REQUIRE(tested.name() == "mmd03_beam/8/0ms");
+  REQUIRE(mmd03_beam().name() == "mmd03_beam/8");
+}
+
+TEST_CASE("mmd03_beam with synthesis context", "[mmd03_beam], [context]") {
+  auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(2, max_bits))));
+
+  auto target_tt = truth_table(bits);
+  target_tt.shuffle(mrnd);
+  auto tested = mmd03_beam();
+
+  SECTION("expired deadline falls back to greedy completion") {
+    auto ctx = synth_context{.deadline = synth_context::clock::now()};
+    auto synth = tested.synthesize(target_tt, ctx);
+    REQUIRE(synth.output_tt() == target_tt);
+  }
+
+  SECTION("cancellation") {
+    auto source = std::stop_source();
+    auto rows_fixed = 0UL;
+    auto ctx = synth_context{.stop_token = source.get_token(), .on_progress = [&](auto &p) {
+                               rows_fixed = p.rows_fixed;
+                               source.request_stop();
+                             }};
+    REQUIRE_THROWS_AS(tested.synthesize(target_tt, ctx), synthesis_cancelled);
+    REQUIRE(rows_fixed == 1UL);
+  }
+}
+
+TEST_CASE("mmd03_beam is not worse than mmd03 on 3 bits", "[mmd03_beam], [paper]") {
+  auto target_tt = truth_table(3);
+  auto beam_gc_sum = 0UL;
+  auto base_gc_sum = 0UL;
+  auto tested = mmd03_beam({.beam_width = 4});
+  auto base = mmd03();
+  do {
+    auto circ = tested.synthesize(target_tt);
+    REQUIRE(circ.output_tt() == target_tt);
+    beam_gc_sum += circ.gates_num();
+    base_gc_sum += base.synthesize(target_tt).gates_num();
+  } while (target_tt.next_permutation());
+  REQUIRE(beam_gc_sum < base_gc_sum);
+}
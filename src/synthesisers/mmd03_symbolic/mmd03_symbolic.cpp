@@ -0,0 +1,64 @@
+#include "mmd03_symbolic.hpp"
+#include "instrument/instrument.hpp"
+#include "state/state.hpp"
+#include "synthesisers/delta_resynth/delta_resynth.hpp"
+#include <bit>
+#include <limits>
+
+auto mmd03_symbolic::name() const -> std::string { return "mmd03/symbolic"; }
+
+auto mmd03_symbolic::synthesize(truth_table target_tt) const -> circuit {
+  return synthesize(std::move(target_tt), synth_context());
+}
+
+auto mmd03_symbolic::synthesize(truth_table target_tt, const synth_context &ctx) const
+    -> circuit {
+  REVSYNTH_SCOPE("mmd03_symbolic/synthesize");
+  auto bits_num = target_tt.size();
+  auto manager = bdd_manager(bits_num);
+  auto target = bdd_function(manager, target_tt);
+  auto gates = synthesize_gates(target, ctx);
+  if (!target.is_identity()) {
+    // past the deadline, the rows left are fixed by transpositions without diagram operations
+    auto patch =
+        transposition_gates(target.to_table(), synth_context{.stop_token = ctx.stop_token});
+    gates.insert(gates.begin(), patch.begin(), patch.end());
+    ctx.report({target_tt.length(), target_tt.length(), gates.size()});
+  }
+  return {bits_num, std::move(gates)};
+}
+
+auto mmd03_symbolic::synthesize_gates(bdd_function &target, const synth_context &ctx) const
+    -> std::deque<gate> {
+  const auto bits_num = target.bits_num();
+  const auto rows_num =
+      bits_num < state::MAX_SIZE ? 1UL << bits_num : std::numeric_limits<uint64_t>::max();
+  auto gates = std::deque<gate>();
+  auto emit_ones = [&](uint64_t control_mask, uint64_t ones) {
+    auto controls = state(bits_num, control_mask).ones();
+    for (auto target_line : state(bits_num, ones).ones()) {
+      auto g = gate(bits_num, controls, target_line);
+      target.apply_back(g);
+      gates.push_front(std::move(g));
+    }
+  };
+
+  // the 01 and 10 steps of mmd03, row 0 included, where they reduce to the first row step
+  for (auto row = target.first_moved_row(); row; row = target.first_moved_row()) {
+    ctx.throw_if_cancelled();
+    if (ctx.expired()) {
+      return gates;
+    }
+    auto i = *row;
+    auto row_i = target.apply(i);
+    REVSYNTH_COUNT(gates_01, static_cast<uint64_t>(std::popcount(~row_i & i)));
+    emit_ones(row_i, ~row_i & i);
+    row_i = target.apply(i);
+    REVSYNTH_COUNT(gates_10, static_cast<uint64_t>(std::popcount(row_i & ~i)));
+    emit_ones(row_i & i, row_i & ~i);
+    REVSYNTH_COUNT(rows_processed, 1);
+    ctx.report({i + 1, rows_num, gates.size()});
+  }
+  ctx.report({rows_num, rows_num, gates.size()});
+  return gates;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "circuit/circuit.hpp"
+#include "decision_diagram/decision_diagram.hpp"
+#include "synthesisers/synthesiser.hpp"
+#include <deque>
+
+// Naive mmd03 on the decision diagrams of the target instead of its table. Rows the function
+// already fixes are skipped by searching the diagrams for the first moved row, so the work
+// follows the number of moved rows and the diagram sizes rather than 2^bits_num. Yields the same
+// circuits as mmd03() unless the deadline of the synthesis context passes, after which the rows
+// left are fixed by the transpositions of delta_resynth on the table of what remains.
+class mmd03_symbolic : public synthesiser {
+public:
+  [[nodiscard]] auto name() const -> std::string;
+
+  using synthesiser::synthesize;
+  auto synthesize(truth_table target_tt) const -> circuit;
+  auto synthesize(truth_table target_tt, const synth_context &ctx) const -> circuit;
+  // Gates in circuit order for a target on any number of lines. target is reduced to the
+  // identity on the way, or past the deadline to the rows still moved, left to the caller.
+  auto synthesize_gates(bdd_function &target, const synth_context &ctx = {}) const
+      -> std::deque<gate>;
+};
@@ -0,0 +1,64 @@
+#include "mmd03_symbolic.hpp"
+#include "synthesisers/mmd03/mmd03.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <random>
+
+namespace mmd03_symbolic_ut {
+const auto EPOCHS = 100;
+const auto max_bits = 10;
+std::mt19937_64 mrnd;
+} // namespace mmd03_symbolic_ut
+
+using namespace mmd03_symbolic_ut;
+
+TEST_CASE("mmd03_symbolic matches mmd03", "[mmd03_symbolic]") {
+  auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(1, max_bits))));
+
+  auto target_tt = truth_table(bits).shuffle(mrnd);
+  auto synth = mmd03_symbolic().synthesize(target_tt);
+  REQUIRE(synth.output_tt() == target_tt);
+  REQUIRE(synth == mmd03().synthesize(target_tt));
+}
+
+TEST_CASE("mmd03_symbolic with synthesis context", "[mmd03_symbolic], [context]") {
+  auto bits = static_cast<uint64_t>(GENERATE(take(EPOCHS, random(2, max_bits))));
+
+  // a single moved row, fixed by one gate
+  auto target_tt = truth_table(bits);
+  target_tt.swap(target_tt.length() - 2, target_tt.length() - 1);
+  auto reports = std::vector<synth_progress>();
+  auto ctx = synth_context{.on_progress = [&](auto &p) { reports.push_back(p); }};
+  auto synth = mmd03_symbolic().synthesize(target_tt, ctx);
+  REQUIRE(synth.output_tt() == target_tt);
+  REQUIRE(synth.gates_num() == 1);
+  REQUIRE(reports.size() == 2);
+  REQUIRE(reports.back().rows_fixed == target_tt.length());
+  REQUIRE(reports.back().gates_num == synth.gates_num());
+
+  auto source = std::stop_source();
+  source.request_stop();
+  auto cancelled = synth_context{.stop_token = source.get_token()};
+  REQUIRE_THROWS_AS(mmd03_symbolic().synthesize(target_tt, cancelled), synthesis_cancelled);
+
+  auto expired = synth_context{.deadline = synth_context::clock::now()};
+  auto shuffled = truth_table(bits).shuffle(mrnd);
+  REQUIRE(mmd03_symbolic().synthesize(shuffled, expired).output_tt() == shuffled);
+  auto manager = bdd_manager(bits);
+  auto target = bdd_function(manager, shuffled);
+  REQUIRE(mmd03_symbolic().synthesize_gates(target, expired).empty());
+  REQUIRE(target.to_table() == shuffled);
+}
+
+TEST_CASE("mmd03_symbolic beyond truth tables", "[mmd03_symbolic]") {
+  const auto bits = 48UL;
+  auto manager = bdd_manager(bits);
+  auto target = bdd_function(manager);
+  target.apply_back(gate(bits, {0, 1, 40}, 47));
+  target.apply_back(gate(bits, {}, 3));
+  auto expected = target;
+
+  auto gates = mmd03_symbolic().synthesize_gates(target);
+  REQUIRE(target.is_identity());
+  REQUIRE(bdd_function(manager, gates) == expected);
+}
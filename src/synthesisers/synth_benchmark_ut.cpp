@@ -1,4 +1,5 @@
 #include "mmd03/mmd03.hpp"
+#include "mmd03_beam/mmd03_beam.hpp"
 #include <algorithm>
 #include <catch2/catch_all.hpp>
 #include <catch2/catch_message.hpp>
@@ -79,6 +80,13 @@ TEST_CASE("Full 3 bit benchmark", "[benchmark]") {
     std::cout << "  Average GC: " << gc << std::endl;
     std::cout << "  Average CL: " << cl << std::endl;
   }
+  SECTION("beam mmd03") {
+    std::cout << " Beam MMD03" << std::endl;
+    auto tested = mmd03_beam();
+    auto [gc, cl] = benchmark_full_3bit(tested);
+    std::cout << "  Average GC: " << gc << std::endl;
+    std::cout << "  Average CL: " << cl << std::endl;
+  }
   std::cout << std::endl;
 }
 
@@ -95,5 +103,12 @@ TEST_CASE("Sample 4 bit benchmark", "[benchmark], [sample], [4bit]") {
     std::cout << "  Average GC: " << gc << std::endl;
     std::cout << "  Average CL: " << cl << std::endl;
   }
+  SECTION("beam mmd03") {
+    std::cout << " Beam MMD03" << std::endl;
+    auto tested = mmd03_beam();
+    auto [gc, cl] = benchmark_sample(tested, sample);
+    std::cout << "  Average GC: " << gc << std::endl;
+    std::cout << "  Average CL: " << cl << std::endl;
+  }
   std::cout << std::endl;
 }
@@ -0,0 +1,38 @@
+#include "synthesiser.hpp"
+
+synthesis_cancelled::synthesis_cancelled() : std::runtime_error("Synthesis has been cancelled") {}
+
+auto synth_context::expired() const -> bool { return clock::now() >= deadline; }
+
+auto synth_context::cancelled() const -> bool { return stop_token.stop_requested(); }
+
+auto synth_context::throw_if_cancelled() const -> void {
+  if (cancelled()) {
+    throw synthesis_cancelled();
+  }
+}
+
+auto synth_context::report(const synth_progress &progress) const -> void {
+  if (on_progress) {
+    on_progress(progress);
+  }
+}
+
+auto synthesiser::synthesize(truth_table target_tt, const synth_context &ctx) const -> circuit {
+  ctx.throw_if_cancelled();
+  auto rows_num = target_tt.length();
+  auto circ = synthesize(std::move(target_tt));
+  ctx.report({rows_num, rows_num, circ.gates_num()});
+  return circ;
+}
+
+auto synthesiser::stream(truth_table target_tt, const gate_sink &sink,
+                         const synth_context &ctx) const -> void {
+  for (const auto &g : synthesize(std::move(target_tt), ctx).gates()) {
+    sink(g);
+  }
+}
+
+auto synthesiser::stream(truth_table target_tt, const gate_sink &sink) const -> void {
+  stream(std::move(target_tt), sink, synth_context());
+}
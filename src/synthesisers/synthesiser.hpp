@@ -1,8 +1,51 @@
+#pragma once
 #include "circuit/circuit.hpp"
 #include "truth_table/truth_table.hpp"
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+
+using gate_sink = std::function<void(const gate &)>;
+
+struct synth_progress {
+  uint64_t rows_fixed;
+  uint64_t rows_num;
+  uint64_t gates_num;
+};
+
+class synthesis_cancelled : public std::runtime_error {
+public:
+  synthesis_cancelled();
+};
+
+struct synth_context {
+  using clock = std::chrono::steady_clock;
+
+  clock::time_point deadline = clock::time_point::max();
+  std::stop_token stop_token{};
+  std::function<void(const synth_progress &)> on_progress{};
+
+  [[nodiscard]] auto expired() const -> bool;
+  [[nodiscard]] auto cancelled() const -> bool;
+  auto throw_if_cancelled() const -> void;
+  auto report(const synth_progress &progress) const -> void;
+};
 
 class synthesiser {
 public:
   synthesiser() = default;
+  virtual ~synthesiser() = default;
+  // Identifies the engine and every option that changes its results.
+  [[nodiscard]] virtual auto name() const -> std::string = 0;
   virtual auto synthesize(truth_table target_tt) const -> circuit = 0;
+  // Synthesis bounded by ctx: after the deadline engines finish in their cheapest mode, and a
+  // stop request aborts with synthesis_cancelled.
+  virtual auto synthesize(truth_table target_tt, const synth_context &ctx) const -> circuit;
+  // Passes the gates of the synthesised circuit to sink front to back. Engines that can decide
+  // gates in circuit order emit them as they go, without keeping the circuit in memory.
+  virtual auto stream(truth_table target_tt, const gate_sink &sink, const synth_context &ctx) const
+      -> void;
+  auto stream(truth_table target_tt, const gate_sink &sink) const -> void;
 };
@@ -1,15 +1,57 @@
 #include "truth_table.hpp"
+#include "instrument/instrument.hpp"
+#include "parallel/parallel.hpp"
 #include "state/state.hpp"
+#include <algorithm>
 #include <cassert>
 #include <numeric>
 #include <random>
 #include <stdexcept>
 #include <sys/types.h>
 
+namespace {
+
+// Rows per task when a large table is filled in parallel: one huge page, so every page is
+// first touched by a single thread.
+const auto FILL_CHUNK_ROWS = HUGE_PAGE_SIZE / sizeof(uint64_t);
+
+// Runs fill(begin, end) over all rows, chunk-parallel for large tables.
+template <typename Fill> auto fill_rows(uint64_t length, Fill &&fill) -> void {
+  if (!parallel_table(length)) {
+    fill(0UL, length);
+    return;
+  }
+  parallel_for_chunks(0, length, FILL_CHUNK_ROWS, 0, fill);
+}
+
+} // namespace
+
 truth_table::truth_table(uint64_t bits_num)
-    : _size(state::check_size(bits_num)), _mask(state::mask(bits_num)) {
-  _data = std::vector<uint64_t>(1UL << bits_num);
-  std::iota(_data.begin(), _data.end(), 0);
+    : _size(state::check_size(bits_num)), _mask(state::mask(bits_num)),
+      _data(1UL << bits_num, table_resource(1UL << bits_num)) {
+  fill_rows(_data.size(), [this](uint64_t begin, uint64_t end) {
+    std::iota(_data.begin() + static_cast<std::ptrdiff_t>(begin),
+              _data.begin() + static_cast<std::ptrdiff_t>(end), begin);
+  });
+}
+
+truth_table::truth_table(const truth_table &other)
+    : _size(other._size), _mask(other._mask),
+      _data(other.length(), table_resource(other.length())) {
+  REVSYNTH_COUNT(table_copies, 1);
+  fill_rows(_data.size(), [this, &other](uint64_t begin, uint64_t end) {
+    std::copy(other._data.begin() + static_cast<std::ptrdiff_t>(begin),
+              other._data.begin() + static_cast<std::ptrdiff_t>(end),
+              _data.begin() + static_cast<std::ptrdiff_t>(begin));
+  });
+}
+
+auto truth_table::operator=(const truth_table &other) -> truth_table & {
+  REVSYNTH_COUNT(table_copies, 1);
+  _size = other._size;
+  _mask = other._mask;
+  _data = other._data;
+  return *this;
 }
 
 auto truth_table::size() const noexcept -> uint64_t { return _size; }
@@ -18,7 +60,9 @@ auto truth_table::length() const noexcept -> uint64_t { return _data.size(); }
 
 auto truth_table::mask() const noexcept -> uint64_t { return _mask; }
 
-auto truth_table::data() const noexcept -> const std::vector<uint64_t> & { return _data; }
+auto truth_table::data() const noexcept -> const table_rows & {
+  return _data;
+}
 
 auto truth_table::row(uint64_t index) const -> uint64_t {
   if (index > this->length()) {
@@ -41,7 +85,7 @@ auto truth_table::set_data(std::vector<uint64_t> new_data) -> truth_table & {
     throw std::invalid_argument(
         "Asignee data row elements have to be shorter than size of truth table");
   }
-  _data = std::move(new_data);
+  _data.assign(new_data.begin(), new_data.end());
   return *this;
 }
 
@@ -58,6 +102,11 @@ auto truth_table::shuffle(std::mt19937_64 &mrnd) -> truth_table & {
   return *this;
 }
 
+auto truth_table::shuffle(xoshiro256ss &rng, uint64_t threads) -> truth_table & {
+  parallel_shuffle(_data, rng, threads);
+  return *this;
+}
+
 auto truth_table::swap(uint64_t index_1, uint64_t index_2) noexcept(false) -> truth_table & {
   if (index_1 > this->length() || index_2 > this->length()) {
     throw std::invalid_argument(
@@ -68,12 +117,13 @@ auto truth_table::swap(uint64_t index_1, uint64_t index_2) noexcept(false) -> tr
 }
 
 auto truth_table::inverse() -> truth_table & {
-  auto new_data = std::vector<uint64_t>(length());
+  REVSYNTH_COUNT(tables_inverted, 1);
+  auto new_data = table_rows(length(), _data.get_allocator());
   for (auto input = 0UL; input < length(); input++) {
     auto output = _data[input];
     new_data[output] = input;
   }
-  set_data(new_data);
+  _data.swap(new_data);
   return *this;
 }
 
@@ -81,9 +131,9 @@ auto truth_table::next_permutation() -> bool {
   return std::next_permutation(_data.begin(), _data.end());
 }
 
-auto truth_table::begin() -> std::vector<uint64_t>::iterator { return _data.begin(); }
+auto truth_table::begin() -> table_rows::iterator { return _data.begin(); }
 
-auto truth_table::end() -> std::vector<uint64_t>::iterator { return _data.end(); }
+auto truth_table::end() -> table_rows::iterator { return _data.end(); }
 
 auto truth_table::operator[](uint64_t index) -> uint64_t & { return _data[index]; }
 
@@ -92,6 +142,7 @@ auto truth_table::operator[](uint64_t index) const -> uint64_t { return _data[in
 auto truth_table::operator+(const truth_table &rhs) const -> truth_table {
   assert(length() == rhs.length());
   assert(size() == rhs.size());
+  REVSYNTH_COUNT(tables_composed, 1);
   auto result = *this;
 
   for (auto input = 0UL; input < length(); input++) {
@@ -105,6 +156,7 @@ auto truth_table::operator+(const truth_table &rhs) const -> truth_table {
 auto truth_table::operator+=(const truth_table &rhs) -> truth_table & {
   assert(length() == rhs.length());
   assert(size() == rhs.size());
+  REVSYNTH_COUNT(tables_composed, 1);
   for (auto input = 0UL; input < length(); input++) {
     auto output = rhs[(*this)[input]];
     set_row(input, output);
@@ -1,4 +1,6 @@
 #pragma once
+#include "memory/memory.hpp"
+#include "random/random.hpp"
 #include "state/state.hpp"
 #include <cstdint>
 #include <random>
@@ -8,16 +10,23 @@ class truth_table {
 private:
   uint64_t _size;
   uint64_t _mask;
-  std::vector<uint64_t> _data;
+  table_rows _data;
 
 public:
+  // Rows live in the current_resource() of the constructing thread, copies take the current
+  // resource of the copying thread while moves keep the source storage. Large tables follow the
+  // table_policy, see memory.hpp.
   explicit truth_table(uint64_t bits_num);
+  truth_table(const truth_table &other);
+  truth_table(truth_table &&other) noexcept = default;
+  auto operator=(const truth_table &other) -> truth_table &;
+  auto operator=(truth_table &&other) noexcept -> truth_table & = default;
 
   [[nodiscard]] auto size() const noexcept -> uint64_t;
   [[nodiscard]] auto length() const noexcept -> uint64_t;
 
   [[nodiscard]] auto mask() const noexcept -> uint64_t;
-  [[nodiscard]] auto data() const noexcept -> const std::vector<uint64_t> &;
+  [[nodiscard]] auto data() const noexcept -> const table_rows &;
   [[nodiscard]] auto row(uint64_t index) const -> uint64_t;
   [[nodiscard]] auto state(uint64_t index) const -> state;
 
@@ -25,11 +34,13 @@ public:
   auto set_row(uint64_t index, uint64_t value) -> truth_table &;
   auto inverse() -> truth_table &;
   auto shuffle(std::mt19937_64 &mrnd) -> truth_table &;
+  // Same result for any threads, large tables are shuffled in parallel (see parallel_shuffle).
+  auto shuffle(xoshiro256ss &rng, uint64_t threads = 0) -> truth_table &;
   auto swap(uint64_t index_1, uint64_t index_2) noexcept(false) -> truth_table &;
   auto next_permutation() -> bool;
 
-  auto begin() -> std::vector<uint64_t>::iterator;
-  auto end() -> std::vector<uint64_t>::iterator;
+  auto begin() -> table_rows::iterator;
+  auto end() -> table_rows::iterator;
 
   auto operator[](uint64_t index) const -> uint64_t;
   auto operator[](uint64_t index) -> uint64_t &;
@@ -0,0 +1,36 @@
+#include "bench/bench.hpp"
+#include "truth_table.hpp"
+#include <random>
+
+namespace truth_table_bench {
+std::mt19937_64 mrnd;
+} // namespace truth_table_bench
+
+using namespace truth_table_bench;
+
+REVSYNTH_BENCH("truth_table/compose", 3, 24) {
+  auto bits = state.bits_num();
+  auto lhs = truth_table(bits).shuffle(mrnd);
+  auto rhs = truth_table(bits).shuffle(mrnd);
+  state.run(lhs.length(), [&]() { do_not_optimize(lhs + rhs); });
+}
+
+REVSYNTH_BENCH("truth_table/inverse", 3, 24) {
+  auto bits = state.bits_num();
+  auto tt = truth_table(bits).shuffle(mrnd);
+  state.run(tt.length(), [&]() {
+    tt.inverse();
+    do_not_optimize(tt);
+  });
+}
+
+REVSYNTH_BENCH("truth_table/construct", 3, 28) {
+  auto bits = state.bits_num();
+  state.run(1UL << bits, [&]() { do_not_optimize(truth_table(bits)); });
+}
+
+REVSYNTH_BENCH("truth_table/copy", 3, 28) {
+  auto bits = state.bits_num();
+  auto tt = truth_table(bits);
+  state.run(tt.length(), [&]() { do_not_optimize(truth_table(tt)); });
+}
@@ -1,14 +1,56 @@
 #include "utils.hpp"
+#include <stdexcept>
 
-auto random_unique_vector(uint64_t vector_size, uint64_t range_upper, std::mt19937_64 mrnd)
+auto random_unique_vector(uint64_t vector_size, uint64_t range_upper, std::mt19937_64 &mrnd)
     -> std::vector<uint64_t> {
+  return sample_unique(vector_size, range_upper, mrnd);
+}
+
+auto random_unique_vector(uint64_t vector_size, uint64_t range_upper, xoshiro256ss &rng)
+    -> std::vector<uint64_t> {
+  return sample_unique(vector_size, range_upper, rng);
+}
 
-  std::vector<uint64_t> numbers(range_upper);
-  std::iota(numbers.begin(), numbers.end(), 0);
-  std::shuffle(numbers.begin(), numbers.end(), mrnd);
-  std::vector<uint64_t> result(vector_size);
-  std::copy(numbers.begin(), numbers.begin() + static_cast<std::ptrdiff_t>(vector_size),
-            result.begin()); // Copy the first k numbers
+auto write_varint(std::vector<uint8_t> &buffer, uint64_t value) -> void {
+  while (value >= 0x80UL) {
+    buffer.push_back(static_cast<uint8_t>(value | 0x80UL));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<uint8_t>(value));
+}
+
+auto read_varint(const uint8_t *&position, const uint8_t *end) -> uint64_t {
+  auto value = 0UL;
+  for (auto shift = 0UL; shift < 64; shift += 7) {
+    if (position == end) {
+      throw std::out_of_range("Varint exceeds end of buffer");
+    }
+    auto byte = *position++;
+    value |= static_cast<uint64_t>(byte & 0x7FU) << shift;
+    if ((byte & 0x80U) == 0) {
+      return value;
+    }
+  }
+  throw std::invalid_argument("Varint is longer than 64 bits");
+}
 
-  return result;
+auto json_string(std::string_view text) -> std::string {
+  const auto hex = std::string_view("0123456789abcdef");
+  auto quoted = std::string("\"");
+  for (auto c : text) {
+    auto byte = static_cast<uint8_t>(c);
+    if (c == '"' || c == '\\') {
+      quoted.push_back('\\');
+      quoted.push_back(c);
+    }
+    else if (byte < 0x20) {
+      quoted.append("\\u00");
+      quoted.push_back(hex[byte >> 4]);
+      quoted.push_back(hex[byte & 0xFU]);
+    }
+    else {
+      quoted.push_back(c);
+    }
+  }
+  return quoted + "\"";
 }
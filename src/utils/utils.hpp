@@ -1,5 +1,20 @@
+#pragma once
+#include "random/random.hpp"
 #include <cstdint>
 #include <random>
+#include <string>
+#include <string_view>
+#include <vector>
 
-auto random_unique_vector(uint64_t vector_size, uint64_t range_upper, std::mt19937_64 mrnd)
+// vector_size distinct values below range_upper in random order, see sample_unique.
+auto random_unique_vector(uint64_t vector_size, uint64_t range_upper, std::mt19937_64 &mrnd)
     -> std::vector<uint64_t>;
+auto random_unique_vector(uint64_t vector_size, uint64_t range_upper, xoshiro256ss &rng)
+    -> std::vector<uint64_t>;
+
+auto write_varint(std::vector<uint8_t> &buffer, uint64_t value) -> void;
+// Decodes a varint at position and advances it. Throws if the buffer ends mid-value.
+auto read_varint(const uint8_t *&position, const uint8_t *end) -> uint64_t;
+
+// text as a quoted JSON string, with quotes, backslashes and control characters escaped.
+auto json_string(std::string_view text) -> std::string;
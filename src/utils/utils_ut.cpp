@@ -0,0 +1,12 @@
+#include "utils.hpp"
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("json strings", "[utils], [json]") {
+  REQUIRE(json_string("") == "\"\"");
+  REQUIRE(json_string("mmd03/beam") == "\"mmd03/beam\"");
+  REQUIRE(json_string("a \"b\" \\c") == "\"a \\\"b\\\" \\\\c\"");
+  REQUIRE(json_string(std::string_view("\n\t\x1f\0", 4)) == "\"\\u000a\\u0009\\u001f\\u0000\"");
+  REQUIRE(json_string("\x7f\xc3\xa9") == "\"\x7f\xc3\xa9\"");
+}